@@ -197,14 +197,19 @@ void vulkan_device::enumerate_devices()
   if (result != VK_SUCCESS && gpu_count <= 0)
     throw std::runtime_error("could not find any GPU devices");
 
+  physical_device = VK_NULL_HANDLE;
   for (const auto& device : physical_devices)
   {
     // change to "is_device_suitable - method
-    if (util::check_device_extension_support(device))
+    if (util::check_device_extension_support(device)
+        && util::check_timeline_semaphore_support(device))
     {
       physical_device = device;
     }
   }
+
+  if (physical_device == VK_NULL_HANDLE)
+    throw std::runtime_error("failed to find a suitable GPU!");
 }
 
 void vulkan_device::create_device()
@@ -289,7 +294,15 @@ void vulkan_device::create_device()
     queue_family_ids.transfer = queue_family_ids.graphics;
   }
 
+  // frame synchronization runs on timeline semaphores (core in 1.2)
+  VkPhysicalDeviceVulkan12Features vulkan12_features
+  { };
+  vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12_features.timelineSemaphore = VK_TRUE;
+
   VkDeviceCreateInfo device_info = initialisers::init_device_create_info();
+  device_info.pNext = &vulkan12_features;
   device_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos
       .size());
   ;
@@ -23,7 +23,7 @@ VkApplicationInfo init_application_info()
   application_info.applicationVersion = 1;
   application_info.pEngineName = "Tobi Vulkan Engine";
   application_info.engineVersion = 1;
-  application_info.apiVersion = VK_API_VERSION_1_1;
+  application_info.apiVersion = VK_API_VERSION_1_2;
 
   return application_info;
 }
@@ -125,6 +125,18 @@ VkSemaphoreCreateInfo init_semafore_create_info()
   return semaphore_info;
 }
 
+VkSemaphoreTypeCreateInfo init_timeline_semaphore_type_create_info(
+    uint64_t initial_value)
+{
+  VkSemaphoreTypeCreateInfo semaphore_type_info =
+  { };
+  semaphore_type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  semaphore_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  semaphore_type_info.initialValue = initial_value;
+
+  return semaphore_type_info;
+}
+
 }  // namespace initializers
 
 namespace util
@@ -160,6 +172,30 @@ bool check_device_extension_support(VkPhysicalDevice device)
   return required_extensions_set.empty();
 }
 
+bool check_timeline_semaphore_support(VkPhysicalDevice device)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device, &properties);
+
+  if (properties.apiVersion < VK_API_VERSION_1_2)
+  {
+    return false;
+  }
+
+  VkPhysicalDeviceVulkan12Features supported_vulkan12_features =
+  { };
+  supported_vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+  VkPhysicalDeviceFeatures2 features2 =
+  { };
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = &supported_vulkan12_features;
+  vkGetPhysicalDeviceFeatures2(device, &features2);
+
+  return supported_vulkan12_features.timelineSemaphore == VK_TRUE;
+}
+
 /**
  * Get the index of a queue family that supports the requested queue flags
  *
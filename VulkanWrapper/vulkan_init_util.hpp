@@ -37,6 +37,9 @@ VkPipelineVertexInputStateCreateInfo init_vertex_input_create_info();
 
 VkSemaphoreCreateInfo init_semafore_create_info();
 
+VkSemaphoreTypeCreateInfo init_timeline_semaphore_type_create_info(
+    uint64_t initial_value);
+
 }  // namespace initializers
 
 namespace util
@@ -48,6 +51,9 @@ std::vector<const char*> get_required_device_extensions();
 
 bool check_device_extension_support(VkPhysicalDevice device);
 
+// frame synchronization is built on timeline semaphores, core in 1.2
+bool check_timeline_semaphore_support(VkPhysicalDevice device);
+
 uint32_t get_queue_family_index(
     std::vector<VkQueueFamilyProperties> queue_family_properties,
     VkQueueFlagBits queue_flags);
@@ -0,0 +1,64 @@
+/*
+ * vulkan_push_constants.hpp
+ */
+
+#ifndef TOBIVULKAN_VULKANWRAPPER_VULKAN_PUSH_CONSTANTS_HPP_
+#define TOBIVULKAN_VULKANWRAPPER_VULKAN_PUSH_CONSTANTS_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <stdexcept>
+
+namespace tobivulkan
+{
+
+// every implementation supports at least this many bytes of push constants
+const uint32_t MIN_PUSH_CONSTANTS_SIZE = 128;
+
+/**
+ * A push constant block of type T at a fixed offset, for small per draw data
+ * that should not go through a mapped buffer.
+ *
+ * The size is checked against the guaranteed minimum at compile time and
+ * against the device limit when the range is created. T has to match the
+ * layout of the push_constant block in the shader.
+ */
+template<typename T, uint32_t OFFSET = 0>
+struct push_constants
+{
+  static_assert(sizeof(T) % 4 == 0,
+                "push constant blocks must be a multiple of 4 bytes");
+  static_assert(OFFSET % 4 == 0,
+                "push constant offsets must be a multiple of 4 bytes");
+  static_assert(OFFSET + sizeof(T) <= MIN_PUSH_CONSTANTS_SIZE,
+                "push constant block does not fit the guaranteed 128 bytes");
+
+  static VkPushConstantRange get_range(VkShaderStageFlags stages,
+                                       VkPhysicalDevice physical_device)
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    if (OFFSET + sizeof(T) > properties.limits.maxPushConstantsSize)
+    {
+      throw std::runtime_error(
+          "push constant block exceeds maxPushConstantsSize");
+    }
+
+    VkPushConstantRange range =
+    { };
+    range.stageFlags = stages;
+    range.offset = OFFSET;
+    range.size = static_cast<uint32_t>(sizeof(T));
+    return range;
+  }
+
+  static void push(VkCommandBuffer command_buffer, VkPipelineLayout layout,
+                   VkShaderStageFlags stages, const T& data)
+  {
+    vkCmdPushConstants(command_buffer, layout, stages, OFFSET,
+                       static_cast<uint32_t>(sizeof(T)), &data);
+  }
+};
+
+}  // namespace tobivulkan
+
+#endif /* TOBIVULKAN_VULKANWRAPPER_VULKAN_PUSH_CONSTANTS_HPP_ */
@@ -8,6 +8,7 @@
 #include "vulkan_shader_pipeline.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 #include "vulkan_init_util.hpp"
 
@@ -17,9 +18,13 @@ namespace tobivulkan
 vulkan_shader_pipeline::vulkan_shader_pipeline(
     std::shared_ptr<vulkan_device> device_instance,
     std::shared_ptr<vulkan_swap_chain> swap_chain,
-    std::vector<shader> shader_files)
+    std::vector<shader> shader_files,
+    std::vector<VkPushConstantRange> push_constant_ranges,
+    VkPrimitiveTopology topology)
     : device_instance(device_instance),
-      swap_chain(swap_chain)
+      swap_chain(swap_chain),
+      push_constant_ranges(push_constant_ranges),
+      topology(topology)
 {
 
   initialize(shader_files);
@@ -29,13 +34,16 @@ vulkan_shader_pipeline::vulkan_shader_pipeline(
 
 vulkan_shader_pipeline::~vulkan_shader_pipeline()
 {
+  // only the work this pipeline submitted has to finish, not the whole device.
+  // the swap chain is kept alive by us until after this.
+  wait_for_timeline(timeline_value);
+
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
   {
     vkDestroySemaphore(device_instance->get_device(),
                        render_finished_semaphores[i], nullptr);
-
-    vkDestroyFence(device_instance->get_device(), in_flight_fences[i], nullptr);
   }
+  vkDestroySemaphore(device_instance->get_device(), timeline, nullptr);
   vkFreeCommandBuffers(device_instance->get_device(), command_pool,
                        command_buffers.size(), command_buffers.data());
   vkDestroyCommandPool(device_instance->get_device(), command_pool, nullptr);
@@ -53,16 +61,38 @@ vulkan_shader_pipeline::~vulkan_shader_pipeline()
 
 void vulkan_shader_pipeline::draw_frame()
 {
-  vkWaitForFences(device_instance->get_device(), 1,
-                  &in_flight_fences[current_frame], VK_TRUE,
-                  std::numeric_limits<uint64_t>::max());
-  vkResetFences(device_instance->get_device(), 1,
-                &in_flight_fences[current_frame]);
+  wait_for_timeline(frame_timeline_values[current_frame]);
+
   uint32_t image_index = swap_chain->get_next_image_index(current_frame);
 
+  // a submit from another frame in flight may still use the image's buffer
+  if (command_buffers_dirty[image_index])
+  {
+    wait_for_timeline(image_timeline_values[image_index]);
+    record_command_buffer(image_index);
+    command_buffers_dirty[image_index] = false;
+  }
+
+  auto signal_value = ++timeline_value;
+
+  // binary semaphores ignore their value
+  uint64_t wait_values[] =
+  { 0 };
+  uint64_t signal_values[] =
+  { 0, signal_value };
+
+  VkTimelineSemaphoreSubmitInfo timeline_info =
+  { };
+  timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_info.waitSemaphoreValueCount = 1;
+  timeline_info.pWaitSemaphoreValues = wait_values;
+  timeline_info.signalSemaphoreValueCount = 2;
+  timeline_info.pSignalSemaphoreValues = signal_values;
+
   VkSubmitInfo submit_info =
   { };
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_info;
 
   VkSemaphore wait_semaphores[] =
   { swap_chain->get_image_available_semaphore(current_frame) };
@@ -77,15 +107,17 @@ void vulkan_shader_pipeline::draw_frame()
   submit_info.pCommandBuffers = &command_buffers[image_index];
 
   VkSemaphore signal_semaphores[] =
-  { render_finished_semaphores[current_frame] };
-  submit_info.signalSemaphoreCount = 1;
+  { render_finished_semaphores[current_frame], timeline };
+  submit_info.signalSemaphoreCount = 2;
   submit_info.pSignalSemaphores = signal_semaphores;
 
   if (vkQueueSubmit(device_instance->get_graphics_queue(), 1, &submit_info,
-                    in_flight_fences[current_frame]) != VK_SUCCESS)
+                    VK_NULL_HANDLE) != VK_SUCCESS)
   {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  frame_timeline_values[current_frame] = signal_value;
+  image_timeline_values[image_index] = signal_value;
 
   swap_chain->present_frame(render_finished_semaphores[current_frame],
                             image_index);
@@ -93,6 +125,22 @@ void vulkan_shader_pipeline::draw_frame()
   current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void vulkan_shader_pipeline::wait_for_timeline(uint64_t value)
+{
+  VkSemaphoreWaitInfo wait_info =
+  { };
+  wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &timeline;
+  wait_info.pValues = &value;
+
+  if (vkWaitSemaphores(device_instance->get_device(), &wait_info,
+                       std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to wait for timeline semaphore!");
+  }
+}
+
 void vulkan_shader_pipeline::initialize(std::vector<shader> shader_files)
 {
 std::vector<VkPipelineShaderStageCreateInfo> pipeline_shader_stage_create_infos;
@@ -198,29 +246,39 @@ create_frame_buffers();
 create_command_pool();
 create_command_buffers();
 
-record_command_buffers();
+for (size_t i = 0; i < command_buffers.size(); i++)
+{
+  record_command_buffer(i);
+}
+command_buffers_dirty.assign(command_buffers.size(), false);
+image_timeline_values.assign(command_buffers.size(), 0);
 
 auto semaphore_create_info = initialisers::init_semafore_create_info();
-VkFenceCreateInfo fence_info =
-{ };
-fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
 render_finished_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
-in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
+frame_timeline_values.assign(MAX_FRAMES_IN_FLIGHT, 0);
 
 for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 {
   if (vkCreateSemaphore(device_instance->get_device(), &semaphore_create_info,
-                        nullptr, &render_finished_semaphores[i]) != VK_SUCCESS
-      || vkCreateFence(device_instance->get_device(), &fence_info, nullptr,
-                       &in_flight_fences[i]) != VK_SUCCESS)
+                        nullptr, &render_finished_semaphores[i]) != VK_SUCCESS)
   {
 
     throw std::runtime_error("failed to create render semaphore!");
   }
 }
 
+auto timeline_type_info =
+    initialisers::init_timeline_semaphore_type_create_info(0);
+auto timeline_create_info = initialisers::init_semafore_create_info();
+timeline_create_info.pNext = &timeline_type_info;
+
+if (vkCreateSemaphore(device_instance->get_device(), &timeline_create_info,
+                      nullptr, &timeline) != VK_SUCCESS)
+{
+  throw std::runtime_error("failed to create timeline semaphore!");
+}
+
 std::cout << "ooo initialized vulkan_shader_pipeline" << std::endl;
 }
 
@@ -308,6 +366,13 @@ if (vkCreateRenderPass(device_instance->get_device(), &render_pass_create_info,
 
 void vulkan_shader_pipeline::create_pipeline_layout()
 {
+uint32_t push_constant_size = 0;
+for (const auto& range : push_constant_ranges)
+{
+  push_constant_size = std::max(push_constant_size, range.offset + range.size);
+}
+push_constant_data.resize(push_constant_size, 0);
+
 /*VkDynamicState dynamic_states[] =
  { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_LINE_WIDTH };
 
@@ -321,8 +386,10 @@ VkPipelineLayoutCreateInfo pipeline_layout_info =
 pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 pipeline_layout_info.setLayoutCount = 0;  // Optional
 pipeline_layout_info.pSetLayouts = nullptr;  // Optional
-pipeline_layout_info.pushConstantRangeCount = 0;  // Optional
-pipeline_layout_info.pPushConstantRanges = nullptr;  // Optional
+// small per draw data is pushed with the draw instead of bound in a buffer
+pipeline_layout_info.pushConstantRangeCount =
+    static_cast<uint32_t>(push_constant_ranges.size());
+pipeline_layout_info.pPushConstantRanges = push_constant_ranges.data();
 if (vkCreatePipelineLayout(device_instance->get_device(), &pipeline_layout_info,
                            nullptr, &pipeline_layout) != VK_SUCCESS)
 {
@@ -348,8 +415,14 @@ VkPipelineInputAssemblyStateCreateInfo input_assembly =
 { };
 input_assembly.sType =
     VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-input_assembly.primitiveRestartEnable = VK_FALSE;
+input_assembly.topology = topology;
+// restart is only allowed for strips and fans without extensions, and only
+// affects indexed draws
+input_assembly.primitiveRestartEnable =
+    topology == VK_PRIMITIVE_TOPOLOGY_LINE_STRIP
+        || topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP
+        || topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN ?
+        VK_TRUE : VK_FALSE;
 return input_assembly;
 }
 
@@ -448,7 +521,9 @@ VkCommandPoolCreateInfo pool_info =
 pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 pool_info.queueFamilyIndex = device_instance->get_queue_family_indices()
     .graphics;
-pool_info.flags = 0;  // Optional
+// set_push_constants records the command buffers again, which needs them
+// to be resettable one by one
+pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 if (vkCreateCommandPool(device_instance->get_device(), &pool_info, nullptr,
                         &command_pool) != VK_SUCCESS)
 {
@@ -473,48 +548,59 @@ if (vkAllocateCommandBuffers(device_instance->get_device(), &alloc_info,
 }
 }
 
-void vulkan_shader_pipeline::record_command_buffers()
+void vulkan_shader_pipeline::record_command_buffer(size_t image_index)
 {
-for (size_t i = 0; i < command_buffers.size(); i++)
+auto command_buffer = command_buffers[image_index];
+
+if (vkResetCommandBuffer(command_buffer, 0) != VK_SUCCESS)
 {
-  VkCommandBufferBeginInfo begin_info =
-  { };
-  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-  begin_info.pInheritanceInfo = nullptr;  // Optional
+  throw std::runtime_error("failed to reset command buffer!");
+}
 
-  if (vkBeginCommandBuffer(command_buffers[i], &begin_info) != VK_SUCCESS)
-  {
-    throw std::runtime_error("failed to begin recording command buffer!");
-  }
+VkCommandBufferBeginInfo begin_info =
+{ };
+begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+begin_info.pInheritanceInfo = nullptr;  // Optional
 
-  // render pass
-  VkRenderPassBeginInfo render_pass_begin_info =
-  { };
-  render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  render_pass_begin_info.renderPass = render_pass;
-  render_pass_begin_info.framebuffer = frame_buffers[i];
-  render_pass_begin_info.renderArea.offset =
-  { 0, 0};
-  render_pass_begin_info.renderArea.extent = swap_chain->get_extent();
-  VkClearValue clearColor =
-  { 0.0f, 0.0f, 0.0f, 1.0f };
-  render_pass_begin_info.clearValueCount = 1;
-  render_pass_begin_info.pClearValues = &clearColor;
-  vkCmdBeginRenderPass(command_buffers[i], &render_pass_begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
-
-  vkCmdBindPipeline(command_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    graphics_pipeline);
-
-  vkCmdDraw(command_buffers[i], 3, 1, 0, 0);
-
-  vkCmdEndRenderPass(command_buffers[i]);
-
-  if (vkEndCommandBuffer(command_buffers[i]) != VK_SUCCESS)
-  {
-    throw std::runtime_error("failed to record command buffer!");
-  }
+if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+{
+  throw std::runtime_error("failed to begin recording command buffer!");
+}
+
+// render pass
+VkRenderPassBeginInfo render_pass_begin_info =
+{ };
+render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+render_pass_begin_info.renderPass = render_pass;
+render_pass_begin_info.framebuffer = frame_buffers[image_index];
+render_pass_begin_info.renderArea.offset =
+{ 0, 0};
+render_pass_begin_info.renderArea.extent = swap_chain->get_extent();
+VkClearValue clearColor =
+{ 0.0f, 0.0f, 0.0f, 1.0f };
+render_pass_begin_info.clearValueCount = 1;
+render_pass_begin_info.pClearValues = &clearColor;
+vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info,
+                     VK_SUBPASS_CONTENTS_INLINE);
+
+vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                  graphics_pipeline);
+
+for (const auto& range : push_constant_ranges)
+{
+  vkCmdPushConstants(command_buffer, pipeline_layout, range.stageFlags,
+                     range.offset, range.size,
+                     push_constant_data.data() + range.offset);
+}
+
+vkCmdDraw(command_buffer, 3, 1, 0, 0);
+
+vkCmdEndRenderPass(command_buffer);
+
+if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+{
+  throw std::runtime_error("failed to record command buffer!");
 }
 }
 
@@ -9,11 +9,13 @@
 #define TOBIVULKAN_VULKANWRAPPER_VULKAN_SHADER_PIPELINE_HPP_
 
 #include <vector>
+#include <cstring>
 
 #include <vulkan/vulkan.hpp>
 
 #include "vulkan_device.hpp"
 #include "vulkan_swap_chain.hpp"
+#include "vulkan_push_constants.hpp"
 
 namespace tobivulkan
 {
@@ -29,7 +31,11 @@ class vulkan_shader_pipeline
  public:
   vulkan_shader_pipeline(std::shared_ptr<vulkan_device> device_instance,
                          std::shared_ptr<vulkan_swap_chain> swap_chain,
-                         std::vector<shader> shader_files);
+                         std::vector<shader> shader_files,
+                         std::vector<VkPushConstantRange> push_constant_ranges =
+                         { },
+                         VkPrimitiveTopology topology =
+                             VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
   vulkan_shader_pipeline(const vulkan_shader_pipeline& other) = delete;
 
@@ -42,25 +48,64 @@ class vulkan_shader_pipeline
   ~vulkan_shader_pipeline();
 
   void draw_frame();
+
+  /**
+   * Sets the push constant block at OFFSET that is pushed before the draw.
+   * The recorded command buffers are replayed every frame, so each one is
+   * recorded again when its image is next drawn, after waiting for the last
+   * submit that used it.
+   */
+  template<typename T, uint32_t OFFSET = 0>
+  void set_push_constants(const T& data)
+  {
+    // instantiating the block runs its size checks
+    static_assert(sizeof(push_constants<T, OFFSET>) > 0, "");
+
+    if (push_constant_data.size() < OFFSET + sizeof(T))
+    {
+      push_constant_data.resize(OFFSET + sizeof(T));
+    }
+    std::memcpy(push_constant_data.data() + OFFSET, &data, sizeof(T));
+
+    command_buffers_dirty.assign(command_buffers.size(), true);
+  }
  private:
 
+  auto wait_for_timeline(uint64_t value) -> void;
+
   std::shared_ptr<vulkan_device> device_instance;
   std::shared_ptr<vulkan_swap_chain> swap_chain;
 
+  std::vector<VkPushConstantRange> push_constant_ranges;
+  std::vector<uint8_t> push_constant_data;
+
+  // strip and fan topologies are assembled with primitive restart, an index
+  // of all ones starts a new strip
+  VkPrimitiveTopology topology;
+
   VkPipelineLayout pipeline_layout;
   VkPipeline graphics_pipeline;
   std::vector<VkFramebuffer> frame_buffers;
   VkRenderPass render_pass;
   VkCommandPool command_pool;
   std::vector<VkCommandBuffer> command_buffers;
-  std::vector<VkFence> in_flight_fences;
+  // command buffers recorded before the last push constant change
+  std::vector<bool> command_buffers_dirty;
   std::vector<VkSemaphore> render_finished_semaphores;
 
+  // signalled with a new value by every submit; frame_timeline_values holds
+  // the value the last submit of each frame in flight signals, and
+  // image_timeline_values the last submit of each swap chain image
+  VkSemaphore timeline;
+  uint64_t timeline_value = 0;
+  std::vector<uint64_t> frame_timeline_values;
+  std::vector<uint64_t> image_timeline_values;
+
   size_t current_frame = 0;
 
   auto initialize(std::vector<shader> shader_files) -> void;
 
-  auto record_command_buffers() -> void;
+  auto record_command_buffer(size_t image_index) -> void;
   auto create_shader_module(shader shader) -> VkShaderModule;
   auto create_render_pass() -> void;
   auto create_pipeline_layout() -> void;
@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lvulkan -lxcb -lglfw
+LIBS := -lvulkan -lxcb -lglfw -lpthread
 
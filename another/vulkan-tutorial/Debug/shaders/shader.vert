@@ -2,28 +2,57 @@
 
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+#include "vertex_decode.glsl"
+
+// set 0 changes every frame, set 1 with the camera
+layout(set = 0, binding = 0) uniform FrameUniforms {
+    float time;
+} frame;
+
+layout(set = 1, binding = 0) uniform ViewUniforms {
     mat4 view;
     mat4 proj;
-} ubo;
+} camera;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
+// per draw, pushed with the draw instead of living in a buffer. The
+// position scale and offset dequantize the mesh.
+layout(push_constant) uniform DrawConstants {
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uint textureIndex;
+    uint feedbackIndex;
+} draw;
+
+// the layout of MeshLayout in main.cpp
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec2 inNormal;
+// per instance, binding 1 advances once per instance
+layout(location = 4) in mat4 inModel;
+layout(location = 8) in uint inMaterial;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) flat out uint fragMaterial;
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragColor = inColor;
+    vec3 position = decodePosition(inPosition.xyz, draw.positionScale.xyz,
+                                   draw.positionOffset.xyz);
+    mat4 model = draw.model * inModel;
+    gl_Position = camera.proj * camera.view * model * vec4(position, 1.0);
+    fragColor = inColor.rgb;
     fragTexCoord = inTexCoord;
+    fragNormal = mat3(model) * decodeOctahedral(inNormal);
+    fragMaterial = inMaterial;
 }
 
 
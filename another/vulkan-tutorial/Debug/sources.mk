@@ -25,6 +25,8 @@ CPP_DEPS :=
 SUBDIRS := \
 src \
 src/util \
+src/assets \
+src/scene \
 src/vulkan_wrapper/validation \
 src/vulkan_wrapper \
 
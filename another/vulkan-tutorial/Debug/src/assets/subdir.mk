@@ -0,0 +1,51 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/assets/asset_pack.cpp \
+../src/assets/ktx2_texture.cpp \
+../src/assets/mesh_indices.cpp \
+../src/assets/mesh_loader.cpp \
+../src/assets/mesh_optimizer.cpp \
+../src/assets/mesh_simplifier.cpp \
+../src/assets/meshlet_builder.cpp \
+../src/assets/texture_atlas.cpp \
+../src/assets/texture_decoder.cpp \
+../src/assets/vertex_layout.cpp 
+
+OBJS += \
+./src/assets/asset_pack.o \
+./src/assets/ktx2_texture.o \
+./src/assets/mesh_indices.o \
+./src/assets/mesh_loader.o \
+./src/assets/mesh_optimizer.o \
+./src/assets/mesh_simplifier.o \
+./src/assets/meshlet_builder.o \
+./src/assets/texture_atlas.o \
+./src/assets/texture_decoder.o \
+./src/assets/vertex_layout.o 
+
+CPP_DEPS += \
+./src/assets/asset_pack.d \
+./src/assets/ktx2_texture.d \
+./src/assets/mesh_indices.d \
+./src/assets/mesh_loader.d \
+./src/assets/mesh_optimizer.d \
+./src/assets/mesh_simplifier.d \
+./src/assets/meshlet_builder.d \
+./src/assets/texture_atlas.d \
+./src/assets/texture_decoder.d \
+./src/assets/vertex_layout.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/assets/%.o: ../src/assets/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -std=c++0x -I/home/admin/workspace/libs/glm -I/home/admin/workspace/libs/stb -I/home/admin/workspace/libs/glfw/include -I/home/admin/Programming/VulkanSDK/1.1.77.0/x86_64/include -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -4,13 +4,34 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/util/file_handler.cpp 
+../src/util/async_reader.cpp \
+../src/util/file_handler.cpp \
+../src/util/json.cpp \
+../src/util/mapped_file.cpp \
+../src/util/mip_chain.cpp \
+../src/util/page_allocator.cpp \
+../src/util/quantization.cpp \
+../src/util/skyline_packer.cpp 
 
 OBJS += \
-./src/util/file_handler.o 
+./src/util/async_reader.o \
+./src/util/file_handler.o \
+./src/util/json.o \
+./src/util/mapped_file.o \
+./src/util/mip_chain.o \
+./src/util/page_allocator.o \
+./src/util/quantization.o \
+./src/util/skyline_packer.o 
 
 CPP_DEPS += \
-./src/util/file_handler.d 
+./src/util/async_reader.d \
+./src/util/file_handler.d \
+./src/util/json.d \
+./src/util/mapped_file.d \
+./src/util/mip_chain.d \
+./src/util/page_allocator.d \
+./src/util/quantization.d \
+./src/util/skyline_packer.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
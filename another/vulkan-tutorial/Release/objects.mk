@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lxcb -lvulkan -lglfw
+LIBS := -lxcb -lvulkan -lglfw -lpthread
 
@@ -0,0 +1,23 @@
+// small textures packed by assets::texture_atlas, included with
+// GL_GOOGLE_include_directive. Set 0 holds the array texture and where each
+// packed texture is in it, selected by the instance's material.
+struct AtlasRegion {
+    vec2 scale;
+    vec2 offset;
+    uint layer;
+};
+
+layout(set = 0, binding = 1) uniform sampler2DArray atlas;
+
+layout(std430, set = 0, binding = 2) readonly buffer AtlasRegions {
+    AtlasRegion regions[];
+} atlasRegions;
+
+// the texture repeats within its region. The derivatives are taken before
+// the wrap, so the level does not jump at the seams.
+vec4 sampleAtlas(uint material, vec2 uv) {
+    AtlasRegion region = atlasRegions.regions[material];
+    vec2 atlasUv = fract(uv) * region.scale + region.offset;
+    return textureGrad(atlas, vec3(atlasUv, float(region.layer)),
+                       dFdx(uv) * region.scale, dFdy(uv) * region.scale);
+}
@@ -0,0 +1,17 @@
+// decoding of the quantized vertex formats in assets/vertex_layout.hpp,
+// included with GL_GOOGLE_include_directive
+
+// position_float and position_unorm16 store positions relative to the mesh
+// bounds, the scale and offset come with the draw
+vec3 decodePosition(vec3 stored, vec3 scale, vec3 offset) {
+    return stored * scale + offset;
+}
+
+// normal_oct16, the inverse of util::quantization::encode_octahedral
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
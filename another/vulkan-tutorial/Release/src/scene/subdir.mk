@@ -0,0 +1,36 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/scene/bounds_soa.cpp \
+../src/scene/frustum.cpp \
+../src/scene/frustum_culling.cpp \
+../src/scene/lod_selection.cpp \
+../src/scene/transform_hierarchy.cpp 
+
+OBJS += \
+./src/scene/bounds_soa.o \
+./src/scene/frustum.o \
+./src/scene/frustum_culling.o \
+./src/scene/lod_selection.o \
+./src/scene/transform_hierarchy.o 
+
+CPP_DEPS += \
+./src/scene/bounds_soa.d \
+./src/scene/frustum.d \
+./src/scene/frustum_culling.d \
+./src/scene/lod_selection.d \
+./src/scene/transform_hierarchy.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/scene/%.o: ../src/scene/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -std=c++1y -DNDEBUG=1 -I/home/admin/workspace/libs/glfw/include -I/home/admin/workspace/libs/stb -I/home/admin/workspace/libs/glm -I/home/admin/Programming/VulkanSDK/1.1.77.0/x86_64/include -O3 -pedantic -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
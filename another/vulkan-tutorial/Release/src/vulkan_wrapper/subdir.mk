@@ -4,33 +4,72 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/vulkan_wrapper/vulkan_bindless_descriptors.cpp \
+../src/vulkan_wrapper/vulkan_cluster_culling.cpp \
+../src/vulkan_wrapper/vulkan_deletion_queue.cpp \
+../src/vulkan_wrapper/vulkan_descriptor_allocator.cpp \
 ../src/vulkan_wrapper/vulkan_device.cpp \
 ../src/vulkan_wrapper/vulkan_framebuffers.cpp \
+../src/vulkan_wrapper/vulkan_geometry_residency.cpp \
+../src/vulkan_wrapper/vulkan_gpu_culling.cpp \
+../src/vulkan_wrapper/vulkan_hiz_pyramid.cpp \
+../src/vulkan_wrapper/vulkan_image_view_cache.cpp \
+../src/vulkan_wrapper/vulkan_indirect_draws.cpp \
 ../src/vulkan_wrapper/vulkan_instance.cpp \
+../src/vulkan_wrapper/vulkan_instance_stream.cpp \
 ../src/vulkan_wrapper/vulkan_physical_device.cpp \
 ../src/vulkan_wrapper/vulkan_render_pass.cpp \
+../src/vulkan_wrapper/vulkan_sampler_cache.cpp \
 ../src/vulkan_wrapper/vulkan_surface.cpp \
 ../src/vulkan_wrapper/vulkan_swap_chain.cpp \
+../src/vulkan_wrapper/vulkan_texture_residency.cpp \
+../src/vulkan_wrapper/vulkan_timeline.cpp \
 ../src/vulkan_wrapper/window_handler.cpp 
 
 OBJS += \
+./src/vulkan_wrapper/vulkan_bindless_descriptors.o \
+./src/vulkan_wrapper/vulkan_cluster_culling.o \
+./src/vulkan_wrapper/vulkan_deletion_queue.o \
+./src/vulkan_wrapper/vulkan_descriptor_allocator.o \
 ./src/vulkan_wrapper/vulkan_device.o \
 ./src/vulkan_wrapper/vulkan_framebuffers.o \
+./src/vulkan_wrapper/vulkan_geometry_residency.o \
+./src/vulkan_wrapper/vulkan_gpu_culling.o \
+./src/vulkan_wrapper/vulkan_hiz_pyramid.o \
+./src/vulkan_wrapper/vulkan_image_view_cache.o \
+./src/vulkan_wrapper/vulkan_indirect_draws.o \
 ./src/vulkan_wrapper/vulkan_instance.o \
+./src/vulkan_wrapper/vulkan_instance_stream.o \
 ./src/vulkan_wrapper/vulkan_physical_device.o \
 ./src/vulkan_wrapper/vulkan_render_pass.o \
+./src/vulkan_wrapper/vulkan_sampler_cache.o \
 ./src/vulkan_wrapper/vulkan_surface.o \
 ./src/vulkan_wrapper/vulkan_swap_chain.o \
+./src/vulkan_wrapper/vulkan_texture_residency.o \
+./src/vulkan_wrapper/vulkan_timeline.o \
 ./src/vulkan_wrapper/window_handler.o 
 
 CPP_DEPS += \
+./src/vulkan_wrapper/vulkan_bindless_descriptors.d \
+./src/vulkan_wrapper/vulkan_cluster_culling.d \
+./src/vulkan_wrapper/vulkan_deletion_queue.d \
+./src/vulkan_wrapper/vulkan_descriptor_allocator.d \
 ./src/vulkan_wrapper/vulkan_device.d \
 ./src/vulkan_wrapper/vulkan_framebuffers.d \
+./src/vulkan_wrapper/vulkan_geometry_residency.d \
+./src/vulkan_wrapper/vulkan_gpu_culling.d \
+./src/vulkan_wrapper/vulkan_hiz_pyramid.d \
+./src/vulkan_wrapper/vulkan_image_view_cache.d \
+./src/vulkan_wrapper/vulkan_indirect_draws.d \
 ./src/vulkan_wrapper/vulkan_instance.d \
+./src/vulkan_wrapper/vulkan_instance_stream.d \
 ./src/vulkan_wrapper/vulkan_physical_device.d \
 ./src/vulkan_wrapper/vulkan_render_pass.d \
+./src/vulkan_wrapper/vulkan_sampler_cache.d \
 ./src/vulkan_wrapper/vulkan_surface.d \
 ./src/vulkan_wrapper/vulkan_swap_chain.d \
+./src/vulkan_wrapper/vulkan_texture_residency.d \
+./src/vulkan_wrapper/vulkan_timeline.d \
 ./src/vulkan_wrapper/window_handler.d 
 
 
@@ -0,0 +1,125 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+/// Frustum culling microbenchmark, objects culled per nanosecond for every
+/// kernel the CPU supports. Not part of the Eclipse build, from this
+/// directory, as one line:
+///
+///   g++ -std=c++11 -O3 -I../src -I<glm> frustum_culling_bench.cpp
+///       ../src/scene/frustum.cpp ../src/scene/frustum_culling.cpp
+///       ../src/scene/bounds_soa.cpp -o frustum_culling_bench
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "scene/frustum_culling.hpp"
+
+using namespace tobi_engine::scene;
+
+namespace
+{
+
+const char *get_name(simd_level level)
+{
+  switch (level)
+  {
+    case simd_level::avx2:
+      return "avx2";
+    case simd_level::sse2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+
+void run(const frustum &frustum, const bounds_soa &bounds, simd_level level)
+{
+  std::vector<uint32_t> visible(bounds.padded_size());
+
+  // enough repetitions for ~100M sphere tests
+  const size_t repetitions = std::max<size_t>(100000000 / bounds.size(), 1);
+
+  uint32_t count = cull_spheres(frustum, bounds, visible.data(), level);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < repetitions; i++)
+  {
+    count = cull_spheres(frustum, bounds, visible.data(), level);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  double nanoseconds = std::chrono::duration<double, std::nano>(end - start)
+      .count();
+  double objects = static_cast<double>(bounds.size()) * repetitions;
+
+  std::cout << "  " << get_name(level) << ": " << objects / nanoseconds
+            << " objects/ns, " << count << " visible" << std::endl;
+}
+
+}  // namespace
+
+int main()
+{
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f,
+                                          0.1f, 500.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f),
+                               glm::vec3(1.0f, 0.0f, 0.0f),
+                               glm::vec3(0.0f, 0.0f, 1.0f));
+  auto frustum = extract_frustum(projection * view);
+
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+  std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+  std::cout << "best kernel: " << get_name(get_simd_level()) << std::endl;
+
+  for (size_t num_objects : { 1000, 100000, 1000000 })
+  {
+    bounds_soa bounds;
+    bounds.reserve(num_objects);
+    for (size_t i = 0; i < num_objects; i++)
+    {
+      bounds.add(position(generator), position(generator), position(generator),
+                 radius(generator));
+    }
+
+    std::cout << num_objects << " objects" << std::endl;
+    for (auto level : { simd_level::scalar, simd_level::sse2,
+        simd_level::avx2 })
+    {
+      if (static_cast<int>(level) <= static_cast<int>(get_simd_level()))
+      {
+        run(frustum, bounds, level);
+      }
+    }
+  }
+
+  return 0;
+}
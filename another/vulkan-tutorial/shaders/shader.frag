@@ -1,13 +1,29 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+#include "texture_atlas.glsl"
+#include "texture_feedback.glsl"
+
+// set 2 holds the material
+layout(set = 2, binding = 0) uniform sampler2D texSampler;
+
+layout(push_constant) uniform DrawConstants {
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uint textureIndex;
+    uint feedbackIndex;
+} draw;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 3) flat in uint fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    writeTextureFeedback(draw.feedbackIndex, fragTexCoord);
+    outColor = texture(texSampler, fragTexCoord)
+        * sampleAtlas(fragMaterial, fragTexCoord);
 }
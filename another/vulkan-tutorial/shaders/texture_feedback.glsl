@@ -0,0 +1,23 @@
+// texture streaming feedback for vulkan_texture_residency, included with
+// GL_GOOGLE_include_directive. Set 1 holds the view's feedback region: per
+// streamed texture the finest resolution sampled, log2 of texels across the
+// texture for one texel per pixel, plus one.
+layout(std430, set = 1, binding = 1) buffer TextureFeedback {
+    uint resolutions[];
+} feedback;
+
+// every pixel computes the resolution, so the derivatives stay in uniform
+// control flow, but only one in 8x8 writes it to keep the atomics few
+void writeTextureFeedback(uint index, vec2 uv) {
+    vec2 dx = dFdx(uv);
+    vec2 dy = dFdy(uv);
+    // the longer axis of the footprint, as isotropic filtering picks levels
+    float footprint = max(dot(dx, dx), dot(dy, dy));
+    float resolution = -0.5 * log2(max(footprint, 1e-18));
+    uint value = uint(clamp(ceil(resolution), 0.0, 30.0)) + 1;
+
+    if (all(equal(ivec2(gl_FragCoord.xy) & 7, ivec2(0)))
+        && value > feedback.resolutions[index]) {
+        atomicMax(feedback.resolutions[index], value);
+    }
+}
@@ -0,0 +1,205 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "asset_pack.hpp"
+#include "../util/file_handler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+const char PACK_MAGIC[4] = { 'T', 'P', 'A', 'K' };
+const uint32_t PACK_VERSION = 1;
+
+struct pack_header
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t alignment;
+  uint64_t index_offset;
+  uint64_t names_offset;
+};
+
+static_assert(sizeof(pack_header) == 32, "pack header must be packed");
+static_assert(sizeof(asset_entry) == 24, "asset entry must be packed");
+
+uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+asset_pack::asset_pack(std::string file_name)
+    : file(file_name),
+      entries(nullptr),
+      num_entries(0),
+      names(nullptr)
+{
+  initialize();
+}
+
+void asset_pack::initialize()
+{
+  auto data = file.get_data();
+  auto size = file.get_size();
+
+  pack_header header;
+  if (size < sizeof(header))
+  {
+    throw std::runtime_error("asset pack is truncated!");
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0
+      || header.version != PACK_VERSION)
+  {
+    throw std::runtime_error("not an asset pack of a supported version!");
+  }
+
+  if (header.index_offset % alignof(asset_entry) != 0
+      || header.index_offset > size
+      || header.num_entries > (size - header.index_offset)
+          / sizeof(asset_entry)
+      || header.names_offset > size)
+  {
+    throw std::runtime_error("asset pack index is out of bounds!");
+  }
+
+  entries = reinterpret_cast<const asset_entry *>(data + header.index_offset);
+  num_entries = header.num_entries;
+  names = reinterpret_cast<const char *>(data + header.names_offset);
+
+  auto names_size = size - header.names_offset;
+  for (uint32_t i = 0; i < num_entries; i++)
+  {
+    const auto &entry = entries[i];
+    if (entry.name_offset > names_size
+        || entry.name_size > names_size - entry.name_offset
+        || entry.offset > size || entry.size > size - entry.offset)
+    {
+      throw std::runtime_error("asset pack entry is out of bounds!");
+    }
+  }
+}
+
+const asset_entry *asset_pack::find(const std::string &name) const
+{
+  auto end = entries + num_entries;
+  auto entry = std::lower_bound(
+      entries, end, name,
+      [this](const asset_entry &entry, const std::string &name)
+      {
+        return name.compare(0, std::string::npos, names + entry.name_offset,
+                            entry.name_size) > 0;
+      });
+
+  if (entry == end
+      || name.compare(0, std::string::npos, names + entry->name_offset,
+                      entry->name_size) != 0)
+  {
+    return nullptr;
+  }
+  return entry;
+}
+
+void asset_pack::build(const std::string &file_name,
+                       std::vector<std::string> files, uint32_t alignment)
+{
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+  {
+    throw std::runtime_error("asset pack alignment must be a power of two!");
+  }
+
+  // lookups binary search the index, so it is sorted by name
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  pack_header header;
+  std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+  header.version = PACK_VERSION;
+  header.num_entries = static_cast<uint32_t>(files.size());
+  header.alignment = alignment;
+  header.index_offset = sizeof(header);
+  header.names_offset = header.index_offset
+      + files.size() * sizeof(asset_entry);
+
+  std::vector<std::vector<char>> contents;
+  std::vector<asset_entry> index(files.size());
+  std::string names;
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (!std::ifstream(files[i]).good())
+    {
+      throw std::runtime_error("failed to open " + files[i]);
+    }
+    contents.push_back(util::file_handler::read_binary_file(files[i]));
+    index[i].size = contents.back().size();
+    index[i].name_offset = static_cast<uint32_t>(names.size());
+    index[i].name_size = static_cast<uint32_t>(files[i].size());
+    names += files[i];
+  }
+
+  auto offset = align_up(header.names_offset + names.size(), alignment);
+  for (auto &entry : index)
+  {
+    entry.offset = offset;
+    offset = align_up(offset + entry.size, alignment);
+  }
+
+  std::ofstream stream(file_name, std::ios::binary | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("failed to create " + file_name);
+  }
+
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  stream.write(reinterpret_cast<const char *>(index.data()),
+               index.size() * sizeof(asset_entry));
+  stream.write(names.data(), names.size());
+
+  for (size_t i = 0; i < index.size(); i++)
+  {
+    auto position = static_cast<uint64_t>(stream.tellp());
+    std::vector<char> padding(index[i].offset - position, 0);
+    stream.write(padding.data(), padding.size());
+    stream.write(contents[i].data(), contents[i].size());
+  }
+
+  if (!stream.good())
+  {
+    throw std::runtime_error("failed to write " + file_name);
+  }
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
@@ -0,0 +1,99 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_ASSET_PACK_HPP_
+#define ASSETS_ASSET_PACK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../util/mapped_file.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Index record of one asset. Offsets are from the start of the pack.
+struct asset_entry
+{
+  uint64_t offset;
+  uint64_t size;
+  uint32_t name_offset;
+  uint32_t name_size;
+};
+
+/// Read only archive of shaders, meshes and textures. The whole pack is
+/// mapped once, lookups binary search the name sorted index in place and
+/// hand out pointers into the mapping, so loading an asset neither opens a
+/// file nor allocates.
+///
+/// Layout: a 32 byte header, the index, the names, then the asset data with
+/// every asset starting on an alignment boundary.
+class asset_pack
+{
+ public:
+  /// Page aligned, so assets can also be read with O_DIRECT
+  static const uint32_t DEFAULT_ALIGNMENT = 4096;
+
+  explicit asset_pack(std::string file_name);
+  ~asset_pack() = default;
+  asset_pack(asset_pack &&) = delete;
+  asset_pack(const asset_pack &) = delete;
+  asset_pack &operator=(const asset_pack &) = delete;
+  asset_pack &operator=(asset_pack &&) = delete;
+
+  /// Writes a pack holding files, each named by its path as given.
+  static void build(const std::string &file_name,
+                    std::vector<std::string> files,
+                    uint32_t alignment = DEFAULT_ALIGNMENT);
+
+  /// return nullptr if the pack has no asset called name
+  const asset_entry *find(const std::string &name) const;
+
+  const uint8_t *get_data(const asset_entry &entry) const
+  {
+    return file.get_data() + entry.offset;
+  }
+
+  uint32_t get_num_entries() const
+  {
+    return num_entries;
+  }
+
+ private:
+  void initialize();
+
+  util::mapped_file file;
+
+  const asset_entry *entries;
+  uint32_t num_entries;
+  const char *names;
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_ASSET_PACK_HPP_
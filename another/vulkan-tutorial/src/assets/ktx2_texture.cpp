@@ -0,0 +1,477 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "ktx2_texture.hpp"
+#include "../util/file_handler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+const uint8_t KTX2_IDENTIFIER[12] =
+{
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+const size_t HEADER_SIZE = 80;
+const size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+/// Texel block dimensions and byte size of a format
+struct block_info
+{
+  VkFormat format;
+  uint32_t block_width;
+  uint32_t block_height;
+  uint32_t block_size;
+  bool srgb;
+};
+
+const block_info BLOCK_INFOS[] =
+{
+  { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4, false },
+  { VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4, true },
+  { VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 4, 8, true },
+  { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8, true },
+  { VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC2_SRGB_BLOCK, 4, 4, 16, true },
+  { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16, true },
+  { VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_BC4_SNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC5_SNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC6H_UFLOAT_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC6H_SFLOAT_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16, true },
+  { VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, 4, 4, 8, true },
+  { VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, 4, 4, 8, true },
+  { VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 4, 4, 16, true },
+  { VK_FORMAT_EAC_R11_UNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_EAC_R11_SNORM_BLOCK, 4, 4, 8, false },
+  { VK_FORMAT_EAC_R11G11_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_ASTC_4x4_UNORM_BLOCK, 4, 4, 16, false },
+  { VK_FORMAT_ASTC_4x4_SRGB_BLOCK, 4, 4, 16, true },
+  { VK_FORMAT_ASTC_5x4_UNORM_BLOCK, 5, 4, 16, false },
+  { VK_FORMAT_ASTC_5x4_SRGB_BLOCK, 5, 4, 16, true },
+  { VK_FORMAT_ASTC_5x5_UNORM_BLOCK, 5, 5, 16, false },
+  { VK_FORMAT_ASTC_5x5_SRGB_BLOCK, 5, 5, 16, true },
+  { VK_FORMAT_ASTC_6x5_UNORM_BLOCK, 6, 5, 16, false },
+  { VK_FORMAT_ASTC_6x5_SRGB_BLOCK, 6, 5, 16, true },
+  { VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 6, 6, 16, false },
+  { VK_FORMAT_ASTC_6x6_SRGB_BLOCK, 6, 6, 16, true },
+  { VK_FORMAT_ASTC_8x5_UNORM_BLOCK, 8, 5, 16, false },
+  { VK_FORMAT_ASTC_8x5_SRGB_BLOCK, 8, 5, 16, true },
+  { VK_FORMAT_ASTC_8x6_UNORM_BLOCK, 8, 6, 16, false },
+  { VK_FORMAT_ASTC_8x6_SRGB_BLOCK, 8, 6, 16, true },
+  { VK_FORMAT_ASTC_8x8_UNORM_BLOCK, 8, 8, 16, false },
+  { VK_FORMAT_ASTC_8x8_SRGB_BLOCK, 8, 8, 16, true },
+  { VK_FORMAT_ASTC_10x5_UNORM_BLOCK, 10, 5, 16, false },
+  { VK_FORMAT_ASTC_10x5_SRGB_BLOCK, 10, 5, 16, true },
+  { VK_FORMAT_ASTC_10x6_UNORM_BLOCK, 10, 6, 16, false },
+  { VK_FORMAT_ASTC_10x6_SRGB_BLOCK, 10, 6, 16, true },
+  { VK_FORMAT_ASTC_10x8_UNORM_BLOCK, 10, 8, 16, false },
+  { VK_FORMAT_ASTC_10x8_SRGB_BLOCK, 10, 8, 16, true },
+  { VK_FORMAT_ASTC_10x10_UNORM_BLOCK, 10, 10, 16, false },
+  { VK_FORMAT_ASTC_10x10_SRGB_BLOCK, 10, 10, 16, true },
+  { VK_FORMAT_ASTC_12x10_UNORM_BLOCK, 12, 10, 16, false },
+  { VK_FORMAT_ASTC_12x10_SRGB_BLOCK, 12, 10, 16, true },
+  { VK_FORMAT_ASTC_12x12_UNORM_BLOCK, 12, 12, 16, false },
+  { VK_FORMAT_ASTC_12x12_SRGB_BLOCK, 12, 12, 16, true }
+};
+
+const block_info *find_block_info(VkFormat format)
+{
+  for (const auto &info : BLOCK_INFOS)
+  {
+    if (info.format == format)
+    {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+size_t get_level_size(const block_info &info, uint32_t width, uint32_t height)
+{
+  size_t blocks_x = (width + info.block_width - 1) / info.block_width;
+  size_t blocks_y = (height + info.block_height - 1) / info.block_height;
+  return blocks_x * blocks_y * info.block_size;
+}
+
+uint32_t read_u32(const uint8_t *data, size_t offset)
+{
+  uint32_t value;
+  std::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+uint64_t read_u64(const uint8_t *data, size_t offset)
+{
+  uint64_t value;
+  std::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+/// Expands the two RGB565 endpoints of a BC1 colour block into its palette
+void decode_bc1_palette(const uint8_t *block, bool four_colors,
+                        bool punch_through_alpha, uint8_t palette[4][4])
+{
+  uint16_t colors[2];
+  std::memcpy(colors, block, sizeof(colors));
+
+  for (int i = 0; i < 2; i++)
+  {
+    uint32_t r = (colors[i] >> 11) & 0x1F;
+    uint32_t g = (colors[i] >> 5) & 0x3F;
+    uint32_t b = colors[i] & 0x1F;
+    palette[i][0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+    palette[i][1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+    palette[i][2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+    palette[i][3] = 255;
+  }
+
+  if (four_colors || colors[0] > colors[1])
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      palette[2][c] = static_cast<uint8_t>(
+          (2 * palette[0][c] + palette[1][c]) / 3);
+      palette[3][c] = static_cast<uint8_t>(
+          (palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+    palette[2][3] = 255;
+    palette[3][3] = 255;
+  } else
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      palette[2][c] = static_cast<uint8_t>(
+          (palette[0][c] + palette[1][c]) / 2);
+      palette[3][c] = 0;
+    }
+    palette[2][3] = 255;
+    palette[3][3] = punch_through_alpha ? 0 : 255;
+  }
+}
+
+/// Decodes the 4x4 texels of a BC1 colour block, row by row
+void decode_bc1_block(const uint8_t *block, bool four_colors,
+                      bool punch_through_alpha, uint8_t texels[16][4])
+{
+  uint8_t palette[4][4];
+  decode_bc1_palette(block, four_colors, punch_through_alpha, palette);
+
+  uint32_t indices;
+  std::memcpy(&indices, block + 4, sizeof(indices));
+  for (int i = 0; i < 16; i++)
+  {
+    std::memcpy(texels[i], palette[(indices >> (2 * i)) & 3], 4);
+  }
+}
+
+/// Replaces the alpha of 4x4 texels with a BC3 alpha block
+void decode_bc3_alpha(const uint8_t *block, uint8_t texels[16][4])
+{
+  uint8_t alpha[8];
+  alpha[0] = block[0];
+  alpha[1] = block[1];
+  if (alpha[0] > alpha[1])
+  {
+    for (int i = 1; i < 7; i++)
+    {
+      alpha[i + 1] = static_cast<uint8_t>(
+          ((7 - i) * alpha[0] + i * alpha[1]) / 7);
+    }
+  } else
+  {
+    for (int i = 1; i < 5; i++)
+    {
+      alpha[i + 1] = static_cast<uint8_t>(
+          ((5 - i) * alpha[0] + i * alpha[1]) / 5);
+    }
+    alpha[6] = 0;
+    alpha[7] = 255;
+  }
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; i++)
+  {
+    indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+  }
+  for (int i = 0; i < 16; i++)
+  {
+    texels[i][3] = alpha[(indices >> (3 * i)) & 7];
+  }
+}
+
+}  // namespace
+
+ktx2_texture::ktx2_texture(std::string file_name)
+    : file_data(util::file_handler::read_binary_file(file_name)),
+      data(reinterpret_cast<const uint8_t *>(file_data.data())),
+      size(file_data.size()),
+      format(VK_FORMAT_UNDEFINED),
+      width(0),
+      height(0)
+{
+  initialize();
+}
+
+ktx2_texture::ktx2_texture(std::vector<char> file_data)
+    : file_data(std::move(file_data)),
+      data(reinterpret_cast<const uint8_t *>(this->file_data.data())),
+      size(this->file_data.size()),
+      format(VK_FORMAT_UNDEFINED),
+      width(0),
+      height(0)
+{
+  initialize();
+}
+
+ktx2_texture::ktx2_texture(const uint8_t *data, size_t size)
+    : data(data),
+      size(size),
+      format(VK_FORMAT_UNDEFINED),
+      width(0),
+      height(0)
+{
+  initialize();
+}
+
+void ktx2_texture::initialize()
+{
+  if (size < HEADER_SIZE
+      || std::memcmp(data, KTX2_IDENTIFIER,
+                     sizeof(KTX2_IDENTIFIER)) != 0)
+  {
+    throw std::runtime_error("not a KTX2 file!");
+  }
+
+  format = static_cast<VkFormat>(read_u32(data, 12));
+  width = read_u32(data, 20);
+  height = read_u32(data, 24);
+  auto depth = read_u32(data, 28);
+  auto layer_count = read_u32(data, 32);
+  auto face_count = read_u32(data, 36);
+  auto level_count = std::max(read_u32(data, 40), 1u);
+  auto supercompression_scheme = read_u32(data, 44);
+
+  if (supercompression_scheme != 0)
+  {
+    throw std::runtime_error("supercompressed KTX2 files are not supported!");
+  }
+  if (depth > 1 || layer_count > 1 || face_count != 1 || width == 0
+      || height == 0)
+  {
+    throw std::runtime_error("only 2D KTX2 textures are supported!");
+  }
+
+  auto info = find_block_info(format);
+  if (!info)
+  {
+    throw std::runtime_error("unsupported KTX2 texture format!");
+  }
+
+  if (size < HEADER_SIZE + level_count * LEVEL_INDEX_ENTRY_SIZE)
+  {
+    throw std::runtime_error("truncated KTX2 level index!");
+  }
+
+  levels.resize(level_count);
+  for (uint32_t i = 0; i < level_count; i++)
+  {
+    auto entry = HEADER_SIZE + i * LEVEL_INDEX_ENTRY_SIZE;
+    auto byte_offset = read_u64(data, entry);
+    auto byte_length = read_u64(data, entry + 8);
+
+    auto &level = levels[i];
+    level.width = std::max(width >> i, 1u);
+    level.height = std::max(height >> i, 1u);
+    level.offset = static_cast<size_t>(byte_offset);
+    level.size = get_level_size(*info, level.width, level.height);
+
+    if (byte_length < level.size || byte_offset > size
+        || level.size > size - byte_offset)
+    {
+      throw std::runtime_error("KTX2 mip level is out of bounds!");
+    }
+  }
+}
+
+compression_family ktx2_texture::get_family(VkFormat format)
+{
+  if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK
+      && format <= VK_FORMAT_BC7_SRGB_BLOCK)
+  {
+    return compression_family::bc;
+  }
+  if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+      && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK)
+  {
+    return compression_family::etc2;
+  }
+  if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+      && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+  {
+    return compression_family::astc;
+  }
+  return compression_family::none;
+}
+
+std::vector<util::mip_level> ktx2_texture::get_levels(
+    std::vector<uint8_t> &data, uint32_t first_level) const
+{
+  std::vector<util::mip_level> result(levels.size());
+
+  size_t size = 0;
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    result[i] = { size, levels[i].width, levels[i].height };
+    size += levels[i].size;
+  }
+
+  auto start = first_level < levels.size() ? result[first_level].offset :
+      size;
+  data.resize(size - start);
+  for (size_t i = first_level; i < levels.size(); i++)
+  {
+    std::memcpy(data.data() + result[i].offset - start,
+                this->data + levels[i].offset, levels[i].size);
+  }
+
+  return result;
+}
+
+std::vector<util::mip_level> ktx2_texture::get_file_levels() const
+{
+  std::vector<util::mip_level> result(levels.size());
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    result[i] = { levels[i].offset, levels[i].width, levels[i].height };
+  }
+  return result;
+}
+
+bool ktx2_texture::can_transcode() const
+{
+  switch (format)
+  {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+      return true;
+    default:
+      return false;
+  }
+}
+
+VkFormat ktx2_texture::get_transcoded_format() const
+{
+  return find_block_info(format)->srgb ?
+      VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+std::vector<util::mip_level> ktx2_texture::transcode_rgba8(
+    std::vector<uint8_t> &data) const
+{
+  if (!can_transcode())
+  {
+    throw std::runtime_error("no transcoder for KTX2 texture format!");
+  }
+
+  bool bc3 = format == VK_FORMAT_BC3_UNORM_BLOCK
+      || format == VK_FORMAT_BC3_SRGB_BLOCK;
+  bool punch_through_alpha = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+      || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+  size_t block_size = bc3 ? 16 : 8;
+
+  std::vector<util::mip_level> result(levels.size());
+
+  size_t size = 0;
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    result[i] = { size, levels[i].width, levels[i].height };
+    size += static_cast<size_t>(levels[i].width) * levels[i].height * 4;
+  }
+
+  data.resize(size);
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    auto level_width = levels[i].width;
+    auto level_height = levels[i].height;
+    auto source = this->data + levels[i].offset;
+    auto destination = data.data() + result[i].offset;
+
+    for (uint32_t block_y = 0; block_y < level_height; block_y += 4)
+    {
+      for (uint32_t block_x = 0; block_x < level_width; block_x += 4)
+      {
+        uint8_t texels[16][4];
+        if (bc3)
+        {
+          decode_bc1_block(source + 8, true, false, texels);
+          decode_bc3_alpha(source, texels);
+        } else
+        {
+          decode_bc1_block(source, false, punch_through_alpha, texels);
+        }
+        source += block_size;
+
+        // blocks on the right and bottom edge may hang over the level
+        auto rows = std::min(4u, level_height - block_y);
+        auto columns = std::min(4u, level_width - block_x);
+        for (uint32_t y = 0; y < rows; y++)
+        {
+          std::memcpy(
+              destination
+                  + ((static_cast<size_t>(block_y + y) * level_width)
+                      + block_x) * 4,
+              texels[y * 4], columns * 4);
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
@@ -0,0 +1,155 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_KTX2_TEXTURE_HPP_
+#define ASSETS_KTX2_TEXTURE_HPP_
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../util/mip_chain.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Block compression family of a texture format, each one gated by its own
+/// device feature
+enum class compression_family
+{
+  none,
+  bc,
+  etc2,
+  astc
+};
+
+/// Location of one mip level in the file
+struct ktx2_level
+{
+  size_t offset;
+  size_t size;
+  uint32_t width;
+  uint32_t height;
+};
+
+/// A 2D texture in a KTX2 container with its mip levels in their GPU format.
+/// Supercompressed files, arrays, cube maps and 3D textures are rejected.
+class ktx2_texture
+{
+ public:
+  explicit ktx2_texture(std::string file_name);
+  explicit ktx2_texture(std::vector<char> file_data);
+  /// Parses a file in memory without copying it, data must outlive this
+  ktx2_texture(const uint8_t *data, size_t size);
+  ~ktx2_texture() = default;
+  ktx2_texture(ktx2_texture &&) = delete;
+  ktx2_texture(const ktx2_texture &) = delete;
+  ktx2_texture &operator=(const ktx2_texture &) = delete;
+  ktx2_texture &operator=(ktx2_texture &&) = delete;
+
+  /// The device feature a format needs, none for plain formats
+  static compression_family get_family(VkFormat format);
+
+  /// Copies first_level and every coarser level into data, tightly packed
+  /// with the finest first, ready for one vkCmdCopyBufferToImage per level.
+  ///
+  /// return the whole chain as if it was packed, data starts at the offset
+  ///        of first_level
+  std::vector<util::mip_level> get_levels(std::vector<uint8_t> &data,
+                                          uint32_t first_level = 0) const;
+
+  /// The levels where they are in the file, offsets are from get_data().
+  /// Uploading from a mapping only needs the file copied to staging memory.
+  std::vector<util::mip_level> get_file_levels() const;
+
+  /// True if transcode_rgba8 can decode the format on the CPU
+  bool can_transcode() const;
+
+  /// Decodes every level to RGBA8 for devices that cannot sample the
+  /// compressed format, the result is get_transcoded_format().
+  ///
+  /// return the levels in data
+  std::vector<util::mip_level> transcode_rgba8(
+      std::vector<uint8_t> &data) const;
+
+  /// R8G8B8A8_SRGB for sRGB formats, R8G8B8A8_UNORM otherwise
+  VkFormat get_transcoded_format() const;
+
+  VkFormat get_format() const
+  {
+    return format;
+  }
+
+  compression_family get_family() const
+  {
+    return get_family(format);
+  }
+
+  uint32_t get_width() const
+  {
+    return width;
+  }
+
+  uint32_t get_height() const
+  {
+    return height;
+  }
+
+  uint32_t get_num_levels() const
+  {
+    return static_cast<uint32_t>(levels.size());
+  }
+
+  const uint8_t *get_data() const
+  {
+    return data;
+  }
+
+  size_t get_size() const
+  {
+    return size;
+  }
+
+ private:
+  void initialize();
+
+  /// empty when the file is not owned
+  std::vector<char> file_data;
+  const uint8_t *data;
+  size_t size;
+
+  VkFormat format;
+  uint32_t width;
+  uint32_t height;
+  std::vector<ktx2_level> levels;
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_KTX2_TEXTURE_HPP_
@@ -0,0 +1,88 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESH_HPP_
+#define ASSETS_MESH_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Full precision vertex as it comes out of an importer
+struct mesh_vertex
+{
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 tex_coord;
+  glm::vec3 color;
+};
+
+/// One level of detail, a range of mesh_data::indices and the meshlets
+/// covering it
+struct mesh_lod
+{
+  uint32_t first_index;
+  uint32_t index_count;
+  /// largest distance of the simplified surface from the full detail one,
+  /// in mesh units
+  float error;
+  uint32_t first_meshlet;
+  uint32_t meshlet_count;
+};
+
+/// A small cluster of neighbouring triangles, a range of mesh_data::indices
+/// that is culled as a whole
+struct meshlet
+{
+  uint32_t first_index;
+  uint32_t index_count;
+  /// bounding sphere of the triangles, in mesh units
+  glm::vec3 center;
+  float radius;
+  /// every triangle normal is within the cone around axis whose half angle
+  /// has the sine cone_cutoff. 1 when the normals spread too far to cull.
+  glm::vec3 cone_axis;
+  float cone_cutoff;
+};
+
+/// An indexed triangle list. The levels of detail are stored one after the
+/// other in indices over the same vertices, full detail first. Without lods
+/// all indices are one level. The triangles of each meshlet are contiguous.
+struct mesh_data
+{
+  std::vector<mesh_vertex> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<mesh_lod> lods;
+  std::vector<meshlet> meshlets;
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESH_HPP_
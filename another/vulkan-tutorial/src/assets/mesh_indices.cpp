@@ -0,0 +1,158 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mesh_indices.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+const uint32_t mesh_indices::RESTART_INDEX;
+const uint32_t mesh_indices::STRIP_LOOKAHEAD;
+
+index_data mesh_indices::encode(const std::vector<uint32_t> &indices,
+                                size_t vertex_count)
+{
+  index_data result;
+  result.count = static_cast<uint32_t>(indices.size());
+
+  if (vertex_count > std::numeric_limits<uint16_t>::max())
+  {
+    result.type = VK_INDEX_TYPE_UINT32;
+    result.data.resize(indices.size() * sizeof(uint32_t));
+    std::memcpy(result.data.data(), indices.data(), result.data.size());
+    return result;
+  }
+
+  result.type = VK_INDEX_TYPE_UINT16;
+  result.data.resize(indices.size() * sizeof(uint16_t));
+  auto data = reinterpret_cast<uint16_t *>(result.data.data());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    data[i] = static_cast<uint16_t>(indices[i]);
+  }
+  return result;
+}
+
+std::vector<uint32_t> mesh_indices::to_strips(
+    const std::vector<uint32_t> &indices)
+{
+  auto triangle_count = indices.size() / 3;
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> strips;
+  strips.reserve(indices.size());
+
+  // triangles before next are all emitted
+  size_t next = 0;
+
+  // looks ahead for a triangle with the directed edge from -> to and
+  // returns it and its third vertex
+  auto find = [&](uint32_t from, uint32_t to, size_t &triangle,
+                  uint32_t &third)
+  {
+    uint32_t searched = 0;
+    for (auto t = next; t < triangle_count && searched < STRIP_LOOKAHEAD; t++)
+    {
+      if (emitted[t])
+      {
+        continue;
+      }
+      searched++;
+
+      auto corners = &indices[t * 3];
+      for (uint32_t c = 0; c < 3; c++)
+      {
+        if (corners[c] == from && corners[(c + 1) % 3] == to)
+        {
+          triangle = t;
+          third = corners[(c + 2) % 3];
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  size_t triangle;
+  uint32_t third;
+  while (true)
+  {
+    while (next < triangle_count && emitted[next])
+    {
+      next++;
+    }
+    if (next == triangle_count)
+    {
+      break;
+    }
+
+    // the second triangle of a strip is odd and reverses its first edge,
+    // so start rotated to where a neighbour shares the reversed last edge
+    auto corners = &indices[next * 3];
+    emitted[next] = true;
+    uint32_t rotation = 0;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+      if (find(corners[(r + 2) % 3], corners[(r + 1) % 3], triangle, third))
+      {
+        rotation = r;
+        break;
+      }
+    }
+
+    if (!strips.empty())
+    {
+      strips.push_back(RESTART_INDEX);
+    }
+    auto strip_start = strips.size();
+    for (uint32_t c = 0; c < 3; c++)
+    {
+      strips.push_back(corners[(rotation + c) % 3]);
+    }
+
+    // even triangles are (v0, v1, v2), odd ones (v1, v0, v2)
+    while (true)
+    {
+      auto previous = strips[strips.size() - 2];
+      auto last = strips[strips.size() - 1];
+      auto odd = (strips.size() - strip_start) % 2 == 1;
+
+      if (!(odd ? find(last, previous, triangle, third)
+                : find(previous, last, triangle, third)))
+      {
+        break;
+      }
+      emitted[triangle] = true;
+      strips.push_back(third);
+    }
+  }
+
+  return strips;
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
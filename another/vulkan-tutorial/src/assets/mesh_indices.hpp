@@ -0,0 +1,85 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESH_INDICES_HPP_
+#define ASSETS_MESH_INDICES_HPP_
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Index buffer contents in the narrowest index type the mesh allows
+struct index_data
+{
+  VkIndexType type;
+  uint32_t count;
+  std::vector<uint8_t> data;
+};
+
+/// Index width selection and triangle strips for index buffers
+class mesh_indices
+{
+ public:
+  /// Prevent creation of instances of this class
+  mesh_indices() = delete;
+  ~mesh_indices() = delete;
+  mesh_indices(mesh_indices &&) = delete;
+  mesh_indices(const mesh_indices &) = delete;
+  mesh_indices &operator=(const mesh_indices &) = delete;
+  mesh_indices &operator=(mesh_indices &&) = delete;
+
+  /// Starts a new strip when primitive restart is enabled, stored as all
+  /// ones in either index type
+  static const uint32_t RESTART_INDEX = 0xFFFFFFFF;
+
+  /// Triangles searched for one that continues the current strip. Small, so
+  /// the strips keep the post-transform cache order of the list.
+  static const uint32_t STRIP_LOOKAHEAD = 16;
+
+  /// 16 bit indices when every vertex fits below the 16 bit restart index,
+  /// 32 bit otherwise
+  static index_data encode(const std::vector<uint32_t> &indices,
+                           size_t vertex_count);
+
+  /// Converts a triangle list into triangle strips separated by
+  /// RESTART_INDEX, keeping the winding of every triangle. Strips are grown
+  /// greedily from the triangles in list order.
+  static std::vector<uint32_t> to_strips(const std::vector<uint32_t> &indices);
+
+  static uint32_t get_index_size(VkIndexType type)
+  {
+    return type == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+  }
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESH_INDICES_HPP_
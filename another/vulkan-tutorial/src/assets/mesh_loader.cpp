@@ -0,0 +1,724 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mesh_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "meshlet_builder.hpp"
+#include "../util/file_handler.hpp"
+#include "../util/json.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+const char MESH_MAGIC[4] = { 'T', 'M', 'S', 'H' };
+const uint32_t MESH_VERSION = 3;
+
+/// Cache file header, followed by the vertices, the indices of every level
+/// of detail, the level ranges and then the meshlets
+struct mesh_header
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t vertex_size;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t lod_count;
+  uint32_t meshlet_count;
+  uint32_t reserved;
+  /// identifies the source file the cache was built from
+  uint64_t source_size;
+  int64_t source_time;
+};
+
+static_assert(sizeof(mesh_header) == 48, "mesh header must be packed");
+static_assert(sizeof(mesh_lod) == 20, "mesh lod must be packed");
+static_assert(sizeof(meshlet) == 40, "meshlet must be packed");
+
+const uint32_t GLB_MAGIC = 0x46546C67;
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+const uint32_t GLTF_MODE_TRIANGLES = 4;
+const uint32_t GLTF_FLOAT = 5126;
+
+bool has_extension(const std::string &file_name, const std::string &extension)
+{
+  if (file_name.size() < extension.size())
+  {
+    return false;
+  }
+  return std::equal(extension.rbegin(), extension.rend(), file_name.rbegin(),
+                    [](char a, char b)
+                    {
+                      return a == std::tolower(static_cast<unsigned char>(b));
+                    });
+}
+
+/// Turns a 1-based or negative, relative OBJ index into a 0-based one
+size_t resolve_obj_index(long index, size_t count)
+{
+  auto resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+  if (index == 0 || resolved < 0 || static_cast<size_t>(resolved) >= count)
+  {
+    throw std::runtime_error("OBJ face index out of range!");
+  }
+  return static_cast<size_t>(resolved);
+}
+
+uint32_t get_component_size(uint32_t component_type)
+{
+  switch (component_type)
+  {
+    case 5120: // BYTE
+    case 5121: // UNSIGNED_BYTE
+      return 1;
+    case 5122: // SHORT
+    case 5123: // UNSIGNED_SHORT
+      return 2;
+    case 5125: // UNSIGNED_INT
+    case GLTF_FLOAT:
+      return 4;
+    default:
+      throw std::runtime_error("unsupported glTF component type!");
+  }
+}
+
+uint32_t get_component_count(const std::string &type)
+{
+  if (type == "SCALAR")
+  {
+    return 1;
+  } else if (type == "VEC2")
+  {
+    return 2;
+  } else if (type == "VEC3")
+  {
+    return 3;
+  } else if (type == "VEC4")
+  {
+    return 4;
+  }
+  throw std::runtime_error("unsupported glTF accessor type " + type);
+}
+
+/// Reads one component and converts it to float, normalized integers map to
+/// [0, 1] or [-1, 1]
+float read_component(const uint8_t *data, uint32_t component_type,
+                     bool normalized)
+{
+  switch (component_type)
+  {
+    case 5120:
+    {
+      auto value = *reinterpret_cast<const int8_t *>(data);
+      return normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case 5121:
+    {
+      auto value = *data;
+      return normalized ? value / 255.0f : value;
+    }
+    case 5122:
+    {
+      int16_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    case 5123:
+    {
+      uint16_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return normalized ? value / 65535.0f : value;
+    }
+    case 5125:
+    {
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return static_cast<float>(value);
+    }
+    default:
+    {
+      float value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+  }
+}
+
+/// An accessor resolved against the binary chunk
+struct gltf_accessor
+{
+  const uint8_t *data;
+  size_t count;
+  size_t stride;
+  uint32_t component_type;
+  uint32_t components;
+  bool normalized;
+
+  float get(size_t element, uint32_t component) const
+  {
+    return read_component(
+        data + element * stride
+            + component * get_component_size(component_type),
+        component_type, normalized);
+  }
+
+  uint32_t get_index(size_t element) const
+  {
+    auto element_data = data + element * stride;
+    switch (component_type)
+    {
+      case 5121:
+        return *element_data;
+      case 5123:
+      {
+        uint16_t value;
+        std::memcpy(&value, element_data, sizeof(value));
+        return value;
+      }
+      case 5125:
+      {
+        uint32_t value;
+        std::memcpy(&value, element_data, sizeof(value));
+        return value;
+      }
+      default:
+        throw std::runtime_error("glTF indices must be unsigned integers!");
+    }
+  }
+};
+
+gltf_accessor get_accessor(const util::json_value &document, size_t index,
+                           const std::vector<char> &file, size_t bin_offset,
+                           size_t bin_size)
+{
+  const auto &accessor = document["accessors"][index];
+  if (accessor.is_null() || accessor["bufferView"].is_null())
+  {
+    throw std::runtime_error("glTF accessor without buffer view!");
+  }
+  if (!accessor["sparse"].is_null())
+  {
+    throw std::runtime_error("sparse glTF accessors are not supported!");
+  }
+
+  auto view_index = static_cast<size_t>(accessor["bufferView"].as_number());
+  const auto &view = document["bufferViews"][view_index];
+  if (view.is_null() || view["buffer"].as_number() != 0)
+  {
+    throw std::runtime_error("glTF buffer view must use the GLB buffer!");
+  }
+
+  gltf_accessor result;
+  result.count = static_cast<size_t>(accessor["count"].as_number());
+  result.component_type =
+      static_cast<uint32_t>(accessor["componentType"].as_number());
+  result.components = get_component_count(accessor["type"].as_string());
+  result.normalized = accessor["normalized"].as_bool();
+
+  auto element_size = get_component_size(result.component_type)
+      * result.components;
+  result.stride = static_cast<size_t>(
+      view["byteStride"].as_number(element_size));
+
+  auto view_offset = static_cast<size_t>(view["byteOffset"].as_number());
+  auto view_size = static_cast<size_t>(view["byteLength"].as_number());
+  auto offset = static_cast<size_t>(accessor["byteOffset"].as_number());
+
+  if (view_offset > bin_size || view_size > bin_size - view_offset
+      || result.stride < element_size
+      || (result.count > 0
+          && (offset > view_size
+              || (result.count - 1) > (view_size - offset) / result.stride
+              || (result.count - 1) * result.stride + element_size
+                  > view_size - offset)))
+  {
+    throw std::runtime_error("glTF accessor out of bounds!");
+  }
+
+  result.data = reinterpret_cast<const uint8_t *>(file.data()) + bin_offset
+      + view_offset + offset;
+  return result;
+}
+
+/// Modification time in nanoseconds and size of a file
+void get_source_stamp(const std::string &file_name, uint64_t &size,
+                      int64_t &time)
+{
+  struct stat status;
+  if (stat(file_name.c_str(), &status) != 0)
+  {
+    throw std::runtime_error("failed to open " + file_name);
+  }
+  size = static_cast<uint64_t>(status.st_size);
+  time = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000
+      + status.st_mtim.tv_nsec;
+}
+
+bool read_cache(const std::string &cache_name, const mesh_header &expected,
+                mesh_data &mesh)
+{
+  std::ifstream stream(cache_name, std::ios::binary);
+  if (!stream.is_open())
+  {
+    return false;
+  }
+
+  mesh_header header;
+  stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!stream.good()
+      || std::memcmp(header.magic, expected.magic, sizeof(MESH_MAGIC)) != 0
+      || header.version != expected.version
+      || header.vertex_size != expected.vertex_size
+      || header.source_size != expected.source_size
+      || header.source_time != expected.source_time)
+  {
+    return false;
+  }
+
+  // the counts have to add up to the file size before anything is sized by
+  // them, a corrupt header would allocate or read far past the file
+  auto data_start = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  auto data_size = static_cast<uint64_t>(stream.tellg() - data_start);
+  stream.seekg(data_start);
+  if (!stream.good()
+      || data_size != uint64_t(header.vertex_count) * sizeof(mesh_vertex)
+          + uint64_t(header.index_count) * sizeof(uint32_t)
+          + uint64_t(header.lod_count) * sizeof(mesh_lod)
+          + uint64_t(header.meshlet_count) * sizeof(meshlet))
+  {
+    return false;
+  }
+
+  mesh.vertices.resize(header.vertex_count);
+  mesh.indices.resize(header.index_count);
+  mesh.lods.resize(header.lod_count);
+  mesh.meshlets.resize(header.meshlet_count);
+  stream.read(reinterpret_cast<char *>(mesh.vertices.data()),
+              mesh.vertices.size() * sizeof(mesh_vertex));
+  stream.read(reinterpret_cast<char *>(mesh.indices.data()),
+              mesh.indices.size() * sizeof(uint32_t));
+  stream.read(reinterpret_cast<char *>(mesh.lods.data()),
+              mesh.lods.size() * sizeof(mesh_lod));
+  stream.read(reinterpret_cast<char *>(mesh.meshlets.data()),
+              mesh.meshlets.size() * sizeof(meshlet));
+
+  // a truncated or corrupt cache is imported again
+  if (!stream.good() || mesh.indices.size() % 3 != 0
+      || std::any_of(mesh.indices.begin(), mesh.indices.end(),
+                     [&header](uint32_t index)
+                     {
+                       return index >= header.vertex_count;
+                     })
+      || std::any_of(mesh.lods.begin(), mesh.lods.end(),
+                     [&header](const mesh_lod &lod)
+                     {
+                       return lod.first_index > header.index_count
+                           || lod.index_count
+                               > header.index_count - lod.first_index
+                           || lod.first_index % 3 != 0
+                           || lod.index_count % 3 != 0
+                           || lod.first_meshlet > header.meshlet_count
+                           || lod.meshlet_count
+                               > header.meshlet_count - lod.first_meshlet;
+                     })
+      || std::any_of(mesh.meshlets.begin(), mesh.meshlets.end(),
+                     [&header](const meshlet &cluster)
+                     {
+                       return cluster.first_index > header.index_count
+                           || cluster.index_count
+                               > header.index_count - cluster.first_index;
+                     }))
+  {
+    mesh = mesh_data();
+    return false;
+  }
+  return true;
+}
+
+void write_cache(const std::string &cache_name, mesh_header header,
+                 const mesh_data &mesh)
+{
+  header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+  header.index_count = static_cast<uint32_t>(mesh.indices.size());
+  header.lod_count = static_cast<uint32_t>(mesh.lods.size());
+  header.meshlet_count = static_cast<uint32_t>(mesh.meshlets.size());
+
+  std::ofstream stream(cache_name, std::ios::binary | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("failed to create " + cache_name);
+  }
+
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  stream.write(reinterpret_cast<const char *>(mesh.vertices.data()),
+               mesh.vertices.size() * sizeof(mesh_vertex));
+  stream.write(reinterpret_cast<const char *>(mesh.indices.data()),
+               mesh.indices.size() * sizeof(uint32_t));
+  stream.write(reinterpret_cast<const char *>(mesh.lods.data()),
+               mesh.lods.size() * sizeof(mesh_lod));
+  stream.write(reinterpret_cast<const char *>(mesh.meshlets.data()),
+               mesh.meshlets.size() * sizeof(meshlet));
+
+  if (!stream.good())
+  {
+    throw std::runtime_error("failed to write " + cache_name);
+  }
+}
+
+}  // namespace
+
+mesh_data mesh_loader::load_cached(const std::string &file_name,
+                                   const std::string &cache_name)
+{
+  mesh_header header = { };
+  std::memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+  header.version = MESH_VERSION;
+  header.vertex_size = sizeof(mesh_vertex);
+  get_source_stamp(file_name, header.source_size, header.source_time);
+
+  mesh_data mesh;
+  if (!read_cache(cache_name, header, mesh))
+  {
+    mesh = import(file_name);
+
+    // the mesh is fine without its cache, it is only imported again next time
+    try
+    {
+      write_cache(cache_name, header, mesh);
+    } catch (const std::exception &e)
+    {
+      std::cerr << "mesh cache not written: " << e.what() << std::endl;
+      std::remove(cache_name.c_str());
+    }
+  }
+  return mesh;
+}
+
+mesh_data mesh_loader::import(const std::string &file_name)
+{
+  mesh_data mesh;
+  if (has_extension(file_name, ".obj"))
+  {
+    mesh = load_obj(file_name);
+  } else if (has_extension(file_name, ".glb"))
+  {
+    mesh = load_glb(file_name);
+  } else
+  {
+    throw std::runtime_error("unsupported mesh format " + file_name);
+  }
+
+  mesh_optimizer::optimize(mesh);
+  mesh_simplifier::build_lods(mesh, MAX_LODS);
+  meshlet_builder::build(mesh);
+  return mesh;
+}
+
+mesh_data mesh_loader::load_obj(const std::string &file_name)
+{
+  std::ifstream stream(file_name);
+  if (!stream.is_open())
+  {
+    throw std::runtime_error("failed to open " + file_name);
+  }
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> colors;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> tex_coords;
+  std::vector<mesh_vertex> corners;
+  std::vector<mesh_vertex> face;
+
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    auto current = line.c_str();
+    while (*current == ' ' || *current == '\t')
+    {
+      current++;
+    }
+
+    char *end;
+    if (current[0] == 'v' && (current[1] == ' ' || current[1] == '\t'))
+    {
+      glm::vec3 position;
+      position.x = std::strtof(current + 1, &end);
+      position.y = std::strtof(end, &end);
+      position.z = std::strtof(end, &end);
+      positions.push_back(position);
+
+      // optional vertex color after the position, a lone w is ignored
+      glm::vec3 color;
+      auto parsed = 0;
+      for (; parsed < 3; parsed++)
+      {
+        auto start = end;
+        color[parsed] = std::strtof(start, &end);
+        if (end == start)
+        {
+          break;
+        }
+      }
+      colors.push_back(parsed == 3 ? color : glm::vec3(1.0f));
+    } else if (current[0] == 'v' && current[1] == 't')
+    {
+      glm::vec2 tex_coord;
+      tex_coord.x = std::strtof(current + 2, &end);
+      tex_coord.y = 1.0f - std::strtof(end, &end);
+      tex_coords.push_back(tex_coord);
+    } else if (current[0] == 'v' && current[1] == 'n')
+    {
+      glm::vec3 normal;
+      normal.x = std::strtof(current + 2, &end);
+      normal.y = std::strtof(end, &end);
+      normal.z = std::strtof(end, &end);
+      normals.push_back(normal);
+    } else if (current[0] == 'f' && (current[1] == ' ' || current[1] == '\t'))
+    {
+      // v, v/vt, v//vn or v/vt/vn per corner
+      face.clear();
+      current++;
+      while (true)
+      {
+        auto index = std::strtol(current, &end, 10);
+        if (end == current)
+        {
+          break;
+        }
+        current = end;
+
+        mesh_vertex vertex = { };
+        auto position = resolve_obj_index(index, positions.size());
+        vertex.position = positions[position];
+        vertex.color = colors[position];
+
+        if (*current == '/')
+        {
+          current++;
+          if (*current != '/')
+          {
+            index = std::strtol(current, &end, 10);
+            vertex.tex_coord = tex_coords[resolve_obj_index(
+                index, tex_coords.size())];
+            current = end;
+          }
+          if (*current == '/')
+          {
+            current++;
+            index = std::strtol(current, &end, 10);
+            vertex.normal = normals[resolve_obj_index(index, normals.size())];
+            current = end;
+          }
+        }
+        face.push_back(vertex);
+      }
+
+      // polygons are triangulated as fans
+      for (size_t i = 2; i < face.size(); i++)
+      {
+        corners.push_back(face[0]);
+        corners.push_back(face[i - 1]);
+        corners.push_back(face[i]);
+      }
+    }
+  }
+
+  return mesh_optimizer::deduplicate(corners);
+}
+
+mesh_data mesh_loader::load_glb(const std::string &file_name)
+{
+  auto file = util::file_handler::read_binary_file(file_name);
+
+  uint32_t header[3];
+  if (file.size() < sizeof(header) + 8)
+  {
+    throw std::runtime_error("GLB file is truncated!");
+  }
+  std::memcpy(header, file.data(), sizeof(header));
+  if (header[0] != GLB_MAGIC || header[1] != 2)
+  {
+    throw std::runtime_error("not a glTF 2.0 binary file!");
+  }
+
+  // the JSON chunk comes first, the binary chunk is optional
+  size_t json_offset = 0;
+  size_t json_size = 0;
+  size_t bin_offset = 0;
+  size_t bin_size = 0;
+  size_t offset = sizeof(header);
+  while (offset + 8 <= file.size())
+  {
+    uint32_t chunk[2];
+    std::memcpy(chunk, file.data() + offset, sizeof(chunk));
+    offset += sizeof(chunk);
+    if (chunk[0] > file.size() - offset)
+    {
+      throw std::runtime_error("GLB chunk out of bounds!");
+    }
+
+    if (chunk[1] == GLB_CHUNK_JSON && json_size == 0)
+    {
+      json_offset = offset;
+      json_size = chunk[0];
+    } else if (chunk[1] == GLB_CHUNK_BIN && bin_size == 0)
+    {
+      bin_offset = offset;
+      bin_size = chunk[0];
+    }
+    offset += chunk[0];
+  }
+
+  auto document = util::json_value::parse(file.data() + json_offset,
+                                          json_size);
+
+  std::vector<mesh_vertex> corners;
+  const auto &meshes = document["meshes"];
+  for (size_t m = 0; m < meshes.size(); m++)
+  {
+    const auto &primitives = meshes[m]["primitives"];
+    for (size_t p = 0; p < primitives.size(); p++)
+    {
+      const auto &primitive = primitives[p];
+      const auto &attributes = primitive["attributes"];
+      if (primitive["mode"].as_number(GLTF_MODE_TRIANGLES)
+          != GLTF_MODE_TRIANGLES || attributes["POSITION"].is_null())
+      {
+        continue;
+      }
+
+      auto accessor = [&](const util::json_value &index)
+      {
+        return get_accessor(document, static_cast<size_t>(index.as_number()),
+                            file, bin_offset, bin_size);
+      };
+
+      auto positions = accessor(attributes["POSITION"]);
+      if (positions.components != 3)
+      {
+        throw std::runtime_error("glTF positions must be VEC3!");
+      }
+
+      std::vector<mesh_vertex> vertices(positions.count);
+      for (size_t i = 0; i < vertices.size(); i++)
+      {
+        vertices[i].position = glm::vec3(positions.get(i, 0),
+                                         positions.get(i, 1),
+                                         positions.get(i, 2));
+        vertices[i].normal = glm::vec3(0.0f);
+        vertices[i].tex_coord = glm::vec2(0.0f, 0.0f);
+        vertices[i].color = glm::vec3(1.0f);
+      }
+
+      if (!attributes["NORMAL"].is_null())
+      {
+        auto normals = accessor(attributes["NORMAL"]);
+        if (normals.components != 3 || normals.component_type != GLTF_FLOAT)
+        {
+          throw std::runtime_error("glTF normals must be float VEC3!");
+        }
+        for (size_t i = 0; i < std::min(normals.count, vertices.size()); i++)
+        {
+          vertices[i].normal = glm::vec3(normals.get(i, 0), normals.get(i, 1),
+                                         normals.get(i, 2));
+        }
+      }
+      if (!attributes["TEXCOORD_0"].is_null())
+      {
+        auto tex_coords = accessor(attributes["TEXCOORD_0"]);
+        if (tex_coords.components != 2
+            || (tex_coords.component_type != GLTF_FLOAT
+                && !tex_coords.normalized))
+        {
+          throw std::runtime_error(
+              "glTF texture coordinates must be float or normalized VEC2!");
+        }
+        for (size_t i = 0; i < std::min(tex_coords.count, vertices.size());
+            i++)
+        {
+          vertices[i].tex_coord = glm::vec2(tex_coords.get(i, 0),
+                                            tex_coords.get(i, 1));
+        }
+      }
+      if (!attributes["COLOR_0"].is_null())
+      {
+        auto colors = accessor(attributes["COLOR_0"]);
+        // alpha is dropped
+        if ((colors.components != 3 && colors.components != 4)
+            || (colors.component_type != GLTF_FLOAT && !colors.normalized))
+        {
+          throw std::runtime_error(
+              "glTF colors must be float or normalized VEC3 or VEC4!");
+        }
+        for (size_t i = 0; i < std::min(colors.count, vertices.size()); i++)
+        {
+          vertices[i].color = glm::vec3(colors.get(i, 0), colors.get(i, 1),
+                                        colors.get(i, 2));
+        }
+      }
+
+      if (primitive["indices"].is_null())
+      {
+        corners.insert(corners.end(), vertices.begin(),
+                       vertices.end() - vertices.size() % 3);
+        continue;
+      }
+
+      auto indices = accessor(primitive["indices"]);
+      for (size_t i = 0; i + 2 < indices.count; i += 3)
+      {
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+          auto index = indices.get_index(i + corner);
+          if (index >= vertices.size())
+          {
+            throw std::runtime_error("glTF index out of range!");
+          }
+          corners.push_back(vertices[index]);
+        }
+      }
+    }
+  }
+
+  return mesh_optimizer::deduplicate(corners);
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
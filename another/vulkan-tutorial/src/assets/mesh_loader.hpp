@@ -0,0 +1,80 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESH_LOADER_HPP_
+#define ASSETS_MESH_LOADER_HPP_
+
+#include <string>
+
+#include "mesh.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Mesh import from Wavefront OBJ and binary glTF 2.0 files. Imported
+/// meshes are optimized, simplified and split into meshlets once and cached
+/// in a binary file that loads with a handful of reads.
+class mesh_loader
+{
+ public:
+  /// Prevent creation of instances of this class
+  mesh_loader() = delete;
+  ~mesh_loader() = delete;
+  mesh_loader(mesh_loader &&) = delete;
+  mesh_loader(const mesh_loader &) = delete;
+  mesh_loader &operator=(const mesh_loader &) = delete;
+  mesh_loader &operator=(mesh_loader &&) = delete;
+
+  /// Loads the cache when it was written from the current version of the
+  /// source file, otherwise imports the source and rewrites the cache
+  ///
+  /// @param[in] file_name .obj or .glb source file
+  /// @param[in] cache_name cached mesh, created when missing
+  ///
+  /// return the optimized mesh
+  static mesh_data load_cached(const std::string &file_name,
+                               const std::string &cache_name);
+
+  /// Levels of detail built on import, the full detail one included
+  static const uint32_t MAX_LODS = 4;
+
+  /// Loads and optimizes a .obj or .glb file, picked by extension, and
+  /// builds its levels of detail and their meshlets
+  static mesh_data import(const std::string &file_name);
+
+  /// Triangulated, deduplicated OBJ geometry. Texture coordinates are
+  /// flipped to a top left origin, "v x y z r g b" vertex colors are read.
+  static mesh_data load_obj(const std::string &file_name);
+
+  /// Deduplicated triangle primitives of every mesh in a GLB file, in mesh
+  /// space. Node transforms, sparse accessors and external buffers are not
+  /// supported.
+  static mesh_data load_glb(const std::string &file_name);
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESH_LOADER_HPP_
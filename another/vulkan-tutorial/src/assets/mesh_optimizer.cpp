@@ -0,0 +1,422 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+namespace
+{
+
+// vertices are hashed and compared as raw bytes
+static_assert(sizeof(mesh_vertex) == 11 * sizeof(float),
+              "mesh_vertex must not contain padding");
+
+struct vertex_hash
+{
+  size_t operator()(const mesh_vertex &vertex) const
+  {
+    // FNV-1a
+    auto bytes = reinterpret_cast<const uint8_t *>(&vertex);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(mesh_vertex); i++)
+    {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+struct vertex_equal
+{
+  bool operator()(const mesh_vertex &a, const mesh_vertex &b) const
+  {
+    return std::memcmp(&a, &b, sizeof(mesh_vertex)) == 0;
+  }
+};
+
+/// Simulated FIFO post-transform cache. A vertex is cached while fewer than
+/// size other vertices were inserted after it.
+class fifo_cache
+{
+ public:
+  fifo_cache(size_t vertex_count, uint32_t size)
+      : timestamps(vertex_count, 0),
+        size(size),
+        time(size + 1)
+  {
+  }
+
+  /// Returns true on a miss
+  bool access(uint32_t vertex)
+  {
+    if (time - timestamps[vertex] > size)
+    {
+      timestamps[vertex] = time++;
+      return true;
+    }
+    return false;
+  }
+
+  uint32_t access_triangle(const uint32_t *triangle)
+  {
+    return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+  }
+
+  /// Evicts everything without touching the timestamps
+  void flush()
+  {
+    time += size + 1;
+  }
+
+ private:
+  std::vector<uint32_t> timestamps;
+  uint32_t size;
+  uint32_t time;
+};
+
+}  // namespace
+
+void mesh_optimizer::optimize(mesh_data &mesh)
+{
+  optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+  optimize_overdraw(mesh.indices, mesh.vertices);
+  optimize_vertex_fetch(mesh);
+}
+
+mesh_data mesh_optimizer::deduplicate(const std::vector<mesh_vertex> &corners)
+{
+  mesh_data mesh;
+  mesh.indices.reserve(corners.size());
+
+  std::unordered_map<mesh_vertex, uint32_t, vertex_hash, vertex_equal> unique;
+  unique.reserve(corners.size());
+
+  for (const auto &corner : corners)
+  {
+    auto result = unique.emplace(corner,
+                                 static_cast<uint32_t>(mesh.vertices.size()));
+    if (result.second)
+    {
+      mesh.vertices.push_back(corner);
+    }
+    mesh.indices.push_back(result.first->second);
+  }
+
+  return mesh;
+}
+
+void mesh_optimizer::optimize_vertex_cache(std::vector<uint32_t> &indices,
+                                           size_t vertex_count,
+                                           uint32_t cache_size)
+{
+  auto triangle_count = indices.size() / 3;
+  if (triangle_count == 0)
+  {
+    return;
+  }
+
+  // triangles around each vertex, bucketed with a counting sort
+  std::vector<uint32_t> live(vertex_count, 0);
+  for (auto index : indices)
+  {
+    live[index]++;
+  }
+
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t i = 0; i < vertex_count; i++)
+  {
+    offsets[i + 1] = offsets[i] + live[i];
+  }
+
+  std::vector<uint32_t> adjacency(triangle_count * 3);
+  {
+    auto fill = offsets;
+    for (size_t i = 0; i < triangle_count * 3; i++)
+    {
+      adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<uint32_t> timestamps(vertex_count, 0);
+  uint32_t time = cache_size + 1;
+
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> dead_ends;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> result;
+  result.reserve(triangle_count * 3);
+
+  // vertices below the cursor have no triangles left
+  uint32_t cursor = 0;
+  int64_t fanning = 0;
+
+  while (fanning >= 0)
+  {
+    // emit the whole fan around the current vertex
+    candidates.clear();
+    for (auto i = offsets[fanning]; i < offsets[fanning + 1]; i++)
+    {
+      auto triangle = adjacency[i];
+      if (emitted[triangle])
+      {
+        continue;
+      }
+
+      for (uint32_t corner = 0; corner < 3; corner++)
+      {
+        auto vertex = indices[triangle * 3 + corner];
+        result.push_back(vertex);
+        dead_ends.push_back(vertex);
+        candidates.push_back(vertex);
+        live[vertex]--;
+
+        if (time - timestamps[vertex] > cache_size)
+        {
+          timestamps[vertex] = time++;
+        }
+      }
+      emitted[triangle] = true;
+    }
+
+    // continue with the oldest vertex that stays cached while its own fan
+    // is emitted
+    fanning = -1;
+    int64_t best_priority = -1;
+    for (auto vertex : candidates)
+    {
+      if (live[vertex] == 0)
+      {
+        continue;
+      }
+
+      int64_t priority = 0;
+      if (time - timestamps[vertex] + 2 * live[vertex] <= cache_size)
+      {
+        priority = time - timestamps[vertex];
+      }
+      if (priority > best_priority)
+      {
+        best_priority = priority;
+        fanning = vertex;
+      }
+    }
+
+    // dead end, back up to the most recent vertex with triangles left
+    while (fanning < 0 && !dead_ends.empty())
+    {
+      auto vertex = dead_ends.back();
+      dead_ends.pop_back();
+      if (live[vertex] > 0)
+      {
+        fanning = vertex;
+      }
+    }
+
+    while (fanning < 0 && cursor < vertex_count)
+    {
+      if (live[cursor] > 0)
+      {
+        fanning = cursor;
+      }
+      cursor++;
+    }
+  }
+
+  indices.swap(result);
+}
+
+void mesh_optimizer::optimize_overdraw(std::vector<uint32_t> &indices,
+                                       const std::vector<mesh_vertex> &vertices,
+                                       float threshold, uint32_t cache_size)
+{
+  auto triangle_count = indices.size() / 3;
+  if (triangle_count == 0)
+  {
+    return;
+  }
+
+  fifo_cache cache(vertices.size(), cache_size);
+
+  // a triangle that misses on all three vertices starts from a cold cache
+  // anyway, the clusters between those can move freely
+  std::vector<uint32_t> hard_clusters;
+  for (size_t i = 0; i < triangle_count; i++)
+  {
+    if (cache.access_triangle(&indices[i * 3]) == 3)
+    {
+      hard_clusters.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  hard_clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+  // split further wherever the running ACMR got close enough to the one of
+  // the whole cluster
+  std::vector<uint32_t> clusters;
+  for (size_t c = 0; c + 1 < hard_clusters.size(); c++)
+  {
+    auto start = hard_clusters[c];
+    auto end = hard_clusters[c + 1];
+
+    cache.flush();
+    uint32_t cluster_misses = 0;
+    for (auto i = start; i < end; i++)
+    {
+      cluster_misses += cache.access_triangle(&indices[i * 3]);
+    }
+    auto limit = threshold * cluster_misses / (end - start);
+
+    clusters.push_back(start);
+    cache.flush();
+    uint32_t misses = 0;
+    uint32_t count = 0;
+    for (auto i = start; i + 1 < end; i++)
+    {
+      misses += cache.access_triangle(&indices[i * 3]);
+      count++;
+      if (static_cast<float>(misses) / count <= limit)
+      {
+        clusters.push_back(i + 1);
+        cache.flush();
+        misses = 0;
+        count = 0;
+      }
+    }
+  }
+  clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+  // area weighted centroid and normal of each cluster
+  auto cluster_count = clusters.size() - 1;
+  std::vector<glm::vec3> centroids(cluster_count, glm::vec3(0.0f));
+  std::vector<glm::vec3> normals(cluster_count, glm::vec3(0.0f));
+  std::vector<float> areas(cluster_count, 0.0f);
+  auto mesh_centroid = glm::vec3(0.0f);
+  float mesh_area = 0.0f;
+
+  for (size_t c = 0; c < cluster_count; c++)
+  {
+    for (auto i = clusters[c]; i < clusters[c + 1]; i++)
+    {
+      const auto &a = vertices[indices[i * 3]].position;
+      const auto &b = vertices[indices[i * 3 + 1]].position;
+      const auto &d = vertices[indices[i * 3 + 2]].position;
+
+      auto normal = glm::cross(b - a, d - a);
+      auto area = glm::length(normal);
+
+      centroids[c] = centroids[c] + (a + b + d) * (area / 3.0f);
+      normals[c] = normals[c] + normal;
+      areas[c] += area;
+    }
+
+    mesh_centroid = mesh_centroid + centroids[c];
+    mesh_area += areas[c];
+    if (areas[c] > 0.0f)
+    {
+      centroids[c] = centroids[c] * (1.0f / areas[c]);
+    }
+  }
+  if (mesh_area > 0.0f)
+  {
+    mesh_centroid = mesh_centroid * (1.0f / mesh_area);
+  }
+
+  // clusters far out along their normal face away from the rest of the
+  // mesh and are drawn first
+  std::vector<float> keys(cluster_count, 0.0f);
+  std::vector<uint32_t> order(cluster_count);
+  for (size_t c = 0; c < cluster_count; c++)
+  {
+    auto length = glm::length(normals[c]);
+    if (length > 0.0f)
+    {
+      keys[c] = glm::dot(centroids[c] - mesh_centroid, normals[c])
+          / length;
+    }
+    order[c] = static_cast<uint32_t>(c);
+  }
+  std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b)
+  {
+    return keys[a] > keys[b];
+  });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (auto c : order)
+  {
+    result.insert(result.end(), indices.begin() + clusters[c] * 3,
+                  indices.begin() + clusters[c + 1] * 3);
+  }
+  indices.swap(result);
+}
+
+void mesh_optimizer::optimize_vertex_fetch(mesh_data &mesh)
+{
+  const auto UNUSED = std::numeric_limits<uint32_t>::max();
+
+  std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+  std::vector<mesh_vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+
+  for (auto &index : mesh.indices)
+  {
+    if (remap[index] == UNUSED)
+    {
+      remap[index] = static_cast<uint32_t>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+
+  mesh.vertices.swap(vertices);
+}
+
+float mesh_optimizer::analyze_vertex_cache(const std::vector<uint32_t> &indices,
+                                           size_t vertex_count,
+                                           uint32_t cache_size)
+{
+  auto triangle_count = indices.size() / 3;
+  if (triangle_count == 0)
+  {
+    return 0.0f;
+  }
+
+  fifo_cache cache(vertex_count, cache_size);
+  uint32_t misses = 0;
+  for (size_t i = 0; i < triangle_count; i++)
+  {
+    misses += cache.access_triangle(&indices[i * 3]);
+  }
+  return static_cast<float>(misses) / triangle_count;
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
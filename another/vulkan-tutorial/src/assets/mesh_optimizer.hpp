@@ -0,0 +1,96 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESH_OPTIMIZER_HPP_
+#define ASSETS_MESH_OPTIMIZER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Offline reordering of triangle lists for the GPU: shared vertices are
+/// merged, triangles reordered for the post-transform cache and for
+/// overdraw, and vertices reordered for fetch locality
+class mesh_optimizer
+{
+ public:
+  /// Prevent creation of instances of this class
+  mesh_optimizer() = delete;
+  ~mesh_optimizer() = delete;
+  mesh_optimizer(mesh_optimizer &&) = delete;
+  mesh_optimizer(const mesh_optimizer &) = delete;
+  mesh_optimizer &operator=(const mesh_optimizer &) = delete;
+  mesh_optimizer &operator=(mesh_optimizer &&) = delete;
+
+  /// Post-transform cache size the orderings are tuned for. Small enough to
+  /// hold on every GPU, larger caches only gain.
+  static const uint32_t CACHE_SIZE = 16;
+
+  /// How much worse than its hard cluster a split cluster may get, in
+  /// ACMR, to buy overdraw ordering
+  static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+  /// Runs every pass below in order
+  static void optimize(mesh_data &mesh);
+
+  /// Turns an unindexed triangle list into an indexed one, bitwise equal
+  /// vertices share one index
+  static mesh_data deduplicate(const std::vector<mesh_vertex> &corners);
+
+  /// Tipsify (Sander et al. 2007), linear time triangle order for a FIFO
+  /// cache of cache_size entries
+  static void optimize_vertex_cache(std::vector<uint32_t> &indices,
+                                    size_t vertex_count,
+                                    uint32_t cache_size = CACHE_SIZE);
+
+  /// Splits the cache ordered triangles into clusters that cost at most
+  /// threshold times the cache misses and sorts the clusters so the ones
+  /// facing away from the mesh center come first, which occlude the rest
+  /// from most view directions. Call after optimize_vertex_cache.
+  static void optimize_overdraw(std::vector<uint32_t> &indices,
+                                const std::vector<mesh_vertex> &vertices,
+                                float threshold = OVERDRAW_THRESHOLD,
+                                uint32_t cache_size = CACHE_SIZE);
+
+  /// Renumbers vertices in the order the triangles first use them, unused
+  /// vertices are dropped
+  static void optimize_vertex_fetch(mesh_data &mesh);
+
+  /// Average cache misses per triangle with a FIFO cache, 0.5 is the
+  /// practical best and 3 the worst
+  static float analyze_vertex_cache(const std::vector<uint32_t> &indices,
+                                    size_t vertex_count,
+                                    uint32_t cache_size = CACHE_SIZE);
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESH_OPTIMIZER_HPP_
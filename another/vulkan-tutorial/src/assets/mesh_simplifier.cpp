@@ -0,0 +1,398 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mesh_simplifier.hpp"
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+/// Sum of squared distances to a set of planes, weighted by triangle area.
+/// The symmetric 4x4 matrix is stored as its upper triangle.
+struct quadric
+{
+  double a2, ab, ac, ad;
+  double b2, bc, bd;
+  double c2, cd;
+  double d2;
+  double weight;
+
+  void add_plane(double a, double b, double c, double d, double w)
+  {
+    a2 += a * a * w;
+    ab += a * b * w;
+    ac += a * c * w;
+    ad += a * d * w;
+    b2 += b * b * w;
+    bc += b * c * w;
+    bd += b * d * w;
+    c2 += c * c * w;
+    cd += c * d * w;
+    d2 += d * d * w;
+    weight += w;
+  }
+
+  void add(const quadric &other)
+  {
+    a2 += other.a2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    b2 += other.b2;
+    bc += other.bc;
+    bd += other.bd;
+    c2 += other.c2;
+    cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+  }
+
+  double evaluate(const glm::vec3 &p) const
+  {
+    double x = p.x, y = p.y, z = p.z;
+    return a2 * x * x + b2 * y * y + c2 * z * z + d2
+        + 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y
+            + cd * z);
+  }
+};
+
+struct collapse
+{
+  uint32_t from;
+  uint32_t to;
+  float cost;
+};
+
+struct position_hash
+{
+  size_t operator()(const glm::vec3 &position) const
+  {
+    uint32_t bits[3];
+    std::memcpy(bits, &position, sizeof(bits));
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u)
+        ^ (bits[2] * 83492791u);
+  }
+};
+
+struct position_equal
+{
+  bool operator()(const glm::vec3 &a, const glm::vec3 &b) const
+  {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+  }
+};
+
+glm::vec3 triangle_normal(const glm::vec3 &a, const glm::vec3 &b,
+                          const glm::vec3 &c)
+{
+  return glm::cross(b - a, c - a);
+}
+
+/// Vertices that must not move: ones sharing their position with another
+/// vertex (a seam in the attributes) and ones on an open border
+std::vector<bool> find_locked(const std::vector<mesh_vertex> &vertices,
+                              const std::vector<uint32_t> &indices)
+{
+  std::vector<bool> locked(vertices.size(), false);
+
+  std::unordered_map<glm::vec3, uint32_t, position_hash, position_equal> first;
+  first.reserve(vertices.size());
+  for (uint32_t i = 0; i < vertices.size(); i++)
+  {
+    auto result = first.emplace(vertices[i].position, i);
+    if (!result.second)
+    {
+      locked[i] = true;
+      locked[result.first->second] = true;
+    }
+  }
+
+  std::unordered_set<uint64_t> edges;
+  edges.reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+      uint64_t a = indices[i + corner];
+      uint64_t b = indices[i + (corner + 1) % 3];
+      edges.insert(a << 32 | b);
+    }
+  }
+  for (auto edge : edges)
+  {
+    auto reverse = edge << 32 | edge >> 32;
+    if (edges.find(reverse) == edges.end())
+    {
+      locked[edge >> 32] = true;
+      locked[edge & 0xFFFFFFFF] = true;
+    }
+  }
+
+  return locked;
+}
+
+}  // namespace
+
+std::vector<uint32_t> mesh_simplifier::simplify(
+    const std::vector<mesh_vertex> &vertices,
+    const std::vector<uint32_t> &indices, size_t target_index_count,
+    float &error)
+{
+  error = 0.0f;
+  auto vertex_count = vertices.size();
+
+  std::vector<quadric> quadrics(vertex_count, quadric());
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    const auto &a = vertices[indices[i]].position;
+    const auto &b = vertices[indices[i + 1]].position;
+    const auto &c = vertices[indices[i + 2]].position;
+
+    auto normal = triangle_normal(a, b, c);
+    auto area = glm::length(normal);
+    if (area == 0.0f)
+    {
+      continue;
+    }
+    normal = normal * (1.0f / area);
+    double d = -glm::dot(normal, a);
+
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+      quadrics[indices[i + corner]].add_plane(normal.x, normal.y, normal.z, d,
+                                              area);
+    }
+  }
+
+  auto locked = find_locked(vertices, indices);
+
+  // mean squared distance of the planes around both ends from where the
+  // collapse moves them
+  auto cost = [&](uint32_t from, uint32_t to)
+  {
+    const auto &position = vertices[to].position;
+    auto weight = quadrics[from].weight + quadrics[to].weight;
+    auto sum = quadrics[from].evaluate(position)
+        + quadrics[to].evaluate(position);
+    return weight > 0.0 ? static_cast<float>(std::max(sum / weight, 0.0))
+        : 0.0f;
+  };
+
+  std::vector<uint32_t> result(indices.begin(),
+                               indices.begin() + indices.size() / 3 * 3);
+  std::vector<uint32_t> remap(vertex_count);
+  std::vector<uint32_t> offsets(vertex_count + 1);
+  std::vector<uint32_t> adjacency;
+  std::vector<collapse> candidates;
+  std::vector<bool> touched(vertex_count);
+  float max_cost = 0.0f;
+
+  // each pass collapses an independent set of the cheapest edges, then the
+  // candidates are rebuilt with the merged quadrics
+  while (result.size() > target_index_count)
+  {
+    auto triangle_count = result.size() / 3;
+
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (auto index : result)
+    {
+      offsets[index + 1]++;
+    }
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+      offsets[i + 1] += offsets[i];
+    }
+    adjacency.resize(result.size());
+    {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < result.size(); i++)
+      {
+        adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+      }
+    }
+
+    candidates.clear();
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      for (uint32_t corner = 0; corner < 3; corner++)
+      {
+        auto a = result[i + corner];
+        auto b = result[i + (corner + 1) % 3];
+        if (!locked[a])
+        {
+          candidates.push_back( { a, b, cost(a, b) });
+        }
+        if (!locked[b])
+        {
+          candidates.push_back( { b, a, cost(b, a) });
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const collapse &a, const collapse &b)
+              {
+                return a.cost < b.cost;
+              });
+
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+      remap[i] = static_cast<uint32_t>(i);
+    }
+    std::fill(touched.begin(), touched.end(), false);
+
+    auto target_triangles = target_index_count / 3;
+    size_t collapsed = 0;
+    for (const auto &candidate : candidates)
+    {
+      if (triangle_count <= target_triangles)
+      {
+        break;
+      }
+      if (touched[candidate.from] || touched[candidate.to])
+      {
+        continue;
+      }
+
+      // the triangles that stay must not flip over
+      bool flips = false;
+      size_t removed = 0;
+      for (auto k = offsets[candidate.from]; k < offsets[candidate.from + 1];
+          k++)
+      {
+        auto triangle = &result[adjacency[k] * 3];
+        if (triangle[0] == candidate.to || triangle[1] == candidate.to
+            || triangle[2] == candidate.to)
+        {
+          removed++;
+          continue;
+        }
+
+        glm::vec3 before[3];
+        glm::vec3 after[3];
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+          before[corner] = vertices[triangle[corner]].position;
+          after[corner] =
+              triangle[corner] == candidate.from ?
+                  vertices[candidate.to].position : before[corner];
+        }
+        if (glm::dot(triangle_normal(before[0], before[1], before[2]),
+                     triangle_normal(after[0], after[1], after[2])) <= 0.0f)
+        {
+          flips = true;
+          break;
+        }
+      }
+      if (flips)
+      {
+        continue;
+      }
+
+      remap[candidate.from] = candidate.to;
+      quadrics[candidate.to].add(quadrics[candidate.from]);
+      for (auto k = offsets[candidate.from]; k < offsets[candidate.from + 1];
+          k++)
+      {
+        auto triangle = &result[adjacency[k] * 3];
+        touched[triangle[0]] = true;
+        touched[triangle[1]] = true;
+        touched[triangle[2]] = true;
+      }
+      touched[candidate.to] = true;
+
+      triangle_count -= removed;
+      max_cost = std::max(max_cost, candidate.cost);
+      collapsed++;
+    }
+
+    if (collapsed == 0)
+    {
+      break;
+    }
+
+    // collapsed triangles have two corners on the same vertex
+    size_t write = 0;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      auto a = remap[result[i]];
+      auto b = remap[result[i + 1]];
+      auto c = remap[result[i + 2]];
+      if (a != b && b != c && a != c)
+      {
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+    }
+    result.resize(write);
+  }
+
+  error = std::sqrt(max_cost);
+  return result;
+}
+
+void mesh_simplifier::build_lods(mesh_data &mesh, uint32_t max_lods)
+{
+  mesh.lods.clear();
+
+  std::vector<uint32_t> full(mesh.indices);
+  mesh_lod lod = { 0, static_cast<uint32_t>(full.size()), 0.0f, 0, 0 };
+  mesh.lods.push_back(lod);
+
+  auto target = full.size();
+  auto previous = full.size();
+  while (mesh.lods.size() < max_lods)
+  {
+    target = static_cast<size_t>(target / 3 * LOD_REDUCTION) * 3;
+
+    float error;
+    auto level = simplify(mesh.vertices, full, target, error);
+    if (level.empty() || level.size() > previous * MIN_LOD_REDUCTION)
+    {
+      break;
+    }
+    mesh_optimizer::optimize_vertex_cache(level, mesh.vertices.size());
+
+    // errors grow with the level even where a collapse order says otherwise
+    lod.first_index = static_cast<uint32_t>(mesh.indices.size());
+    lod.index_count = static_cast<uint32_t>(level.size());
+    lod.error = std::max(error, lod.error);
+    mesh.lods.push_back(lod);
+
+    mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+    previous = level.size();
+  }
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
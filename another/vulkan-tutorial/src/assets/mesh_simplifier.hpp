@@ -0,0 +1,80 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESH_SIMPLIFIER_HPP_
+#define ASSETS_MESH_SIMPLIFIER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Level of detail generation by edge collapse with quadric error metrics
+/// (Garland and Heckbert 1997). Vertices only ever collapse onto their
+/// neighbours, so every level indexes the vertices of the full mesh.
+class mesh_simplifier
+{
+ public:
+  /// Prevent creation of instances of this class
+  mesh_simplifier() = delete;
+  ~mesh_simplifier() = delete;
+  mesh_simplifier(mesh_simplifier &&) = delete;
+  mesh_simplifier(const mesh_simplifier &) = delete;
+  mesh_simplifier &operator=(const mesh_simplifier &) = delete;
+  mesh_simplifier &operator=(mesh_simplifier &&) = delete;
+
+  /// Triangles kept by each level relative to the one before it
+  static constexpr float LOD_REDUCTION = 0.5f;
+
+  /// A level that cannot get below this fraction of the previous one ends
+  /// the chain
+  static constexpr float MIN_LOD_REDUCTION = 0.85f;
+
+  /// Collapses edges of the cheapest error first until at most
+  /// target_index_count indices are left or nothing can collapse anymore.
+  /// Texture seams and open borders stay in place.
+  ///
+  /// @param[out] error distance of the result from the input surface
+  ///
+  /// return the simplified triangle list
+  static std::vector<uint32_t> simplify(
+      const std::vector<mesh_vertex> &vertices,
+      const std::vector<uint32_t> &indices, size_t target_index_count,
+      float &error);
+
+  /// Replaces mesh.lods by a chain of up to max_lods levels, each simplified
+  /// from the full detail triangles in mesh.indices and ordered for the
+  /// vertex cache
+  static void build_lods(mesh_data &mesh, uint32_t max_lods);
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESH_SIMPLIFIER_HPP_
@@ -0,0 +1,264 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "meshlet_builder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+/// Groups the triangles of one level into meshlets, appending them to
+/// meshlets and their triangles to ordered
+void build_level(const std::vector<mesh_vertex> &vertices,
+                 const uint32_t *indices, uint32_t index_count,
+                 uint32_t first_index, std::vector<uint32_t> &ordered,
+                 std::vector<meshlet> &meshlets)
+{
+  auto triangle_count = index_count / 3;
+  auto vertex_count = vertices.size();
+
+  // triangles around each vertex
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (uint32_t i = 0; i < index_count; i++)
+  {
+    offsets[indices[i] + 1]++;
+  }
+  for (size_t i = 0; i < vertex_count; i++)
+  {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<uint32_t> adjacency(index_count);
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+      adjacency[fill[indices[i]]++] = i / 3;
+    }
+  }
+
+  std::vector<bool> used(triangle_count, false);
+  // meshlet number a vertex was last added to
+  std::vector<uint32_t> stamps(vertex_count, INVALID_INDEX);
+
+  std::vector<uint32_t> meshlet_vertices;
+  std::vector<uint32_t> meshlet_triangles;
+  uint32_t next = 0;
+  uint32_t stamp = 0;
+
+  auto new_vertices = [&](uint32_t triangle)
+  {
+    uint32_t count = 0;
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+      count += stamps[indices[triangle * 3 + corner]] == stamp ? 0 : 1;
+    }
+    return count;
+  };
+
+  auto add = [&](uint32_t triangle)
+  {
+    used[triangle] = true;
+    meshlet_triangles.push_back(triangle);
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+      auto vertex = indices[triangle * 3 + corner];
+      if (stamps[vertex] != stamp)
+      {
+        stamps[vertex] = stamp;
+        meshlet_vertices.push_back(vertex);
+      }
+    }
+  };
+
+  while (true)
+  {
+    while (next < triangle_count && used[next])
+    {
+      next++;
+    }
+    if (next == triangle_count)
+    {
+      break;
+    }
+
+    meshlet_vertices.clear();
+    meshlet_triangles.clear();
+    add(next);
+
+    // grow across shared vertices, taking the triangle that adds the fewest
+    // vertices and the earliest one of those, until nothing fits
+    while (meshlet_triangles.size() < meshlet_builder::MAX_TRIANGLES)
+    {
+      auto best = INVALID_INDEX;
+      uint32_t best_cost = 3;
+      for (auto vertex : meshlet_vertices)
+      {
+        for (auto k = offsets[vertex]; k < offsets[vertex + 1]; k++)
+        {
+          auto triangle = adjacency[k];
+          if (used[triangle])
+          {
+            continue;
+          }
+          auto cost = new_vertices(triangle);
+          if (cost < best_cost || (cost == best_cost && triangle < best))
+          {
+            best = triangle;
+            best_cost = cost;
+          }
+        }
+      }
+
+      if (best == INVALID_INDEX
+          || meshlet_vertices.size() + best_cost
+              > meshlet_builder::MAX_VERTICES)
+      {
+        break;
+      }
+      add(best);
+    }
+
+    // the cache order of the level is kept inside the meshlet
+    std::sort(meshlet_triangles.begin(), meshlet_triangles.end());
+
+    meshlet cluster;
+    cluster.first_index = first_index + static_cast<uint32_t>(ordered.size());
+    cluster.index_count = static_cast<uint32_t>(meshlet_triangles.size() * 3);
+    for (auto triangle : meshlet_triangles)
+    {
+      ordered.push_back(indices[triangle * 3]);
+      ordered.push_back(indices[triangle * 3 + 1]);
+      ordered.push_back(indices[triangle * 3 + 2]);
+    }
+    meshlet_builder::compute_bounds(
+        vertices, ordered.data() + ordered.size() - cluster.index_count,
+        cluster.index_count, cluster);
+    meshlets.push_back(cluster);
+
+    stamp++;
+  }
+}
+
+}  // namespace
+
+void meshlet_builder::build(mesh_data &mesh)
+{
+  if (mesh.lods.empty())
+  {
+    mesh_lod lod = { 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0,
+        0 };
+    mesh.lods.push_back(lod);
+  }
+
+  mesh.meshlets.clear();
+  std::vector<uint32_t> ordered;
+  for (auto &lod : mesh.lods)
+  {
+    ordered.clear();
+    lod.first_meshlet = static_cast<uint32_t>(mesh.meshlets.size());
+    build_level(mesh.vertices, mesh.indices.data() + lod.first_index,
+                lod.index_count, lod.first_index, ordered, mesh.meshlets);
+    lod.meshlet_count = static_cast<uint32_t>(mesh.meshlets.size())
+        - lod.first_meshlet;
+
+    std::copy(ordered.begin(), ordered.end(),
+              mesh.indices.begin() + lod.first_index);
+  }
+}
+
+void meshlet_builder::compute_bounds(const std::vector<mesh_vertex> &vertices,
+                                     const uint32_t *indices,
+                                     uint32_t index_count, meshlet &bounds)
+{
+  // the centroid of the corners is close enough to the smallest sphere for
+  // clusters this size
+  glm::vec3 center(0.0f);
+  for (uint32_t i = 0; i < index_count; i++)
+  {
+    center = center + vertices[indices[i]].position;
+  }
+  if (index_count > 0)
+  {
+    center = center * (1.0f / index_count);
+  }
+
+  float radius = 0.0f;
+  for (uint32_t i = 0; i < index_count; i++)
+  {
+    radius = std::max(radius,
+                      glm::length(vertices[indices[i]].position - center));
+  }
+
+  std::vector<glm::vec3> normals;
+  glm::vec3 axis(0.0f);
+  for (uint32_t i = 0; i + 2 < index_count; i += 3)
+  {
+    const auto &a = vertices[indices[i]].position;
+    const auto &b = vertices[indices[i + 1]].position;
+    const auto &c = vertices[indices[i + 2]].position;
+
+    auto normal = glm::cross(b - a, c - a);
+    auto length = glm::length(normal);
+    if (length > 0.0f)
+    {
+      normals.push_back(normal * (1.0f / length));
+      axis = axis + normals.back();
+    }
+  }
+
+  bounds.center = center;
+  bounds.radius = radius;
+  bounds.cone_axis = glm::vec3(0.0f);
+  bounds.cone_cutoff = 1.0f;
+
+  auto axis_length = glm::length(axis);
+  if (normals.empty() || axis_length == 0.0f)
+  {
+    return;
+  }
+  axis = axis * (1.0f / axis_length);
+
+  float min_dot = 1.0f;
+  for (const auto &normal : normals)
+  {
+    min_dot = std::min(min_dot, glm::dot(axis, normal));
+  }
+
+  // a spread of 90 degrees or more faces the camera from every direction
+  bounds.cone_axis = axis;
+  if (min_dot > 0.0f)
+  {
+    bounds.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+  }
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
@@ -0,0 +1,69 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_MESHLET_BUILDER_HPP_
+#define ASSETS_MESHLET_BUILDER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Splits the levels of detail of a mesh into meshlets, clusters of
+/// neighbouring triangles with bounds for culling them one by one. The
+/// meshlets are plain index ranges, drawn through the vertex pipeline.
+class meshlet_builder
+{
+ public:
+  /// Prevent creation of instances of this class
+  meshlet_builder() = delete;
+  ~meshlet_builder() = delete;
+  meshlet_builder(meshlet_builder &&) = delete;
+  meshlet_builder(const meshlet_builder &) = delete;
+  meshlet_builder &operator=(const meshlet_builder &) = delete;
+  meshlet_builder &operator=(meshlet_builder &&) = delete;
+
+  /// Limits of one meshlet, the sizes mesh shading hardware is built for
+  static const uint32_t MAX_VERTICES = 64;
+  static const uint32_t MAX_TRIANGLES = 124;
+
+  /// Replaces mesh.meshlets. The triangles of each level are reordered so
+  /// every meshlet is a contiguous range, keeping their order within a
+  /// meshlet. A mesh without lods gets a single one first.
+  static void build(mesh_data &mesh);
+
+  /// Bounding sphere and normal cone of a triangle list
+  static void compute_bounds(const std::vector<mesh_vertex> &vertices,
+                             const uint32_t *indices, uint32_t index_count,
+                             meshlet &bounds);
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_MESHLET_BUILDER_HPP_
@@ -0,0 +1,179 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "texture_atlas.hpp"
+#include "../util/skyline_packer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+uint32_t align_up(uint32_t value, uint32_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Copies image to x and y of a layer, surrounded by its edge texels
+void copy_with_gutter(const atlas_image &image, uint32_t x, uint32_t y,
+                      uint32_t gutter, uint32_t size, uint8_t *layer)
+{
+  auto width = static_cast<int64_t>(image.width);
+  auto height = static_cast<int64_t>(image.height);
+  auto border = static_cast<int64_t>(gutter);
+
+  for (int64_t row = -border; row < height + border; row++)
+  {
+    auto source_row = std::min(std::max(row, int64_t(0)), height - 1);
+    auto destination = layer
+        + ((y + gutter + row) * size + x + gutter - border) * 4;
+    for (int64_t column = -border; column < width + border; column++)
+    {
+      auto source_column = std::min(std::max(column, int64_t(0)), width - 1);
+      std::memcpy(destination, image.pixels
+          + (source_row * width + source_column) * 4, 4);
+      destination += 4;
+    }
+  }
+}
+
+}  // namespace
+
+const uint32_t texture_atlas::GUTTER;
+const uint32_t texture_atlas::MAX_LEVELS;
+
+atlas_data texture_atlas::build(const std::vector<atlas_image> &images,
+                                uint32_t size, bool blit_mipmaps)
+{
+  atlas_data atlas;
+  atlas.size = size;
+  atlas.num_layers = 0;
+  atlas.mip_levels = std::min(MAX_LEVELS,
+                              util::mip_chain::get_num_levels(size, size));
+  atlas.generate_mipmaps = blit_mipmaps && atlas.mip_levels > 1;
+  atlas.layer_size = 0;
+  atlas.regions.resize(images.size());
+
+  // tallest first, the skyline fills up row by row
+  std::vector<uint32_t> order(images.size());
+  for (uint32_t i = 0; i < order.size(); i++)
+  {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32_t a, uint32_t b)
+                   {
+                     return images[a].height > images[b].height;
+                   });
+
+  std::vector<std::unique_ptr<util::skyline_packer>> layers;
+  std::vector<uint32_t> positions(images.size() * 2);
+  for (auto i : order)
+  {
+    const auto &image = images[i];
+    auto width = align_up(image.width + 2 * GUTTER, GUTTER);
+    auto height = align_up(image.height + 2 * GUTTER, GUTTER);
+    if (image.width == 0 || image.height == 0 || width > size
+        || height > size)
+    {
+      throw std::runtime_error("atlas image does not fit a layer!");
+    }
+
+    uint32_t layer = 0;
+    uint32_t x, y;
+    while (layer < layers.size() && !layers[layer]->insert(width, height, x, y))
+    {
+      layer++;
+    }
+    if (layer == layers.size())
+    {
+      layers.emplace_back(new util::skyline_packer(size, size));
+      layers.back()->insert(width, height, x, y);
+    }
+
+    positions[i * 2] = x;
+    positions[i * 2 + 1] = y;
+
+    auto &region = atlas.regions[i];
+    region.scale[0] = static_cast<float>(image.width) / size;
+    region.scale[1] = static_cast<float>(image.height) / size;
+    region.offset[0] = static_cast<float>(x + GUTTER) / size;
+    region.offset[1] = static_cast<float>(y + GUTTER) / size;
+    region.layer = layer;
+    region.padding[0] = 0;
+  }
+  atlas.num_layers = static_cast<uint32_t>(layers.size());
+
+  // every layer is composed, then mipmapped down to the last level that
+  // keeps the images apart
+  std::vector<std::vector<uint8_t>> composed(
+      layers.size(), std::vector<uint8_t>(static_cast<size_t>(size) * size * 4));
+  for (uint32_t i = 0; i < images.size(); i++)
+  {
+    copy_with_gutter(images[i], positions[i * 2], positions[i * 2 + 1],
+                     GUTTER, size, composed[atlas.regions[i].layer].data());
+  }
+
+  // the GPU blits the other levels from the base level
+  if (atlas.generate_mipmaps)
+  {
+    atlas.levels.assign(1, { 0, size, size });
+    atlas.layer_size = static_cast<size_t>(size) * size * 4;
+    for (const auto &pixels : composed)
+    {
+      atlas.data.insert(atlas.data.end(), pixels.begin(), pixels.end());
+    }
+    return atlas;
+  }
+
+  auto num_levels = atlas.mip_levels;
+  for (const auto &pixels : composed)
+  {
+    std::vector<uint8_t> chain;
+    auto levels = util::mip_chain::build_rgba8(pixels.data(), size, size,
+                                               chain);
+    levels.resize(num_levels);
+    if (num_levels < util::mip_chain::get_num_levels(size, size))
+    {
+      chain.resize(levels.back().offset
+          + static_cast<size_t>(levels.back().width) * levels.back().height
+              * 4);
+    }
+
+    atlas.levels = levels;
+    atlas.layer_size = chain.size();
+    atlas.data.insert(atlas.data.end(), chain.begin(), chain.end());
+  }
+
+  return atlas;
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
@@ -0,0 +1,111 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_TEXTURE_ATLAS_HPP_
+#define ASSETS_TEXTURE_ATLAS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../util/mip_chain.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// An RGBA8 image to pack, width * height * 4 bytes
+struct atlas_image
+{
+  uint32_t width;
+  uint32_t height;
+  const uint8_t *pixels;
+};
+
+/// Where an image ended up. Its texture coordinates map to
+/// uv * scale + offset in layer. Matches AtlasRegion in
+/// shaders/texture_atlas.glsl.
+struct atlas_region
+{
+  float scale[2];
+  float offset[2];
+  uint32_t layer;
+  uint32_t padding[1];
+};
+
+static_assert(sizeof(atlas_region) == 24,
+              "atlas_region must match the std430 stride of AtlasRegion");
+
+/// Square RGBA8 layers of a 2D array texture, each with the same levels.
+/// Level j of layer i is at i * layer_size + levels[j].offset in data.
+struct atlas_data
+{
+  uint32_t size;
+  uint32_t num_layers;
+  /// levels of the image to create
+  uint32_t mip_levels;
+  /// levels holds the base level only, the rest is blitted on the GPU
+  bool generate_mipmaps;
+  std::vector<util::mip_level> levels;
+  size_t layer_size;
+  std::vector<uint8_t> data;
+  /// one per image, in the order they were given
+  std::vector<atlas_region> regions;
+};
+
+/// Packs many small images into few array layers, so they share one image,
+/// view and descriptor. The images are placed with util::skyline_packer,
+/// tallest first, in the first layer with room.
+class texture_atlas
+{
+ public:
+  /// Prevent creation of instances of this class
+  texture_atlas() = delete;
+  ~texture_atlas() = delete;
+  texture_atlas(texture_atlas &&) = delete;
+  texture_atlas(const texture_atlas &) = delete;
+  texture_atlas &operator=(const texture_atlas &) = delete;
+  texture_atlas &operator=(texture_atlas &&) = delete;
+
+  /// Texels of each image's edge repeated around it, so filtering does not
+  /// bleed in from its neighbours. Images are also placed on multiples of
+  /// it.
+  static const uint32_t GUTTER = 4;
+
+  /// Levels whose texels do not straddle two images, 1 + log2(GUTTER)
+  static const uint32_t MAX_LEVELS = 3;
+
+  /// Packs images into layers of size by size texels
+  ///
+  /// @param[in] blit_mipmaps leave the levels below the base to the GPU
+  ///
+  /// return the layers with their mip levels, and where each image is
+  static atlas_data build(const std::vector<atlas_image> &images,
+                          uint32_t size, bool blit_mipmaps = false);
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_TEXTURE_ATLAS_HPP_
@@ -0,0 +1,433 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "texture_decoder.hpp"
+
+#include <stb_image.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+bool has_extension(const std::string &file_name, const std::string &extension)
+{
+  return file_name.size() >= extension.size()
+      && file_name.compare(file_name.size() - extension.size(),
+                           extension.size(), extension) == 0;
+}
+
+}  // namespace
+
+texture_decoder::texture_decoder(uint32_t num_threads, size_t max_decoded,
+                                 std::function<bool(VkFormat)> can_sample,
+                                 std::shared_ptr<asset_pack> pack,
+                                 std::shared_ptr<util::async_reader> reader,
+                                 uint32_t resident_tail_size)
+    : can_sample(can_sample),
+      pack(pack),
+      reader(reader),
+      resident_tail_size(resident_tail_size),
+      spill_file(-1),
+      spill_size(0),
+      requests(std::numeric_limits<size_t>::max()),
+      decoded(max_decoded),
+      stopping(false),
+      num_pending(0),
+      next_id(0)
+{
+  // read back like any loose file when the levels are streamed in
+  const char *directory = std::getenv("TMPDIR");
+  std::string name = std::string(directory ? directory : "/tmp")
+      + "/tobi_engine_levels_XXXXXX";
+  std::vector<char> path(name.begin(), name.end());
+  path.push_back('\0');
+  spill_file = mkstemp(path.data());
+  if (spill_file >= 0)
+  {
+    spill_file_name = path.data();
+  }
+
+  num_threads = std::max(num_threads, 1u);
+  for (uint32_t i = 0; i < num_threads; i++)
+  {
+    workers.push_back(std::thread(&texture_decoder::run, this));
+  }
+}
+
+texture_decoder::~texture_decoder()
+{
+  stopping = true;
+  requests.close();
+  decoded.close();
+
+  // completions still in flight call back into this decoder
+  if (reader)
+  {
+    reader->wait_idle();
+  }
+
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  if (spill_file >= 0)
+  {
+    close(spill_file);
+    unlink(spill_file_name.c_str());
+  }
+}
+
+uint32_t texture_decoder::request(std::vector<std::string> file_names)
+{
+  auto id = next_id++;
+
+  decode_request request;
+  request.id = id;
+  request.file_names = std::move(file_names);
+  request.candidate = 0;
+  request.loaded = false;
+
+  num_pending++;
+  schedule(std::move(request));
+  return id;
+}
+
+bool texture_decoder::try_pop(decoded_texture &texture)
+{
+  if (!decoded.try_pop(texture))
+  {
+    return false;
+  }
+
+  num_pending--;
+  return true;
+}
+
+void texture_decoder::schedule(decode_request request)
+{
+  while (!stopping && request.candidate < request.file_names.size())
+  {
+    const auto &file_name = request.file_names[request.candidate];
+
+    // the pack is decoded from its mapping, and without a reader the
+    // workers read the file themselves
+    if (!reader || (pack && pack->find(file_name)))
+    {
+      requests.push(std::move(request));
+      return;
+    }
+
+    auto size = util::async_reader::get_file_size(file_name);
+    if (size > 0)
+    {
+      auto pending = std::make_shared<decode_request>(std::move(request));
+      pending->contents.resize(static_cast<size_t>(size));
+      pending->loaded = false;
+
+      util::read_request read;
+      read.file_name = file_name;
+      read.offset = 0;
+      read.size = pending->contents.size();
+      read.destination = pending->contents.data();
+      // runs on the reader's thread, the bytes go on to the workers
+      read.on_complete = [this, pending](int64_t result)
+      {
+        if (result == static_cast<int64_t>(pending->contents.size()))
+        {
+          pending->loaded = true;
+          requests.push(std::move(*pending));
+          return;
+        }
+
+        pending->error = "failed to read "
+            + pending->file_names[pending->candidate];
+        pending->candidate++;
+        pending->contents.clear();
+        schedule(std::move(*pending));
+      };
+      reader->read(std::move(read));
+      return;
+    }
+
+    request.candidate++;
+  }
+
+  // the failure is delivered by a worker, this may run on the render thread
+  // which must never block on the decoded queue
+  requests.push(std::move(request));
+}
+
+bool texture_decoder::fail(const decode_request &request)
+{
+  decoded_texture texture;
+  texture.id = request.id;
+  texture.file_name = request.file_names.empty() ? std::string() :
+      request.file_names.back();
+  texture.format = VK_FORMAT_UNDEFINED;
+  texture.mip_levels = 0;
+  texture.source = nullptr;
+  texture.error = request.error.empty() ? "no usable texture" :
+      request.error;
+
+  return decoded.push(std::move(texture));
+}
+
+void texture_decoder::run()
+{
+  decode_request request;
+  while (!stopping && requests.pop(request))
+  {
+    if (request.candidate >= request.file_names.size())
+    {
+      if (!fail(request))
+      {
+        return;
+      }
+      continue;
+    }
+
+    decoded_texture texture;
+    if (!decode(request, texture))
+    {
+      // moves on to the next candidate, or delivers the failure
+      request.candidate++;
+      request.contents.clear();
+      request.loaded = false;
+      schedule(std::move(request));
+      continue;
+    }
+
+    // blocks while the render thread is behind on uploads
+    if (!decoded.push(std::move(texture)))
+    {
+      return;
+    }
+  }
+}
+
+bool texture_decoder::decode(decode_request &request,
+                             decoded_texture &texture)
+{
+  const auto &file_name = request.file_names[request.candidate];
+
+  texture.id = request.id;
+  texture.file_name = file_name;
+  texture.format = VK_FORMAT_UNDEFINED;
+  texture.mip_levels = 0;
+  texture.source = nullptr;
+
+  try
+  {
+    return has_extension(file_name, ".ktx2") ?
+        decode_ktx2(request, texture) : decode_image(request, texture);
+  } catch (const std::exception &error)
+  {
+    request.error = error.what();
+    return false;
+  }
+}
+
+bool texture_decoder::decode_ktx2(const decode_request &request,
+                                  decoded_texture &texture)
+{
+  const auto &file_name = request.file_names[request.candidate];
+
+  if (request.loaded)
+  {
+    ktx2_texture ktx2(
+        reinterpret_cast<const uint8_t *>(request.contents.data()),
+        request.contents.size());
+    return decode_ktx2(ktx2, false, texture);
+  }
+
+  auto entry = pack ? pack->find(file_name) : nullptr;
+  if (entry)
+  {
+    ktx2_texture ktx2(pack->get_data(*entry),
+                      static_cast<size_t>(entry->size));
+    return decode_ktx2(ktx2, true, texture);
+  }
+
+  if (!std::ifstream(file_name).good())
+  {
+    return false;
+  }
+
+  ktx2_texture ktx2(file_name);
+  return decode_ktx2(ktx2, false, texture);
+}
+
+bool texture_decoder::decode_ktx2(const ktx2_texture &ktx2, bool mapped,
+                                  decoded_texture &texture)
+{
+  if (can_sample(ktx2.get_format()))
+  {
+    // the finer levels are read again from where they are in the file, the
+    // pack outlives the decoder and keeps its mapping
+    auto file_levels = ktx2.get_file_levels();
+    auto tail_level = util::mip_chain::get_tail_level(file_levels,
+                                                      resident_tail_size);
+    texture.format = ktx2.get_format();
+    texture.levels = ktx2.get_levels(texture.data, tail_level);
+    if (mapped)
+    {
+      texture.source = ktx2.get_data();
+    } else
+    {
+      texture.source_file = texture.file_name;
+    }
+    for (uint32_t i = 0; i < tail_level; i++)
+    {
+      texture.source_offsets.push_back(file_levels[i].offset);
+    }
+  } else if (ktx2.can_transcode())
+  {
+    texture.format = ktx2.get_transcoded_format();
+    texture.levels = ktx2.transcode_rgba8(texture.data);
+    spill(texture);
+  } else
+  {
+    return false;
+  }
+
+  texture.mip_levels = ktx2.get_num_levels();
+  return true;
+}
+
+bool texture_decoder::decode_image(const decode_request &request,
+                                   decoded_texture &texture)
+{
+  const auto &file_name = request.file_names[request.candidate];
+
+  int width, height, channels;
+  stbi_uc *pixels;
+
+  auto entry = pack ? pack->find(file_name) : nullptr;
+  if (request.loaded)
+  {
+    pixels = stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc *>(request.contents.data()),
+        static_cast<int>(request.contents.size()), &width, &height,
+        &channels, STBI_rgb_alpha);
+  } else if (entry)
+  {
+    pixels = stbi_load_from_memory(pack->get_data(*entry),
+                                   static_cast<int>(entry->size), &width,
+                                   &height, &channels, STBI_rgb_alpha);
+  } else
+  {
+    pixels = stbi_load(file_name.c_str(), &width, &height, &channels,
+                       STBI_rgb_alpha);
+  }
+
+  if (!pixels)
+  {
+    throw std::runtime_error(std::string("failed to load texture image: ")
+        + stbi_failure_reason());
+  }
+
+  decode_rgba8(pixels, width, height, texture);
+  stbi_image_free(pixels);
+  return true;
+}
+
+void texture_decoder::decode_rgba8(uint8_t *pixels, int width, int height,
+                                   decoded_texture &texture)
+{
+  auto level_width = static_cast<uint32_t>(width);
+  auto level_height = static_cast<uint32_t>(height);
+
+  texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+  texture.mip_levels = util::mip_chain::get_num_levels(level_width,
+                                                       level_height);
+  texture.levels = util::mip_chain::build_rgba8(pixels, level_width,
+                                                level_height, texture.data);
+  spill(texture);
+}
+
+void texture_decoder::spill(decoded_texture &texture)
+{
+  auto tail_level = util::mip_chain::get_tail_level(texture.levels,
+                                                    resident_tail_size);
+  auto size = texture.levels[tail_level].offset;
+
+  uint64_t offset;
+  if (size > 0 && write_spill(texture.data.data(), size, offset))
+  {
+    texture.source_file = spill_file_name;
+    for (uint32_t i = 0; i < tail_level; i++)
+    {
+      texture.source_offsets.push_back(offset + texture.levels[i].offset);
+    }
+  }
+
+  // without the file the finer levels are dropped, the tail is still drawn
+  std::vector<uint8_t>(texture.data.begin() + size, texture.data.end())
+      .swap(texture.data);
+}
+
+bool texture_decoder::write_spill(const uint8_t *bytes, size_t size,
+                                  uint64_t &offset)
+{
+  if (spill_file < 0)
+  {
+    return false;
+  }
+
+  // every worker appends its own range
+  offset = spill_size.fetch_add(size);
+  size_t done = 0;
+  while (done < size)
+  {
+    auto written = pwrite(spill_file, bytes + done, size - done,
+                          static_cast<off_t>(offset + done));
+    if (written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written <= 0)
+    {
+      return false;
+    }
+    done += static_cast<size_t>(written);
+  }
+  return true;
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
@@ -0,0 +1,172 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_TEXTURE_DECODER_HPP_
+#define ASSETS_TEXTURE_DECODER_HPP_
+
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "../util/async_reader.hpp"
+#include "../util/bounded_queue.hpp"
+#include "../util/mip_chain.hpp"
+#include "ktx2_texture.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// A texture decoded on a worker thread, ready to be copied into a staging
+/// buffer
+struct decoded_texture
+{
+  uint32_t id;
+  /// the candidate that was decoded, or the last one tried on failure
+  std::string file_name;
+  VkFormat format;
+  /// levels of the image to create
+  uint32_t mip_levels;
+  /// the whole chain as if it was tightly packed, base level first
+  std::vector<util::mip_level> levels;
+  /// only the always resident tail, packed from the offset of its first
+  /// level, see util::mip_chain::get_tail_level
+  std::vector<uint8_t> data;
+  /// the finer levels are read again from this asset pack mapping if set,
+  /// else from source_file, which is empty if they were dropped
+  const uint8_t *source;
+  std::string source_file;
+  /// start of every level finer than the tail in source or source_file
+  std::vector<uint64_t> source_offsets;
+  /// empty unless none of the candidates could be decoded
+  std::string error;
+};
+
+/// Decodes textures on worker threads. Loose files are read through the
+/// async reader, whose completions hand the bytes to the workers, so no
+/// worker blocks on the disk. Finished textures wait in a bounded queue
+/// until the render thread uploads them, workers stall once it is full so
+/// decoded data never piles up faster than it is consumed.
+///
+/// Only the small levels at the end of a chain are kept in memory. KTX2
+/// files sampled as they are leave the finer levels where they are in the
+/// file or the asset pack, levels built or transcoded here are spilled to
+/// a temporary file that lives as long as the decoder.
+class texture_decoder
+{
+ public:
+  /// @param[in] num_threads worker count, at least one is started
+  /// @param[in] max_decoded textures that may wait for upload at once
+  /// @param[in] can_sample true if the device can sample a format as it is,
+  ///            called from the worker threads
+  /// @param[in] pack looked up before the file system, may be null
+  /// @param[in] reader reads loose files, if null the workers read them
+  /// @param[in] resident_tail_size levels at most this many texels wide and
+  ///            high are kept in memory
+  texture_decoder(uint32_t num_threads, size_t max_decoded,
+                  std::function<bool(VkFormat)> can_sample,
+                  std::shared_ptr<asset_pack> pack,
+                  std::shared_ptr<util::async_reader> reader,
+                  uint32_t resident_tail_size);
+  ~texture_decoder();
+  texture_decoder(texture_decoder &&) = delete;
+  texture_decoder(const texture_decoder &) = delete;
+  texture_decoder &operator=(const texture_decoder &) = delete;
+  texture_decoder &operator=(texture_decoder &&) = delete;
+
+  /// Queues a texture for decoding. The candidates are tried in order, KTX2
+  /// files are used as they are if the device can sample them, transcoded
+  /// if possible and skipped otherwise. Anything else goes through stb_image.
+  /// Candidates in the asset pack are decoded from its mapping.
+  ///
+  /// return id of the decoded_texture that will be delivered
+  uint32_t request(std::vector<std::string> file_names);
+
+  /// Takes a finished texture. Never blocks.
+  bool try_pop(decoded_texture &texture);
+
+  /// Requests that have not been popped yet
+  uint32_t get_num_pending() const
+  {
+    return num_pending;
+  }
+
+ private:
+  struct decode_request
+  {
+    uint32_t id;
+    std::vector<std::string> file_names;
+    /// index of the file tried next
+    size_t candidate;
+    /// its contents if the async reader has loaded them
+    std::vector<char> contents;
+    bool loaded;
+    std::string error;
+  };
+
+  void schedule(decode_request request);
+  bool fail(const decode_request &request);
+  void run();
+  bool decode(decode_request &request, decoded_texture &texture);
+  bool decode_ktx2(const decode_request &request, decoded_texture &texture);
+  bool decode_ktx2(const ktx2_texture &ktx2, bool mapped,
+                   decoded_texture &texture);
+  bool decode_image(const decode_request &request, decoded_texture &texture);
+  void decode_rgba8(uint8_t *pixels, int width, int height,
+                    decoded_texture &texture);
+  /// Moves the levels finer than the tail from data to the spill file
+  void spill(decoded_texture &texture);
+  bool write_spill(const uint8_t *bytes, size_t size, uint64_t &offset);
+
+  std::function<bool(VkFormat)> can_sample;
+  std::shared_ptr<asset_pack> pack;
+  std::shared_ptr<util::async_reader> reader;
+  uint32_t resident_tail_size;
+
+  /// -1 if no temporary file could be created
+  int spill_file;
+  std::string spill_file_name;
+  std::atomic<uint64_t> spill_size;
+
+  util::bounded_queue<decode_request> requests;
+  util::bounded_queue<decoded_texture> decoded;
+
+  std::atomic<bool> stopping;
+  std::atomic<uint32_t> num_pending;
+  uint32_t next_id;
+
+  std::vector<std::thread> workers;
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_TEXTURE_DECODER_HPP_
@@ -0,0 +1,146 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "vertex_layout.hpp"
+#include "../util/quantization.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace assets
+{
+namespace
+{
+
+template<typename T, size_t N>
+void store(const T (&values)[N], uint8_t *data)
+{
+  std::memcpy(data, values, sizeof(values));
+}
+
+/// Position relative to the range, [0, 1] inside the bounds
+glm::vec3 normalize_position(const mesh_vertex &vertex,
+                             const quantization_range &range)
+{
+  return glm::vec3((vertex.position.x - range.offset.x) / range.scale.x,
+                   (vertex.position.y - range.offset.y) / range.scale.y,
+                   (vertex.position.z - range.offset.z) / range.scale.z);
+}
+
+}  // namespace
+
+quantization_range quantization_range::from_vertices(
+    const std::vector<mesh_vertex> &vertices)
+{
+  quantization_range range;
+  range.offset = glm::vec3(0.0f);
+  range.scale = glm::vec3(1.0f);
+  if (vertices.empty())
+  {
+    return range;
+  }
+
+  auto minimum = vertices[0].position;
+  auto maximum = vertices[0].position;
+  for (const auto &vertex : vertices)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      minimum[axis] = std::min(minimum[axis], vertex.position[axis]);
+      maximum[axis] = std::max(maximum[axis], vertex.position[axis]);
+    }
+  }
+
+  range.offset = minimum;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    auto extent = maximum[axis] - minimum[axis];
+    range.scale[axis] = extent > 0.0f ? extent : 1.0f;
+  }
+  return range;
+}
+
+void position_float::encode(const mesh_vertex &vertex,
+                            const quantization_range &range, uint8_t *data)
+{
+  auto position = normalize_position(vertex, range);
+  float values[3] = { position.x, position.y, position.z };
+  store(values, data);
+}
+
+void position_unorm16::encode(const mesh_vertex &vertex,
+                              const quantization_range &range, uint8_t *data)
+{
+  auto position = normalize_position(vertex, range);
+  uint16_t values[4] = { util::quantization::to_unorm16(position.x),
+      util::quantization::to_unorm16(position.y),
+      util::quantization::to_unorm16(position.z), 0 };
+  store(values, data);
+}
+
+void normal_oct16::encode(const mesh_vertex &vertex,
+                          const quantization_range &, uint8_t *data)
+{
+  float u, v;
+  util::quantization::encode_octahedral(vertex.normal.x, vertex.normal.y,
+                                        vertex.normal.z, u, v);
+  int16_t values[2] = { util::quantization::to_snorm16(u),
+      util::quantization::to_snorm16(v) };
+  store(values, data);
+}
+
+void tex_coord_float::encode(const mesh_vertex &vertex,
+                             const quantization_range &, uint8_t *data)
+{
+  float values[2] = { vertex.tex_coord.x, vertex.tex_coord.y };
+  store(values, data);
+}
+
+void tex_coord_half::encode(const mesh_vertex &vertex,
+                            const quantization_range &, uint8_t *data)
+{
+  uint16_t values[2] = { util::quantization::float_to_half(vertex.tex_coord.x),
+      util::quantization::float_to_half(vertex.tex_coord.y) };
+  store(values, data);
+}
+
+void color_float::encode(const mesh_vertex &vertex,
+                         const quantization_range &, uint8_t *data)
+{
+  float values[3] = { vertex.color.x, vertex.color.y, vertex.color.z };
+  store(values, data);
+}
+
+void color_rgba8::encode(const mesh_vertex &vertex,
+                         const quantization_range &, uint8_t *data)
+{
+  uint8_t values[4] = { util::quantization::to_unorm8(vertex.color.x),
+      util::quantization::to_unorm8(vertex.color.y),
+      util::quantization::to_unorm8(vertex.color.z), 255 };
+  store(values, data);
+}
+
+}  // namespace assets
+}  // namespace tobi_engine
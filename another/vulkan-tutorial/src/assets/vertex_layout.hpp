@@ -0,0 +1,230 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef ASSETS_VERTEX_LAYOUT_HPP_
+#define ASSETS_VERTEX_LAYOUT_HPP_
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace tobi_engine
+{
+namespace assets
+{
+
+/// Bounds of a mesh's positions. Every position format stores positions
+/// relative to these, the vertex shader decodes with
+/// position = stored * scale + offset.
+struct quantization_range
+{
+  glm::vec3 offset;
+  glm::vec3 scale;
+
+  /// The bounding box of vertices. Flat axes get a scale of 1.
+  static quantization_range from_vertices(
+      const std::vector<mesh_vertex> &vertices);
+};
+
+///
+/// Vertex attribute formats. Each one has the VkFormat the GPU fetches, its
+/// SIZE in bytes, a multiple of 4, and encodes its part of a mesh_vertex.
+///
+
+/// Full precision position
+struct position_float
+{
+  static const VkFormat FORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+  static const uint32_t SIZE = 12;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+/// Position with 16 bits per axis over the mesh bounds, padded to four
+/// components since three component 16 bit vertex formats are optional
+struct position_unorm16
+{
+  static const VkFormat FORMAT = VK_FORMAT_R16G16B16A16_UNORM;
+  static const uint32_t SIZE = 8;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+/// Octahedral encoded unit normal, decode with decodeOctahedral
+struct normal_oct16
+{
+  static const VkFormat FORMAT = VK_FORMAT_R16G16_SNORM;
+  static const uint32_t SIZE = 4;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+struct tex_coord_float
+{
+  static const VkFormat FORMAT = VK_FORMAT_R32G32_SFLOAT;
+  static const uint32_t SIZE = 8;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+/// Half float texture coordinates, steps of 1/2048 or finer in [0, 1]
+struct tex_coord_half
+{
+  static const VkFormat FORMAT = VK_FORMAT_R16G16_SFLOAT;
+  static const uint32_t SIZE = 4;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+struct color_float
+{
+  static const VkFormat FORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+  static const uint32_t SIZE = 12;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+/// 8 bit color with an alpha of 1, read as a vec4
+struct color_rgba8
+{
+  static const VkFormat FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+  static const uint32_t SIZE = 4;
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data);
+};
+
+/// Offsets and encoding of a list of attributes, one after the other
+template<typename ... Attributes>
+struct vertex_attributes;
+
+template<>
+struct vertex_attributes<>
+{
+  static const uint32_t SIZE = 0;
+
+  static void describe(VkVertexInputAttributeDescription *, uint32_t,
+                       uint32_t, uint32_t)
+  {
+  }
+
+  static void encode(const mesh_vertex &, const quantization_range &,
+                     uint8_t *)
+  {
+  }
+};
+
+template<typename First, typename ... Rest>
+struct vertex_attributes<First, Rest...>
+{
+  static const uint32_t SIZE = First::SIZE + vertex_attributes<Rest...>::SIZE;
+
+  static void describe(VkVertexInputAttributeDescription *descriptions,
+                       uint32_t binding, uint32_t location, uint32_t offset)
+  {
+    descriptions->binding = binding;
+    descriptions->location = location;
+    descriptions->format = First::FORMAT;
+    descriptions->offset = offset;
+    vertex_attributes<Rest...>::describe(descriptions + 1, binding,
+                                         location + 1, offset + First::SIZE);
+  }
+
+  static void encode(const mesh_vertex &vertex,
+                     const quantization_range &range, uint8_t *data)
+  {
+    First::encode(vertex, range, data);
+    vertex_attributes<Rest...>::encode(vertex, range, data + First::SIZE);
+  }
+};
+
+///
+/// An interleaved vertex of the given attribute formats, at consecutive
+/// locations in the order listed. For example
+///
+///   vertex_layout<position_unorm16, color_rgba8, tex_coord_half>
+///
+/// is 16 bytes a vertex, the same data as float attributes take 32 for.
+/// The vertex shader declares the inputs with the matching vector sizes and
+/// decodes positions and normals with the functions in
+/// shaders/vertex_decode.glsl.
+template<typename ... Attributes>
+class vertex_layout
+{
+ public:
+  /// Bytes per vertex
+  static const uint32_t STRIDE = vertex_attributes<Attributes...>::SIZE;
+  static const uint32_t NUM_ATTRIBUTES = sizeof...(Attributes);
+
+  static_assert(NUM_ATTRIBUTES > 0, "vertex layouts need an attribute");
+  static_assert(STRIDE % 4 == 0, "vertex attributes must be 4 byte aligned");
+
+  /// Prevent creation of instances of this class
+  vertex_layout() = delete;
+  ~vertex_layout() = delete;
+  vertex_layout(vertex_layout &&) = delete;
+  vertex_layout(const vertex_layout &) = delete;
+  vertex_layout &operator=(const vertex_layout &) = delete;
+  vertex_layout &operator=(vertex_layout &&) = delete;
+
+  static VkVertexInputBindingDescription get_binding_description(
+      uint32_t binding)
+  {
+    VkVertexInputBindingDescription binding_description = {};
+    binding_description.binding = binding;
+    binding_description.stride = STRIDE;
+    binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return binding_description;
+  }
+
+  /// The attributes at first_location and up
+  static std::array<VkVertexInputAttributeDescription, NUM_ATTRIBUTES> get_attribute_descriptions(
+      uint32_t binding, uint32_t first_location)
+  {
+    std::array<VkVertexInputAttributeDescription, NUM_ATTRIBUTES> attribute_descriptions = {};
+    vertex_attributes<Attributes...>::describe(attribute_descriptions.data(),
+                                               binding, first_location, 0);
+    return attribute_descriptions;
+  }
+
+  /// Encodes vertices into a vertex buffer, STRIDE bytes each
+  static std::vector<uint8_t> encode(const std::vector<mesh_vertex> &vertices,
+                                     const quantization_range &range)
+  {
+    std::vector<uint8_t> data(vertices.size() * STRIDE);
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+      vertex_attributes<Attributes...>::encode(vertices[i], range,
+                                               data.data() + i * STRIDE);
+    }
+    return data;
+  }
+};
+
+}  // namespace assets
+}  // namespace tobi_engine
+
+#endif // ASSETS_VERTEX_LAYOUT_HPP_
@@ -23,9 +23,20 @@
 #include <sstream>
 #include <chrono>
 #include <memory>
+#include <thread>
 
 #include "util/file_handler.hpp"
 #include "util/std_functions.hpp"
+#include "util/mip_chain.hpp"
+#include "util/async_reader.hpp"
+#include "assets/asset_pack.hpp"
+#include "assets/ktx2_texture.hpp"
+#include "assets/texture_decoder.hpp"
+#include "assets/mesh_loader.hpp"
+#include "assets/vertex_layout.hpp"
+#include "assets/mesh_indices.hpp"
+#include "assets/meshlet_builder.hpp"
+#include "assets/texture_atlas.hpp"
 #include "vulkan_wrapper/vulkan_instance.hpp"
 #include "vulkan_wrapper/vulkan_surface.hpp"
 #include "vulkan_wrapper/window_handler.hpp"
@@ -34,73 +45,152 @@
 #include "vulkan_wrapper/vulkan_swap_chain.hpp"
 #include "vulkan_wrapper/vulkan_framebuffers.hpp"
 #include "vulkan_wrapper/vulkan_render_pass.hpp"
+#include "vulkan_wrapper/vulkan_timeline.hpp"
+#include "vulkan_wrapper/vulkan_deletion_queue.hpp"
+#include "vulkan_wrapper/vulkan_geometry_residency.hpp"
+#include "vulkan_wrapper/vulkan_texture_residency.hpp"
+#include "vulkan_wrapper/vulkan_indirect_draws.hpp"
+#include "vulkan_wrapper/vulkan_cluster_culling.hpp"
+#include "vulkan_wrapper/vulkan_instance_stream.hpp"
+#include "vulkan_wrapper/vulkan_hiz_pyramid.hpp"
+#include "vulkan_wrapper/vulkan_gpu_culling.hpp"
+#include "vulkan_wrapper/vulkan_push_constants.hpp"
+#include "vulkan_wrapper/vulkan_bindless_descriptors.hpp"
+#include "vulkan_wrapper/vulkan_descriptor_allocator.hpp"
+#include "vulkan_wrapper/vulkan_sampler_cache.hpp"
+#include "vulkan_wrapper/vulkan_image_view_cache.hpp"
+#include "scene/frustum.hpp"
+#include "scene/frustum_culling.hpp"
+#include "scene/lod_selection.hpp"
+#include "scene/transform_hierarchy.hpp"
 #include "vulkan_wrapper/helper.hpp"
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
+// the demo scene is a grid of copies of the mesh, each its own indirect draw
+const uint32_t SCENE_GRID_SIZE = 32;
+const uint32_t MAX_OBJECTS = SCENE_GRID_SIZE * SCENE_GRID_SIZE;
+
+// cull on the GPU (frustum + hi-z) instead of on the CPU (frustum only)
+const bool GPU_CULLING = true;
+
+// the meshlets of the objects left by either culling path are culled once
+// more on the GPU, against the frustum and their normal cones. Used where the
+// device has multiDrawIndirect, one draw per meshlet is too many otherwise.
+const bool CLUSTER_CULLING = true;
+
+// sizes of the bindless arrays, used when the device supports them
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;
+const uint32_t MAX_BINDLESS_BUFFERS = 1024;
+// what sets 0 and 1 take next to them in the fragment stage: the texture
+// atlas, and the atlas regions and texture feedback buffers
+const uint32_t RESERVED_BINDLESS_TEXTURES = 1;
+const uint32_t RESERVED_BINDLESS_BUFFERS = 2;
+
+// shaders and textures are loaded from here when it exists, see main()
+const char* ASSET_PACK_FILE = "assets.pak";
+
+// reads in flight on the io_uring, or pread threads without it
+const uint32_t FILE_READ_QUEUE_DEPTH = 64;
+const uint32_t FILE_READ_THREADS = 4;
+
+// decoded textures that may wait for upload before the decoder stalls
+const size_t MAX_DECODED_TEXTURES = 4;
+
+// the first of these that exists is drawn instead of the built-in quads. It
+// is imported once and cached next to the source as MODEL_CACHE_EXTENSION.
+const char* MODEL_FILES[] = { "models/model.glb", "models/model.obj" };
+const char* MODEL_CACHE_EXTENSION = ".tmesh";
+
+// draw meshes as triangle strips joined by primitive restart instead of lists
+const bool TRIANGLE_STRIPS = false;
+
+// a coarser level of detail is drawn once its error projects to less than
+// this many pixels
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// device memory for the vertices and indices of all levels of detail. The
+// levels the objects want are streamed in nearest first, the coarsest level
+// always stays. Raised when the full detail level does not fit next to it.
+const VkDeviceSize GEOMETRY_BUDGET = 32 * 1024 * 1024;
+const VkDeviceSize GEOMETRY_PAGE_SIZE = 64 * 1024;
+// bytes of geometry streamed in per frame
+const VkDeviceSize GEOMETRY_UPLOAD_SIZE = 4 * 1024 * 1024;
+
+// device memory for the mip levels of textures. The small levels always
+// stay, finer ones are streamed in while the fragment shaders sample them.
+const VkDeviceSize TEXTURE_BUDGET = 64 * 1024 * 1024;
+const uint32_t MAX_STREAMED_TEXTURES = 256;
+// bytes of texture levels streamed in per frame
+const VkDeviceSize TEXTURE_UPLOAD_SIZE = 8 * 1024 * 1024;
+
+// small detail textures, one image file per line, are packed into the layers
+// of one array texture. Each object modulates its texture with one of them.
+const char* ATLAS_LIST_FILE = "textures/atlas.txt";
+const uint32_t ATLAS_SIZE = 1024;
+
 namespace tobi_engine
 {
 namespace vulkan_wrapper
 {
 
-struct Vertex
-{
-  glm::vec3 pos;
-  glm::vec3 color;
-  glm::vec2 texCoord;
-
-  static VkVertexInputBindingDescription getBindingDescription()
-  {
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+// 20 bytes a vertex instead of 44 at full precision, shaders/shader.vert
+// declares the same layout
+typedef assets::vertex_layout<assets::position_unorm16, assets::color_rgba8,
+    assets::tex_coord_half, assets::normal_oct16> MeshLayout;
 
-    return bindingDescription;
-  }
-
-  static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
-  {
-    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
-
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
-
-    return attributeDescriptions;
-  }
+// uniforms are split by how often they change, one descriptor set each:
+// set 0 per frame, set 1 per view and set 2 per material. Per object data
+// comes through the instance stream. The texture atlas never changes and
+// lives in set 0 next to the frame uniforms.
+struct FrameUniforms
+{
+  float time;
+  float padding[3];
 };
 
-struct UniformBufferObject
+struct ViewUniforms
 {
-  glm::mat4 model;
   glm::mat4 view;
   glm::mat4 proj;
 };
 
-const std::vector<Vertex> vertices = { { { -0.5f, -0.5f, 0.0f }, {
-    1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } }, { { 0.5f, -0.5f, 0.0f }, {
-    0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } }, { { 0.5f, 0.5f, 0.0f }, {
-    0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } }, { { -0.5f, 0.5f, 0.0f }, {
-    1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } },
-
-{ { -0.5f, -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } }, { {
-    0.5f, -0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } }, { {
-    0.5f, 0.5f, -0.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } }, { {
-    -0.5f, 0.5f, -0.5f }, { 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } } };
+// pushed with each draw. The model matrix is applied on top of the per
+// instance transform, the texture index selects from the bindless array.
+// The position scale and offset decode the quantized mesh positions.
+struct DrawConstants
+{
+  glm::mat4 model;
+  glm::vec4 positionScale;
+  glm::vec4 positionOffset;
+  uint32_t textureIndex;
+  // the texture's counter in the streaming feedback
+  uint32_t feedbackIndex;
+};
 
-const std::vector<uint16_t> indices = { 0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4 };
+typedef vulkan_push_constants<DrawConstants> DrawPushConstants;
+
+// drawn when there is no model file
+const std::vector<assets::mesh_vertex> builtinVertices = {
+    { { -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f } },
+    { { 0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f } },
+    { { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f },
+        { 0.0f, 0.0f, 1.0f } },
+    { { -0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f },
+        { 1.0f, 1.0f, 1.0f } },
+
+    { { -0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f } },
+    { { 0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f } },
+    { { 0.5f, 0.5f, -0.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f },
+        { 0.0f, 0.0f, 1.0f } },
+    { { -0.5f, 0.5f, -0.5f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f },
+        { 1.0f, 1.0f, 1.0f } } };
+
+const std::vector<uint32_t> builtinIndices = { 0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4 };
 
 class HelloTriangleApplication
 {
@@ -118,11 +208,22 @@ class HelloTriangleApplication
   std::shared_ptr<vulkan_instance> instance;
   std::shared_ptr<vulkan_surface> surface;
 
+  // mapped for the lifetime of the application, may be null
+  std::shared_ptr<assets::asset_pack> asset_pack;
+  // loose files outside the pack are read through this
+  std::shared_ptr<util::async_reader> file_reader;
+
   std::shared_ptr<vulkan_physical_device> physical_device;
   std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_timeline> timeline;
+  std::shared_ptr<vulkan_deletion_queue> deletion_queue;
   std::shared_ptr<vulkan_swap_chain> swap_chain;
   std::shared_ptr<vulkan_framebuffers> framebuffers;
 
+  // views and samplers with equal create infos share one handle
+  std::shared_ptr<vulkan_sampler_cache> sampler_cache;
+  std::shared_ptr<vulkan_image_view_cache> image_view_cache;
+
   // make a nice struct to keep the together
   VkImage depthImage;
   VkDeviceMemory depthImageMemory;
@@ -130,33 +231,118 @@ class HelloTriangleApplication
 
   std::shared_ptr<vulkan_render_pass> render_pass;
 
-  VkDescriptorSetLayout descriptorSetLayout;
+  VkDescriptorSetLayout frameSetLayout;
+  VkDescriptorSetLayout viewSetLayout;
+  VkDescriptorSetLayout materialSetLayout;
   VkPipelineLayout pipelineLayout;
   VkPipeline graphicsPipeline;
 
   VkCommandPool commandPool;
 
-  VkImage textureImage;
-  VkDeviceMemory textureImageMemory;
+  // decodes on worker threads, finished textures are swapped in by
+  // updateTextures while the placeholder is drawn
+  std::shared_ptr<assets::texture_decoder> texture_decoder;
+  uint32_t textureRequest;
+
+  // the placeholder and then the decoded texture, whose view changes with
+  // the levels that are resident
+  std::shared_ptr<vulkan_texture_residency> texture_residency;
+  uint32_t textureId;
   VkImageView textureImageView;
   VkSampler textureSampler;
 
-  VkBuffer vertexBuffer;
-  VkDeviceMemory vertexBufferMemory;
-  VkBuffer indexBuffer;
-  VkDeviceMemory indexBufferMemory;
-
-  std::vector<VkBuffer> uniformBuffers;
-  std::vector<VkDeviceMemory> uniformBuffersMemory;
-
-  VkDescriptorPool descriptorPool;
-  std::vector<VkDescriptorSet> descriptorSets;
+  // the small textures packed into array layers, and where each of them is.
+  // Object i uses region i % atlasRegions.
+  VkImage atlasImage;
+  VkDeviceMemory atlasImageMemory;
+  VkImageView atlasImageView;
+  VkSampler atlasSampler;
+  VkBuffer atlasRegionBuffer;
+  VkDeviceMemory atlasRegionBufferMemory;
+  uint32_t atlasRegions;
+
+  // every level of detail has only the vertices it uses, encoded with
+  // MeshLayout with positions relative to meshRange. Handed over to the
+  // geometry residency.
+  std::vector<std::vector<uint8_t>> lodVertexData;
+  assets::quantization_range meshRange;
+  float meshRadius;
+  // 16 or 32 bit, whichever the full detail level needs, the same for all
+  std::vector<assets::index_data> lodIndices;
+  // index counts per level of detail, errors in the scaled mesh's units.
+  // Index ranges of levels start at 0, those of meshlets at their level's.
+  std::vector<assets::mesh_lod> meshLods;
+  std::vector<float> lodErrors;
+  // bounds in the scaled mesh's units
+  std::vector<assets::meshlet> meshlets;
+
+  // one geometry per level of detail, lodGeometries[lod]
+  std::shared_ptr<vulkan_geometry_residency> geometry_residency;
+  std::vector<uint32_t> lodGeometries;
+
+  // one block per image in a single buffer, selected by dynamic offset
+  VkBuffer frameUniformBuffer;
+  VkDeviceMemory frameUniformBufferMemory;
+  void* frameUniformData;
+  VkDeviceSize frameUniformStride;
+  float frameTime = 0.0f;
+
+  std::vector<VkBuffer> viewUniformBuffers;
+  std::vector<VkDeviceMemory> viewUniformBuffersMemory;
+  std::vector<void*> viewUniformData;
+  // last contents of each view buffer, unchanged views are not rewritten
+  std::vector<ViewUniforms> viewUniformCache;
+  std::vector<bool> viewUniformValid;
+
+  // the camera and the spinning scene root are roots of the hierarchy, the
+  // grid objects children of sceneRoot. Object world matrices go to the
+  // instance streams, the camera's to the view matrix.
+  scene::transform_hierarchy transforms;
+  uint32_t cameraNode;
+  uint32_t sceneRoot;
+  std::vector<uint32_t> objectNodes;
+
+  std::shared_ptr<vulkan_instance_stream> instance_stream;
+  std::vector<instance_transform> streamTransforms;
+  // transforms.get_version() each stream was last written at
+  std::vector<uint64_t> instanceStreamVersions;
+
+  std::shared_ptr<vulkan_indirect_draws> indirect_draws;
+
+  // bounding spheres are in the space of sceneRoot
+  std::vector<cull_object> cullObjects;
+  std::shared_ptr<vulkan_hiz_pyramid> hiz_pyramid;
+  std::shared_ptr<vulkan_gpu_culling> gpu_culling;
+  // the same spheres for the CPU path, culled into visibleObjects
+  scene::bounds_soa objectBounds;
+  std::vector<uint32_t> visibleObjects;
+  // level of detail of every object, picked each frame on either path
+  std::vector<uint8_t> objectLods;
+  std::vector<cull_range> cullRanges;
+  // meshlet culling after the object culling, drawn from cluster_draws
+  std::shared_ptr<vulkan_indirect_draws> cluster_draws;
+  std::shared_ptr<vulkan_cluster_culling> cluster_culling;
+  std::vector<cluster_instance> clusterInstances;
+  // the pyramid holds the depth of the last submitted frame, seen through this
+  glm::mat4 previousViewProjection;
+  bool hizValid = false;
+
+  std::shared_ptr<vulkan_descriptor_allocator> descriptor_allocator;
+  VkDescriptorSet frameDescriptorSet;
+  VkDescriptorSet materialDescriptorSet;
+
+  // replaces the material set when supported, textures are then selected
+  // with DrawConstants::textureIndex instead of by binding a set
+  std::shared_ptr<vulkan_bindless_descriptors> bindless_descriptors;
+  uint32_t textureIndex = 0;
 
   std::vector<VkCommandBuffer> commandBuffers;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
-  std::vector<VkFence> inFlightFences;
+  // timeline values signalled by the last submission using a frame slot / swap chain image
+  std::vector<uint64_t> frameTimelineValues;
+  std::vector<uint64_t> imageTimelineValues;
   size_t currentFrame = 0;
 
   void initWindow()
@@ -166,19 +352,39 @@ class HelloTriangleApplication
 
   void initVulkan()
   {
+    if (std::ifstream(ASSET_PACK_FILE).good())
+    {
+      asset_pack = std::make_shared<assets::asset_pack>(ASSET_PACK_FILE);
+    }
+    file_reader = std::make_shared<util::async_reader>(FILE_READ_QUEUE_DEPTH,
+                                                       FILE_READ_THREADS);
+
     instance = std::make_shared<vulkan_instance>();
     surface = std::make_shared<vulkan_surface>(window, instance);
     physical_device = std::make_shared<vulkan_physical_device>(instance,
                                                                surface);
     device = std::make_shared<vulkan_device>(physical_device, instance);
+    timeline = std::make_shared<vulkan_timeline>(device);
+    deletion_queue = std::make_shared<vulkan_deletion_queue>(timeline);
+    sampler_cache = std::make_shared<vulkan_sampler_cache>(device,
+                                                           physical_device);
+    image_view_cache = std::make_shared<vulkan_image_view_cache>(device);
     swap_chain = std::make_shared<vulkan_swap_chain>(window, device,
                                                      physical_device,
                                                      surface);
     render_pass = std::make_shared<vulkan_render_pass>(device, swap_chain,
                                                        physical_device);
 
+    if (vulkan_bindless_descriptors::is_supported(device))
+    {
+      bindless_descriptors = std::make_shared<vulkan_bindless_descriptors>(
+          device, physical_device, MAX_BINDLESS_TEXTURES,
+          MAX_BINDLESS_BUFFERS, RESERVED_BINDLESS_TEXTURES,
+          RESERVED_BINDLESS_BUFFERS);
+    }
+
     // These are connected, and there should be one for each rendering technique(shader program)
-    createDescriptorSetLayout();
+    createDescriptorSetLayouts();
     createGraphicsPipeline();
     createCommandPool();
 
@@ -188,19 +394,29 @@ class HelloTriangleApplication
                                                          render_pass,
                                                          depthImageView);
     // a class for textures
+    createTextureDecoder();
     createTextureImage();
     createTextureImageView();
     createTextureSampler();
+    createTextureAtlas();
 
     // a class for vertexbuffers (including index buffer). models/objects should be linked to a vertexbuffer
-    createVertexBuffer();
-    createIndexBuffer();
+    loadMesh();
+    createGeometryResidency();
 
     // a class for uniform buffer (should inherit from buffer class, same as vertexbuffers)
     createUniformBuffers();
 
+    createScene();
+    createInstanceStream();
+    indirect_draws = std::make_shared<vulkan_indirect_draws>(
+        device, physical_device, MAX_OBJECTS, swap_chain->get_num_images());
+    createCulling();
+    createClusterCulling();
+
     // these should be connected to the pipeline/program as well (probably as a part of them?).
-    createDescriptorPool();
+    descriptor_allocator = std::make_shared<vulkan_descriptor_allocator>(
+        device, MAX_FRAMES_IN_FLIGHT);
     createDescriptorSets();
     createCommandBuffers();
     createSyncObjects();
@@ -232,7 +448,15 @@ class HelloTriangleApplication
 
   void cleanup()
   {
-    vkDestroyImageView(device->get_device(), depthImageView, nullptr);
+    texture_decoder.reset();
+    file_reader.reset();
+    // the residency's uploads are retired with command buffers of its pool
+    deletion_queue->flush();
+    geometry_residency.reset();
+    texture_residency.reset();
+    deletion_queue.reset();
+
+    image_view_cache->release(depthImageView);
     vkDestroyImage(device->get_device(), depthImage, nullptr);
     vkFreeMemory(device->get_device(), depthImageMemory, nullptr);
 
@@ -243,28 +467,44 @@ class HelloTriangleApplication
     vkDestroyPipeline(device->get_device(), graphicsPipeline, nullptr);
     vkDestroyPipelineLayout(device->get_device(), pipelineLayout, nullptr);
 
-    vkDestroySampler(device->get_device(), textureSampler, nullptr);
-    vkDestroyImageView(device->get_device(), textureImageView, nullptr);
+    sampler_cache->release(textureSampler);
 
-    vkDestroyImage(device->get_device(), textureImage, nullptr);
-    vkFreeMemory(device->get_device(), textureImageMemory, nullptr);
+    image_view_cache->release(atlasImageView);
+    sampler_cache->release(atlasSampler);
+    vkDestroyImage(device->get_device(), atlasImage, nullptr);
+    vkFreeMemory(device->get_device(), atlasImageMemory, nullptr);
+    vkDestroyBuffer(device->get_device(), atlasRegionBuffer, nullptr);
+    vkFreeMemory(device->get_device(), atlasRegionBufferMemory, nullptr);
 
-    vkDestroyDescriptorPool(device->get_device(), descriptorPool, nullptr);
+    descriptor_allocator.reset();
 
-    vkDestroyDescriptorSetLayout(device->get_device(), descriptorSetLayout,
+    vkDestroyDescriptorSetLayout(device->get_device(), frameSetLayout,
                                  nullptr);
+    vkDestroyDescriptorSetLayout(device->get_device(), viewSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device->get_device(), materialSetLayout,
+                                 nullptr);
+
+    vkUnmapMemory(device->get_device(), frameUniformBufferMemory);
+    vkDestroyBuffer(device->get_device(), frameUniformBuffer, nullptr);
+    vkFreeMemory(device->get_device(), frameUniformBufferMemory, nullptr);
 
-    for (size_t i = 0; i < uniformBuffers.size(); i++)
+    for (size_t i = 0; i < viewUniformBuffers.size(); i++)
     {
-      vkDestroyBuffer(device->get_device(), uniformBuffers[i], nullptr);
-      vkFreeMemory(device->get_device(), uniformBuffersMemory[i], nullptr);
+      vkUnmapMemory(device->get_device(), viewUniformBuffersMemory[i]);
+      vkDestroyBuffer(device->get_device(), viewUniformBuffers[i], nullptr);
+      vkFreeMemory(device->get_device(), viewUniformBuffersMemory[i], nullptr);
     }
 
-    vkDestroyBuffer(device->get_device(), indexBuffer, nullptr);
-    vkFreeMemory(device->get_device(), indexBufferMemory, nullptr);
+    instance_stream.reset();
+    bindless_descriptors.reset();
+    sampler_cache.reset();
+    image_view_cache.reset();
 
-    vkDestroyBuffer(device->get_device(), vertexBuffer, nullptr);
-    vkFreeMemory(device->get_device(), vertexBufferMemory, nullptr);
+    gpu_culling.reset();
+    hiz_pyramid.reset();
+    cluster_culling.reset();
+    cluster_draws.reset();
+    indirect_draws.reset();
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -272,11 +512,13 @@ class HelloTriangleApplication
                          nullptr);
       vkDestroySemaphore(device->get_device(), imageAvailableSemaphores[i],
                          nullptr);
-      vkDestroyFence(device->get_device(), inFlightFences[i], nullptr);
     }
 
     vkDestroyCommandPool(device->get_device(), commandPool, nullptr);
 
+    timeline.reset();
+    asset_pack.reset();
+
   }
 
   // TODO:54708-149
@@ -284,26 +526,60 @@ class HelloTriangleApplication
   {
     window->wait_for_window();
 
-    device->wait_idle();
+    // frames in flight may still use the old resources, so they are retired
+    // at the last submitted value instead of draining the device
+    auto retireValue = timeline->get_last_value();
+    auto vkDevice = device->get_device();
 
-    vkDestroyImageView(device->get_device(), depthImageView, nullptr);
-    vkDestroyImage(device->get_device(), depthImage, nullptr);
-    vkFreeMemory(device->get_device(), depthImageMemory, nullptr);
+    auto oldDepthImageView = depthImageView;
+    auto oldDepthImage = depthImage;
+    auto oldDepthImageMemory = depthImageMemory;
+    auto viewCache = image_view_cache;
+    deletion_queue->retire(retireValue, [=]()
+    {
+      viewCache->release(oldDepthImageView);
+      vkDestroyImage(vkDevice, oldDepthImage, nullptr);
+      vkFreeMemory(vkDevice, oldDepthImageMemory, nullptr);
+    });
 
+    deletion_queue->retire_object(retireValue, framebuffers);
     framebuffers.reset();
-    swap_chain.reset();
 
-    vkFreeCommandBuffers(device->get_device(), commandPool,
-                         static_cast<uint32_t>(commandBuffers.size()),
-                         commandBuffers.data());
+    auto oldCommandPool = commandPool;
+    auto oldCommandBuffers = commandBuffers;
+    auto oldGraphicsPipeline = graphicsPipeline;
+    auto oldPipelineLayout = pipelineLayout;
+    deletion_queue->retire(retireValue, [=]()
+    {
+      vkFreeCommandBuffers(vkDevice, oldCommandPool,
+                           static_cast<uint32_t>(oldCommandBuffers.size()),
+                           oldCommandBuffers.data());
+      vkDestroyPipeline(vkDevice, oldGraphicsPipeline, nullptr);
+      vkDestroyPipelineLayout(vkDevice, oldPipelineLayout, nullptr);
+    });
+
+    deletion_queue->retire_object(retireValue, render_pass);
+    render_pass.reset();
 
-    vkDestroyPipeline(device->get_device(), graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(device->get_device(), pipelineLayout, nullptr);
+    // the pyramid is sized after the depth buffer
+    deletion_queue->retire_object(retireValue, gpu_culling);
+    deletion_queue->retire_object(retireValue, hiz_pyramid);
+    gpu_culling.reset();
+    hiz_pyramid.reset();
 
-    render_pass.reset();
+    auto oldSwapChain = swap_chain;
     swap_chain = std::make_shared<vulkan_swap_chain>(window, device,
                                                      physical_device,
-                                                     surface);
+                                                     surface, oldSwapChain);
+
+    // uniform buffers, instance streams, draw lists and feedback slots are
+    // indexed by image and sized for the first swap chain
+    if (swap_chain->get_num_images() != oldSwapChain->get_num_images())
+    {
+      throw std::runtime_error("swap chain image count changed!");
+    }
+    deletion_queue->retire_object(retireValue, oldSwapChain);
+    oldSwapChain.reset();
 
     render_pass = std::make_shared<vulkan_render_pass>(device, swap_chain,
                                                        physical_device);
@@ -313,49 +589,70 @@ class HelloTriangleApplication
     framebuffers = std::make_shared<vulkan_framebuffers>(device,swap_chain,
                                                          render_pass,
                                                          depthImageView);
+    createCulling();
     createCommandBuffers();
   }
 
-  void createDescriptorSetLayout()
+  void createDescriptorSetLayout(VkDescriptorType type,
+                                 VkShaderStageFlags stages,
+                                 VkDescriptorSetLayout& layout)
+  {
+    createDescriptorSetLayout({ { 0, type, 1, stages, nullptr } }, layout);
+  }
+
+  void createDescriptorSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+      VkDescriptorSetLayout& layout)
   {
-    VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-    uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.pImmutableSamplers = nullptr;
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-    VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-    samplerLayoutBinding.binding = 1;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.descriptorType =
-        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
-        uboLayoutBinding, samplerLayoutBinding };
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
     layoutInfo.pBindings = bindings.data();
 
     if (vkCreateDescriptorSetLayout(device->get_device(), &layoutInfo, nullptr,
-                                    &descriptorSetLayout) != VK_SUCCESS)
+                                    &layout) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to create descriptor set layout!");
     }
   }
 
+  void createDescriptorSetLayouts()
+  {
+    // the frame uniforms, the texture atlas and its regions
+    createDescriptorSetLayout(
+        { { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            nullptr },
+          { 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+            VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+          { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+            VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } },
+        frameSetLayout);
+    // the camera, and the region the view's texture feedback goes to
+    createDescriptorSetLayout(
+        { { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT,
+            nullptr },
+          { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+            VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } },
+        viewSetLayout);
+    // the bindless set brings its own layout
+    materialSetLayout = VK_NULL_HANDLE;
+    if (!bindless_descriptors)
+    {
+      createDescriptorSetLayout(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                VK_SHADER_STAGE_FRAGMENT_BIT,
+                                materialSetLayout);
+    }
+  }
+
   void createGraphicsPipeline()
   {
-    auto vertShaderCode = tobi_engine::util::file_handler::read_binary_file(
-        "shaders/vert.spv");
-    auto fragShaderCode = tobi_engine::util::file_handler::read_binary_file(
-        "shaders/frag.spv");
+    // the bindless variant indexes the texture array with the push constant
+    auto fragShaderFile = bindless_descriptors ? "shaders/frag_bindless.spv"
+        : "shaders/frag.spv";
 
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+    VkShaderModule vertShaderModule = loadShaderModule("shaders/vert.spv");
+    VkShaderModule fragShaderModule = loadShaderModule(fragShaderFile);
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
     vertShaderStageInfo.sType =
@@ -378,20 +675,34 @@ class HelloTriangleApplication
     vertexInputInfo.sType =
         VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    // binding 0 is the mesh, binding 1 the per instance transforms
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions = {
+        MeshLayout::get_binding_description(0),
+        vulkan_instance_stream::get_binding_description(1) };
+
+    auto vertexAttributes = MeshLayout::get_attribute_descriptions(0, 0);
+    auto instanceAttributes = vulkan_instance_stream::get_attribute_descriptions(
+        1, MeshLayout::NUM_ATTRIBUTES);
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(
+        vertexAttributes.begin(), vertexAttributes.end());
+    attributeDescriptions.insert(attributeDescriptions.end(),
+                                 instanceAttributes.begin(),
+                                 instanceAttributes.end());
+
+    vertexInputInfo.vertexBindingDescriptionCount =
+        static_cast<uint32_t>(bindingDescriptions.size());
     vertexInputInfo.vertexAttributeDescriptionCount =
         static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
     inputAssembly.sType =
         VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    inputAssembly.topology = TRIANGLE_STRIPS
+        ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP
+        : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = TRIANGLE_STRIPS ? VK_TRUE : VK_FALSE;
 
     VkViewport viewport = {};
     viewport.x = 0.0f;
@@ -459,8 +770,18 @@ class HelloTriangleApplication
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    // ordered from least to most frequently rebound
+    std::array<VkDescriptorSetLayout, 3> setLayouts = { frameSetLayout,
+        viewSetLayout, bindless_descriptors ? bindless_descriptors->get_layout()
+            : materialSetLayout };
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts
+        .size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    auto pushConstantRange = DrawPushConstants::get_range(
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        physical_device);
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
     if (vkCreatePipelineLayout(device->get_device(), &pipelineLayoutInfo,
                                nullptr, &pipelineLayout) != VK_SUCCESS)
@@ -503,6 +824,8 @@ class HelloTriangleApplication
     VkCommandPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphics_family;
+    // the command buffer of an image is recorded again every frame
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     if (vkCreateCommandPool(device->get_device(), &poolInfo, nullptr,
                             &commandPool) != VK_SUCCESS)
@@ -518,13 +841,14 @@ class HelloTriangleApplication
     helper::create_image(swap_chain->get_extent().width,
                         swap_chain->get_extent().height, depthFormat,
                         VK_IMAGE_TILING_OPTIMAL,
-                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                            | VK_IMAGE_USAGE_SAMPLED_BIT,
                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage,
                         depthImageMemory, device->get_device(),
                         physical_device->get_physical_device());
-    depthImageView = helper::create_image_view(depthImage, depthFormat,
-                                             VK_IMAGE_ASPECT_DEPTH_BIT,
-                                             device->get_device());
+    depthImageView = image_view_cache->acquire(
+        helper::get_image_view_create_info(depthImage, depthFormat,
+                                           VK_IMAGE_ASPECT_DEPTH_BIT));
 
     transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED,
                           VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
@@ -554,19 +878,31 @@ class HelloTriangleApplication
   {
     vkEndCommandBuffer(commandBuffer);
 
+    uint64_t signalValue = timeline->next_value();
+    VkSemaphore signalSemaphore = timeline->get_semaphore();
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signalSemaphore;
 
     vkQueueSubmit(device->get_graphics_queue(), 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device->get_graphics_queue());
+    timeline->wait(signalValue);
 
     vkFreeCommandBuffers(device->get_device(), commandPool, 1, &commandBuffer);
   }
 
   void transitionImageLayout(VkImage image, VkFormat format,
-                             VkImageLayout oldLayout, VkImageLayout newLayout)
+                             VkImageLayout oldLayout, VkImageLayout newLayout,
+                             uint32_t mipLevels = 1, uint32_t layers = 1)
   {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
@@ -592,9 +928,9 @@ class HelloTriangleApplication
     }
 
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.layerCount = layers;
 
     VkPipelineStageFlags sourceStage;
     VkPipelineStageFlags destinationStage;
@@ -673,61 +1009,134 @@ class HelloTriangleApplication
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT
         || format == VK_FORMAT_D24_UNORM_S8_UINT;
   }
+  void createTextureDecoder()
+  {
+    auto enabledFeatures = device->get_enabled_features();
+    auto physicalDevice = physical_device->get_physical_device();
+
+    // block compressed formats need their feature enabled on top of the
+    // format support, everything else is transcoded or skipped
+    auto canSample = [=](VkFormat format)
+    {
+      bool featureEnabled = true;
+      switch (assets::ktx2_texture::get_family(format))
+      {
+        case assets::compression_family::bc:
+          featureEnabled = enabledFeatures.textureCompressionBC == VK_TRUE;
+          break;
+        case assets::compression_family::etc2:
+          featureEnabled = enabledFeatures.textureCompressionETC2 == VK_TRUE;
+          break;
+        case assets::compression_family::astc:
+          featureEnabled =
+              enabledFeatures.textureCompressionASTC_LDR == VK_TRUE;
+          break;
+        case assets::compression_family::none:
+          break;
+      }
+      return featureEnabled
+          && helper::supports_sampled_format(format, physicalDevice);
+    };
+
+    // the render thread keeps one core, the rest decode. Mip chains are
+    // built on the CPU, only the tail the residency keeps stays in memory.
+    auto numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    texture_decoder = std::make_shared<assets::texture_decoder>(
+        numThreads, MAX_DECODED_TEXTURES, canSample, asset_pack,
+        file_reader, vulkan_texture_residency::RESIDENT_TAIL_SIZE);
+
+    // pre-compressed textures are preferred, the JPEG is decoded only when
+    // there is none or the device can neither sample nor transcode it
+    textureRequest = texture_decoder->request(
+        { "textures/texture.ktx2", "textures/texture.jpg" });
+  }
+
   void createTextureImage()
   {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load("textures/texture.jpg", &texWidth, &texHeight,
-                                &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
+    texture_residency = std::make_shared<vulkan_texture_residency>(
+        device, physical_device, timeline, deletion_queue, image_view_cache,
+        file_reader, TEXTURE_BUDGET, MAX_STREAMED_TEXTURES,
+        swap_chain->get_num_images(), TEXTURE_UPLOAD_SIZE);
+
+    // a grey placeholder is bound until the decoded texture lands
+    std::vector<uint8_t> placeholder(4, 128);
+    textureId = texture_residency->add(
+        VK_FORMAT_R8G8B8A8_UNORM, { { 0, 1, 1 } }, placeholder,
+        vulkan_texture_residency::texture_source {});
+  }
 
-    if (!pixels)
+  void updateTextures()
+  {
+    // levels come and go with the feedback read so far
+    if (texture_residency->update())
     {
-      throw std::runtime_error("failed to load texture image!");
+      rebindTexture();
     }
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
+    // at most one upload per frame, the rest waits in the decoder's queue
+    assets::decoded_texture texture;
+    if (!texture_decoder->try_pop(texture) || texture.id != textureRequest)
+    {
+      return;
+    }
 
-    void* data;
-    vkMapMemory(device->get_device(), stagingBufferMemory, 0, imageSize, 0,
-                &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device->get_device(), stagingBufferMemory);
+    if (!texture.error.empty())
+    {
+      std::cerr << "failed to decode " << texture.file_name << ": "
+          << texture.error << std::endl;
+      return;
+    }
 
-    stbi_image_free(pixels);
+    // only the tail is uploaded now, finer levels are read from the pack
+    // mapping or the file when the feedback asks for them
+    vulkan_texture_residency::texture_source source;
+    source.mapping = texture.source;
+    source.file_name = std::move(texture.source_file);
+    source.offsets = std::move(texture.source_offsets);
+
+    // frames in flight still sample the placeholder, the residency retires
+    // it at the last submitted value
+    auto placeholderId = textureId;
+    textureId = texture_residency->add(texture.format,
+                                       std::move(texture.levels),
+                                       texture.data, std::move(source));
+    texture_residency->remove(placeholderId);
+    rebindTexture();
+  }
 
-    helper::create_image(
-        texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory,
-        device->get_device(), physical_device->get_physical_device());
+  // the texture's view was replaced, so is its descriptor
+  void rebindTexture()
+  {
+    auto retireValue = timeline->get_last_value();
 
-    transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM,
-                          VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(stagingBuffer, textureImage,
-                      static_cast<uint32_t>(texWidth),
-                      static_cast<uint32_t>(texHeight));
-    transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    auto oldImageView = textureImageView;
+    createTextureImageView();
 
-    vkDestroyBuffer(device->get_device(), stagingBuffer, nullptr);
-    vkFreeMemory(device->get_device(), stagingBufferMemory, nullptr);
+    if (bindless_descriptors)
+    {
+      auto oldTextureIndex = textureIndex;
+      auto bindless = bindless_descriptors;
+      deletion_queue->retire(retireValue, [=]()
+      {
+        bindless->remove_image(oldTextureIndex);
+      });
+    } else if (oldImageView != textureImageView)
+    {
+      // the old view is destroyed with the old image, and its handle may
+      // come back for a later view
+      auto allocator = descriptor_allocator;
+      deletion_queue->retire(retireValue, [=]()
+      {
+        allocator->invalidate_image_view(oldImageView);
+      });
+    }
+    // the next recorded frame binds the new set and pushes the new index
+    createMaterialDescriptorSet();
   }
 
   void createTextureImageView()
   {
-    textureImageView = helper::create_image_view(textureImage,
-                                               VK_FORMAT_R8G8B8A8_UNORM,
-                                               VK_IMAGE_ASPECT_COLOR_BIT,
-                                               device->get_device());
+    textureImageView = texture_residency->get_image_view(textureId);
   }
 
   void createTextureSampler()
@@ -746,240 +1155,674 @@ class HelloTriangleApplication
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    // not clamped to the levels, so every texture shares the sampler however
+    // many of its levels are resident
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
-    if (vkCreateSampler(device->get_device(), &samplerInfo, nullptr,
-                        &textureSampler) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to create texture sampler!");
-    }
+    textureSampler = sampler_cache->acquire(samplerInfo);
   }
 
-  void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
-                         uint32_t height)
+  void createTextureAtlas()
   {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    std::vector<stbi_uc*> pixels;
+    std::vector<assets::atlas_image> images;
 
-    VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset =
-    { 0, 0, 0};
-    region.imageExtent =
-    {
-      width,
-      height,
-      1
-    };
+    std::ifstream list(ATLAS_LIST_FILE);
+    std::string fileName;
+    while (std::getline(list, fileName))
+    {
+      if (fileName.empty())
+      {
+        continue;
+      }
 
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image,
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+      int width, height, channels;
+      auto data = stbi_load(fileName.c_str(), &width, &height, &channels,
+                            STBI_rgb_alpha);
+      if (!data)
+      {
+        std::cerr << "failed to load " << fileName << ": "
+            << stbi_failure_reason() << std::endl;
+        continue;
+      }
+      pixels.push_back(data);
+      images.push_back( { static_cast<uint32_t>(width),
+          static_cast<uint32_t>(height), data });
+    }
 
-    endSingleTimeCommands(commandBuffer);
-  }
+    // without any, every object is modulated with white
+    const uint8_t white[4] = { 255, 255, 255, 255 };
+    if (images.empty())
+    {
+      images.push_back( { 1, 1, white });
+    }
 
-  void createVertexBuffer()
-  {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    // the atlas is not streamed, so its levels below the base are blitted
+    // on the GPU where the format allows it
+    auto blitMipmaps = helper::supports_linear_blit(
+        VK_FORMAT_R8G8B8A8_UNORM, physical_device->get_physical_device());
+    auto atlas = assets::texture_atlas::build(images, ATLAS_SIZE, blitMipmaps);
+    for (auto data : pixels)
+    {
+      stbi_image_free(data);
+    }
+
+    auto numLevels = atlas.mip_levels;
+    helper::create_image(atlas.size, atlas.size, VK_FORMAT_R8G8B8A8_UNORM,
+                         VK_IMAGE_TILING_OPTIMAL,
+                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                             | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                             | VK_IMAGE_USAGE_SAMPLED_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlasImage,
+                         atlasImageMemory, device->get_device(),
+                         physical_device->get_physical_device(), numLevels,
+                         atlas.num_layers);
 
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
+    createBuffer(atlas.data.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                     | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 stagingBuffer, stagingBufferMemory);
 
     void* data;
-    vkMapMemory(device->get_device(), stagingBufferMemory, 0, bufferSize, 0,
-                &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
+    vkMapMemory(device->get_device(), stagingBufferMemory, 0,
+                atlas.data.size(), 0, &data);
+    std::memcpy(data, atlas.data.data(), atlas.data.size());
     vkUnmapMemory(device->get_device(), stagingBufferMemory);
 
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+    // every level of every layer is its own region of the staging buffer
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t layer = 0; layer < atlas.num_layers; layer++)
+    {
+      for (uint32_t level = 0; level < atlas.levels.size(); level++)
+      {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = layer * atlas.layer_size
+            + atlas.levels[level].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = layer;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { atlas.levels[level].width,
+            atlas.levels[level].height, 1 };
+        regions.push_back(region);
+      }
+    }
+
+    transitionImageLayout(atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
+                          VK_IMAGE_LAYOUT_UNDEFINED,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, numLevels,
+                          atlas.num_layers);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, atlasImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()),
+                           regions.data());
+    if (atlas.generate_mipmaps)
+    {
+      // ends with every level ready for sampling
+      helper::record_generate_mipmaps(commandBuffer, atlasImage, atlas.size,
+                                      atlas.size, numLevels,
+                                      atlas.num_layers);
+    }
+    endSingleTimeCommands(commandBuffer);
 
-    copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+    if (!atlas.generate_mipmaps)
+    {
+      transitionImageLayout(atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            numLevels, atlas.num_layers);
+    }
 
     vkDestroyBuffer(device->get_device(), stagingBuffer, nullptr);
     vkFreeMemory(device->get_device(), stagingBufferMemory, nullptr);
+
+    atlasImageView = image_view_cache->acquire(
+        helper::get_image_view_create_info(atlasImage,
+                                           VK_FORMAT_R8G8B8A8_UNORM,
+                                           VK_IMAGE_ASPECT_COLOR_BIT,
+                                           numLevels, atlas.num_layers,
+                                           VK_IMAGE_VIEW_TYPE_2D_ARRAY));
+
+    // the regions are read by the fragment shader, indexed by material
+    atlasRegions = static_cast<uint32_t>(atlas.regions.size());
+    VkDeviceSize regionsSize = atlas.regions.size()
+        * sizeof(assets::atlas_region);
+    createBuffer(regionsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                     | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 atlasRegionBuffer, atlasRegionBufferMemory);
+    vkMapMemory(device->get_device(), atlasRegionBufferMemory, 0,
+                regionsSize, 0, &data);
+    std::memcpy(data, atlas.regions.data(), regionsSize);
+    vkUnmapMemory(device->get_device(), atlasRegionBufferMemory);
+
+    // the gutters hold up to the last level, filtering never reaches a
+    // neighbour when the edges are clamped and anisotropy stays off
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(numLevels - 1);
+
+    atlasSampler = sampler_cache->acquire(samplerInfo);
   }
 
-  void createIndexBuffer()
+  void loadMesh()
   {
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+    auto vertices = builtinVertices;
+    auto triangles = builtinIndices;
+    std::vector<assets::mesh_lod> lods;
+    std::vector<assets::meshlet> clusters;
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
+    for (auto fileName : MODEL_FILES)
+    {
+      if (!std::ifstream(fileName).good())
+      {
+        continue;
+      }
 
-    void* data;
-    vkMapMemory(device->get_device(), stagingBufferMemory, 0, bufferSize, 0,
-                &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device->get_device(), stagingBufferMemory);
+      auto mesh = assets::mesh_loader::load_cached(
+          fileName, std::string(fileName) + MODEL_CACHE_EXTENSION);
 
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+      if (mesh.indices.empty())
+      {
+        std::cerr << fileName << " has no triangles" << std::endl;
+        break;
+      }
+      if (mesh.vertices.size() - 1
+          > physical_device->get_properties().limits.maxDrawIndexedIndexValue)
+      {
+        std::cerr << fileName << " has more vertices than the device can index"
+                  << std::endl;
+        break;
+      }
 
-    copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+      // scaled to half the grid spacing so the copies do not overlap
+      float radius = 0.0f;
+      for (const auto& vertex : mesh.vertices)
+      {
+        radius = std::max(radius, glm::length(vertex.position));
+      }
+      float scale = radius > 0.0f ? 0.75f / radius : 1.0f;
 
-    vkDestroyBuffer(device->get_device(), stagingBuffer, nullptr);
-    vkFreeMemory(device->get_device(), stagingBufferMemory, nullptr);
+      vertices = mesh.vertices;
+      for (auto& vertex : vertices)
+      {
+        vertex.position = vertex.position * scale;
+      }
+      triangles = mesh.indices;
+      lods = mesh.lods;
+      for (auto& lod : lods)
+      {
+        lod.error *= scale;
+      }
+      clusters = mesh.meshlets;
+      for (auto& cluster : clusters)
+      {
+        cluster.center = cluster.center * scale;
+        cluster.radius *= scale;
+      }
+      break;
+    }
+
+    // the built-in quads are one level of one meshlet
+    if (clusters.empty())
+    {
+      assets::mesh_data mesh;
+      mesh.vertices = vertices;
+      mesh.indices = triangles;
+      mesh.lods = lods;
+      assets::meshlet_builder::build(mesh);
+      triangles = mesh.indices;
+      lods = mesh.lods;
+      clusters = mesh.meshlets;
+    }
+    if (lods.size() > scene::MAX_LOD_LEVELS)
+    {
+      lods.resize(scene::MAX_LOD_LEVELS);
+      clusters.resize(lods.back().first_meshlet + lods.back().meshlet_count);
+    }
+
+    meshRadius = 0.0f;
+    for (const auto& vertex : vertices)
+    {
+      meshRadius = std::max(meshRadius, glm::length(vertex.position));
+    }
+
+    meshRange = assets::quantization_range::from_vertices(vertices);
+
+    // each meshlet becomes its own strips, so the ranges move. The
+    // meshlets of a level cover it without gaps.
+    if (TRIANGLE_STRIPS)
+    {
+      std::vector<uint32_t> strips;
+      for (auto& lod : lods)
+      {
+        lod.first_index = static_cast<uint32_t>(strips.size());
+        for (uint32_t i = 0; i < lod.meshlet_count; i++)
+        {
+          auto& cluster = clusters[lod.first_meshlet + i];
+          auto strip = assets::mesh_indices::to_strips(
+              std::vector<uint32_t>(
+                  triangles.begin() + cluster.first_index,
+                  triangles.begin() + cluster.first_index
+                      + cluster.index_count));
+          cluster.first_index = static_cast<uint32_t>(strips.size());
+          cluster.index_count = static_cast<uint32_t>(strip.size());
+          strips.insert(strips.end(), strip.begin(), strip.end());
+        }
+        lod.index_count = static_cast<uint32_t>(strips.size())
+            - lod.first_index;
+      }
+      triangles = strips;
+    }
+
+    // every level is streamed on its own, with its vertices renumbered in
+    // the order its indices first use them
+    std::vector<std::vector<uint32_t>> levelIndices(lods.size());
+    size_t maxVertices = 0;
+    lodVertexData.clear();
+    for (size_t lod = 0; lod < lods.size(); lod++)
+    {
+      const auto restart = assets::mesh_indices::RESTART_INDEX;
+      std::vector<uint32_t> remap(vertices.size(), restart);
+      std::vector<assets::mesh_vertex> levelVertices;
+      for (uint32_t i = 0; i < lods[lod].index_count; i++)
+      {
+        auto index = triangles[lods[lod].first_index + i];
+        if (index != restart && remap[index] == restart)
+        {
+          remap[index] = static_cast<uint32_t>(levelVertices.size());
+          levelVertices.push_back(vertices[index]);
+        }
+        levelIndices[lod].push_back(index == restart ? restart : remap[index]);
+      }
+
+      for (uint32_t i = 0; i < lods[lod].meshlet_count; i++)
+      {
+        clusters[lods[lod].first_meshlet + i].first_index -=
+            lods[lod].first_index;
+      }
+      lods[lod].first_index = 0;
+
+      maxVertices = std::max(maxVertices, levelVertices.size());
+      lodVertexData.push_back(MeshLayout::encode(levelVertices, meshRange));
+    }
+
+    lodIndices.clear();
+    for (const auto& level : levelIndices)
+    {
+      lodIndices.push_back(assets::mesh_indices::encode(level, maxVertices));
+    }
+
+    meshLods = lods;
+    meshlets = clusters;
+    lodErrors.clear();
+    for (const auto& lod : meshLods)
+    {
+      lodErrors.push_back(lod.error);
+    }
+  }
+
+  void createGeometryResidency()
+  {
+    auto indexType = lodIndices[0].type;
+    VkDeviceSize indexSize = assets::mesh_indices::get_index_size(indexType);
+    VkDeviceSize stride = MeshLayout::STRIDE;
+
+    // the pinned coarsest level and the full detail level fit at once
+    VkDeviceSize required = 0;
+    for (size_t lod : { size_t(0), meshLods.size() - 1 })
+    {
+      VkDeviceSize size = stride + lodVertexData[lod].size() + indexSize
+          + lodIndices[lod].data.size();
+      required += (size + GEOMETRY_PAGE_SIZE - 1) / GEOMETRY_PAGE_SIZE
+          * GEOMETRY_PAGE_SIZE;
+    }
+
+    geometry_residency = std::make_shared<vulkan_geometry_residency>(
+        device, physical_device, timeline, deletion_queue,
+        std::max(GEOMETRY_BUDGET, required), GEOMETRY_PAGE_SIZE,
+        static_cast<uint32_t>(stride), indexType, GEOMETRY_UPLOAD_SIZE);
+
+    lodGeometries.clear();
+    for (size_t lod = 0; lod < meshLods.size(); lod++)
+    {
+      lodGeometries.push_back(
+          geometry_residency->add(std::move(lodVertexData[lod]),
+                                  std::move(lodIndices[lod].data),
+                                  lod == meshLods.size() - 1));
+    }
+    lodVertexData.clear();
+    lodIndices.clear();
+
+    // streams in the coarsest level, every object can be drawn from now on
+    geometry_residency->update();
+    if (!geometry_residency->is_resident(lodGeometries.back()))
+    {
+      throw std::runtime_error("failed to make the coarsest level resident!");
+    }
   }
 
   void createUniformBuffers()
   {
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+    auto numImages = swap_chain->get_num_images();
+    auto vkDevice = device->get_device();
+
+    // dynamic offsets have to be aligned to the device limit
+    auto alignment = physical_device->get_properties().limits
+        .minUniformBufferOffsetAlignment;
+    frameUniformStride = sizeof(FrameUniforms);
+    if (alignment > 0)
+    {
+      frameUniformStride = (frameUniformStride + alignment - 1)
+          & ~(alignment - 1);
+    }
 
-    uniformBuffers.resize(swap_chain->get_num_images());
-    uniformBuffersMemory.resize(swap_chain->get_num_images());
+    createBuffer(
+        frameUniformStride * numImages,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frameUniformBuffer, frameUniformBufferMemory);
+    vkMapMemory(vkDevice, frameUniformBufferMemory, 0, VK_WHOLE_SIZE, 0,
+                &frameUniformData);
+
+    viewUniformBuffers.resize(numImages);
+    viewUniformBuffersMemory.resize(numImages);
+    viewUniformData.resize(numImages);
+    viewUniformCache.resize(numImages);
+    viewUniformValid.assign(numImages, false);
 
-    for (size_t i = 0; i < swap_chain->get_num_images(); i++)
+    for (size_t i = 0; i < numImages; i++)
     {
       createBuffer(
-          bufferSize,
+          sizeof(ViewUniforms),
           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
               | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-          uniformBuffers[i], uniformBuffersMemory[i]);
+          viewUniformBuffers[i], viewUniformBuffersMemory[i]);
+      vkMapMemory(vkDevice, viewUniformBuffersMemory[i], 0, VK_WHOLE_SIZE, 0,
+                  &viewUniformData[i]);
     }
   }
 
-  void createDescriptorPool()
+  void createScene()
   {
-    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = swap_chain->get_num_images();
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = swap_chain->get_num_images();
-    VkDescriptorPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = swap_chain->get_num_images();
-
-    if (vkCreateDescriptorPool(device->get_device(), &poolInfo, nullptr,
-                               &descriptorPool) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to create descriptor pool!");
+    const float spacing = 1.5f;
+    const float half_extent = (SCENE_GRID_SIZE - 1) * spacing * 0.5f;
+
+    cameraNode = transforms.add(
+        scene::transform_hierarchy::NO_PARENT,
+        glm::inverse(glm::lookAt(glm::vec3(20.0f, 20.0f, 20.0f),
+                                 glm::vec3(0.0f, 0.0f, 0.0f),
+                                 glm::vec3(0.0f, 0.0f, 1.0f))));
+    sceneRoot = transforms.add(scene::transform_hierarchy::NO_PARENT,
+                               glm::mat4(1.0f));
+
+    objectNodes.clear();
+    for (uint32_t y = 0; y < SCENE_GRID_SIZE; y++)
+    {
+      for (uint32_t x = 0; x < SCENE_GRID_SIZE; x++)
+      {
+        objectNodes.push_back(
+            transforms.add(
+                sceneRoot,
+                glm::translate(
+                    glm::mat4(1.0f),
+                    glm::vec3(x * spacing - half_extent,
+                              y * spacing - half_extent, 0.0f))));
+      }
     }
+    transforms.update();
+
+    cullObjects.clear();
+    objectBounds.clear();
+    objectBounds.reserve(objectNodes.size());
+    for (uint32_t i = 0; i < objectNodes.size(); i++)
+    {
+      // the local transforms are pure translations
+      const auto& local = transforms.get_local(objectNodes[i]);
+      cull_object object = {};
+      object.sphere[0] = local[3].x;
+      object.sphere[1] = local[3].y;
+      object.sphere[2] = local[3].z;
+      object.sphere[3] = meshRadius;
+      object.index_count = meshLods[0].index_count;
+      object.first_index = meshLods[0].first_index;
+      object.vertex_offset = 0;
+      object.first_instance = i;
+      cullObjects.push_back(object);
+
+      objectBounds.add(object.sphere[0], object.sphere[1], object.sphere[2],
+                       object.sphere[3]);
+    }
+    visibleObjects.resize(objectBounds.padded_size());
+    objectLods.resize(objectBounds.padded_size());
+    cullRanges.resize(objectBounds.size());
   }
 
-  void createDescriptorSets()
+  bool usesClusterCulling()
   {
-    std::vector<VkDescriptorSetLayout> layouts(swap_chain->get_num_images(),
-                                               descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(swap_chain
-        ->get_num_images());
-    allocInfo.pSetLayouts = layouts.data();
-
-    descriptorSets.resize(swap_chain->get_num_images());
-    if (vkAllocateDescriptorSets(device->get_device(), &allocInfo,
-                                 &descriptorSets[0]) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-
-    for (size_t i = 0; i < swap_chain->get_num_images(); i++)
-    {
-      VkDescriptorBufferInfo bufferInfo = {};
-      bufferInfo.buffer = uniformBuffers[i];
-      bufferInfo.offset = 0;
-      bufferInfo.range = sizeof(UniformBufferObject);
-
-      VkDescriptorImageInfo imageInfo = {};
-      imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      imageInfo.imageView = textureImageView;
-      imageInfo.sampler = textureSampler;
-
-      std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
-
-      descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      descriptorWrites[0].dstSet = descriptorSets[i];
-      descriptorWrites[0].dstBinding = 0;
-      descriptorWrites[0].dstArrayElement = 0;
-      descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-      descriptorWrites[0].descriptorCount = 1;
-      descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-      descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      descriptorWrites[1].dstSet = descriptorSets[i];
-      descriptorWrites[1].dstBinding = 1;
-      descriptorWrites[1].dstArrayElement = 0;
-      descriptorWrites[1].descriptorType =
-          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-      descriptorWrites[1].descriptorCount = 1;
-      descriptorWrites[1].pImageInfo = &imageInfo;
-
-      vkUpdateDescriptorSets(device->get_device(),
-                             static_cast<uint32_t>(descriptorWrites.size()),
-                             descriptorWrites.data(), 0, nullptr);
-    }
+    return CLUSTER_CULLING && device->get_enabled_features().multiDrawIndirect;
   }
 
-  void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
-                    VkMemoryPropertyFlags properties, VkBuffer& buffer,
-                    VkDeviceMemory& bufferMemory)
+  void createCulling()
   {
-    VkBufferCreateInfo bufferInfo = {};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size;
-    bufferInfo.usage = usage;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    hiz_pyramid = std::make_shared<vulkan_hiz_pyramid>(
+        device, physical_device, swap_chain->get_extent(), depthImageView);
+    // the cluster culling reads which objects are visible from the lists,
+    // so they are not compacted then
+    gpu_culling = std::make_shared<vulkan_gpu_culling>(device, physical_device,
+                                                       indirect_draws,
+                                                       hiz_pyramid,
+                                                       cullObjects,
+                                                       usesClusterCulling());
 
-    if (vkCreateBuffer(device->get_device(), &bufferInfo, nullptr, &buffer)
-        != VK_SUCCESS)
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    hiz_pyramid->record_initial_transition(commandBuffer);
+    endSingleTimeCommands(commandBuffer);
+
+    hizValid = false;
+  }
+
+  void createClusterCulling()
+  {
+    if (!usesClusterCulling())
     {
-      throw std::runtime_error("failed to create buffer!");
+      return;
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device->get_device(), buffer,
-                                  &memRequirements);
+    std::vector<cull_cluster> clusters;
+    uint32_t maxMeshlets = 0;
+    for (const auto& cluster : meshlets)
+    {
+      cull_cluster gpuCluster = {};
+      gpuCluster.sphere[0] = cluster.center.x;
+      gpuCluster.sphere[1] = cluster.center.y;
+      gpuCluster.sphere[2] = cluster.center.z;
+      gpuCluster.sphere[3] = cluster.radius;
+      gpuCluster.cone[0] = cluster.cone_axis.x;
+      gpuCluster.cone[1] = cluster.cone_axis.y;
+      gpuCluster.cone[2] = cluster.cone_axis.z;
+      gpuCluster.cone[3] = cluster.cone_cutoff;
+      gpuCluster.index_count = cluster.index_count;
+      gpuCluster.first_index = cluster.first_index;
+      clusters.push_back(gpuCluster);
+    }
+    for (const auto& lod : meshLods)
+    {
+      maxMeshlets = std::max(maxMeshlets, lod.meshlet_count);
+    }
+
+    // room for every meshlet of every object, nothing is ever dropped
+    cluster_draws = std::make_shared<vulkan_indirect_draws>(
+        device, physical_device, MAX_OBJECTS * maxMeshlets,
+        swap_chain->get_num_images());
+    // behind the GPU object culling every object is an instance, those it
+    // culled are skipped
+    cluster_culling = std::make_shared<vulkan_cluster_culling>(
+        device, physical_device, cluster_draws,
+        GPU_CULLING ? indirect_draws : nullptr, clusters, MAX_OBJECTS);
+    clusterInstances.resize(MAX_OBJECTS);
+  }
+
+  void createInstanceStream()
+  {
+    static_assert(sizeof(glm::mat4) == sizeof(instance_transform::model),
+                  "transforms are copied to the stream as they are");
+
+    instance_stream = std::make_shared<vulkan_instance_stream>(
+        device, physical_device, MAX_OBJECTS, swap_chain->get_num_images());
+
+    streamTransforms.resize(objectNodes.size());
+    instanceStreamVersions.assign(instance_stream->get_num_streams(), 0);
+    for (uint32_t i = 0; i < instance_stream->get_num_streams(); i++)
+    {
+      updateInstanceStream(i);
+    }
+  }
 
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = helper::find_memory_type(
-        memRequirements.memoryTypeBits, properties,
-        physical_device->get_physical_device());
+  // the GPU culling draws object i as instance i, so the stream holds every
+  // object in order. Only rewritten when a transform has changed since.
+  void updateInstanceStream(uint32_t currentImage)
+  {
+    if (instanceStreamVersions[currentImage] == transforms.get_version())
+    {
+      return;
+    }
 
-    if (vkAllocateMemory(device->get_device(), &allocInfo, nullptr,
-                         &bufferMemory) != VK_SUCCESS)
+    for (uint32_t i = 0; i < objectNodes.size(); i++)
     {
-      throw std::runtime_error("failed to allocate buffer memory!");
+      std::memcpy(streamTransforms[i].model,
+                  &transforms.get_world(objectNodes[i]),
+                  sizeof(streamTransforms[i].model));
+      streamTransforms[i].material = i % atlasRegions;
     }
+    instance_stream->write(currentImage, 0, streamTransforms.data(),
+                           static_cast<uint32_t>(objectNodes.size()));
 
-    vkBindBufferMemory(device->get_device(), buffer, bufferMemory, 0);
+    instanceStreamVersions[currentImage] = transforms.get_version();
   }
 
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+  void updateScene()
   {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    static auto startTime = std::chrono::high_resolution_clock::now();
 
-    VkBufferCopy copyRegion = {};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float time = std::chrono::duration<float, std::chrono::seconds::period>(
+        currentTime - startTime).count();
+    frameTime = time;
 
-    endSingleTimeCommands(commandBuffer);
+    transforms.set_local(sceneRoot,
+                         glm::rotate(glm::mat4(1.0f),
+                                     time * glm::radians(90.0f),
+                                     glm::vec3(0.0f, 0.0f, 1.0f)));
+    transforms.update();
+  }
+
+  void createDescriptorSets()
+  {
+    // sets come from the allocator's cache, asking for the same contents
+    // again returns the existing set
+    // the range covers one block, the dynamic offset picks the image's
+    descriptor_binding frameBinding = {};
+    frameBinding.binding = 0;
+    frameBinding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    frameBinding.buffer.buffer = frameUniformBuffer;
+    frameBinding.buffer.offset = 0;
+    frameBinding.buffer.range = sizeof(FrameUniforms);
+
+    descriptor_binding atlasBinding = {};
+    atlasBinding.binding = 1;
+    atlasBinding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    atlasBinding.image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    atlasBinding.image.imageView = atlasImageView;
+    atlasBinding.image.sampler = atlasSampler;
+
+    descriptor_binding regionBinding = {};
+    regionBinding.binding = 2;
+    regionBinding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    regionBinding.buffer.buffer = atlasRegionBuffer;
+    regionBinding.buffer.offset = 0;
+    regionBinding.buffer.range = VK_WHOLE_SIZE;
+
+    frameDescriptorSet = descriptor_allocator->get_cached(
+        frameSetLayout, { frameBinding, atlasBinding, regionBinding });
+
+    createMaterialDescriptorSet();
+  }
+
+  // the view set is written every frame into the frame slot's transient
+  // pools, which begin_frame resets once the slot's submission is done
+  VkDescriptorSet createViewDescriptorSet(uint32_t currentImage)
+  {
+    descriptor_binding viewBinding = {};
+    viewBinding.binding = 0;
+    viewBinding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    viewBinding.buffer.buffer = viewUniformBuffers[currentImage];
+    viewBinding.buffer.offset = 0;
+    viewBinding.buffer.range = sizeof(ViewUniforms);
+
+    descriptor_binding feedbackBinding = {};
+    feedbackBinding.binding = 1;
+    feedbackBinding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    feedbackBinding.buffer.buffer = texture_residency->get_feedback_buffer();
+    feedbackBinding.buffer.offset = texture_residency->get_feedback_offset(
+        currentImage);
+    feedbackBinding.buffer.range = texture_residency->get_feedback_range();
+
+    return descriptor_allocator->allocate_transient(
+        static_cast<uint32_t>(currentFrame), viewSetLayout,
+        { viewBinding, feedbackBinding });
+  }
+
+  void createMaterialDescriptorSet()
+  {
+    if (bindless_descriptors)
+    {
+      textureIndex = bindless_descriptors->add_image(textureImageView,
+                                                     textureSampler);
+      materialDescriptorSet = bindless_descriptors->get_descriptor_set();
+    } else
+    {
+      descriptor_binding materialBinding = {};
+      materialBinding.binding = 0;
+      materialBinding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      materialBinding.image.imageLayout =
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      materialBinding.image.imageView = textureImageView;
+      materialBinding.image.sampler = textureSampler;
+      materialDescriptorSet = descriptor_allocator->get_cached(
+          materialSetLayout, { materialBinding });
+    }
+  }
+
+  void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                    VkMemoryPropertyFlags properties, VkBuffer& buffer,
+                    VkDeviceMemory& bufferMemory)
+  {
+    helper::create_buffer(size, usage, properties, buffer, bufferMemory,
+                          device->get_device(),
+                          physical_device->get_physical_device());
   }
 
   void createCommandBuffers()
@@ -997,86 +1840,140 @@ class HelloTriangleApplication
     {
       throw std::runtime_error("failed to allocate command buffers!");
     }
+  }
 
-    for (size_t i = 0; i < commandBuffers.size(); i++)
-    {
-      VkCommandBufferBeginInfo beginInfo = {};
-      beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-      beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-
-      if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-      {
-        throw std::runtime_error("failed to begin recording command buffer!");
-      }
-
-      VkRenderPassBeginInfo renderPassInfo = {};
-      renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-      renderPassInfo.renderPass = render_pass->get_render_pass();
-      renderPassInfo.framebuffer = framebuffers->get_frame_buffer(i);
-      renderPassInfo.renderArea.offset =
-      { 0, 0};
-      renderPassInfo.renderArea.extent = swap_chain->get_extent();
-
-      std::array<VkClearValue, 2> clearValues = {};
-      clearValues[0].color =
-      { 0.0f, 0.0f, 0.0f, 1.0f};
-      clearValues[1].depthStencil =
-      { 1.0f, 0};
-
-      renderPassInfo.clearValueCount =
-          static_cast<uint32_t>(clearValues.size());
-      renderPassInfo.pClearValues = clearValues.data();
-
-      vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo,
-                           VK_SUBPASS_CONTENTS_INLINE);
-
-      vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        graphicsPipeline);
+  // records the frame drawing to imageIndex, the GPU must be done with the
+  // image's last submission
+  void recordCommandBuffer(uint32_t imageIndex,
+                           VkDescriptorSet viewDescriptorSet)
+  {
+    auto commandBuffer = commandBuffers[imageIndex];
+    vkResetCommandBuffer(commandBuffer, 0);
 
-      VkBuffer vertexBuffers[] = { vertexBuffer };
-      VkDeviceSize offsets[] = { 0 };
-      vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-      vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0,
-                           VK_INDEX_TYPE_UINT16);
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to begin recording command buffer!");
+    }
 
-      vkCmdBindDescriptorSets(commandBuffers[i],
-                              VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
-                              0, 1, &descriptorSets[i], 0, nullptr);
+    if (GPU_CULLING)
+    {
+      gpu_culling->record(commandBuffer, imageIndex);
+    }
+    if (cluster_culling)
+    {
+      cluster_culling->record(commandBuffer, imageIndex);
+    }
 
-      vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()),
-                       1, 0, 0, 0);
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = render_pass->get_render_pass();
+    renderPassInfo.framebuffer = framebuffers->get_frame_buffer(imageIndex);
+    renderPassInfo.renderArea.offset =
+    { 0, 0};
+    renderPassInfo.renderArea.extent = swap_chain->get_extent();
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color =
+    { 0.0f, 0.0f, 0.0f, 1.0f};
+    clearValues[1].depthStencil =
+    { 1.0f, 0};
+
+    renderPassInfo.clearValueCount =
+        static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+                         VK_SUBPASS_CONTENTS_INLINE);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      graphicsPipeline);
+
+    // every level of detail lives in the one buffer, draws select theirs
+    // with the first index and vertex offset
+    VkBuffer vertexBuffers[] = { geometry_residency->get_buffer() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    instance_stream->bind(commandBuffer, 1, imageIndex);
+
+    vkCmdBindIndexBuffer(commandBuffer,
+                         geometry_residency->get_buffer(), 0,
+                         geometry_residency->get_index_type());
+
+    // all three sets are bound once, the per frame data only moves its
+    // dynamic offset
+    std::array<VkDescriptorSet, 3> sets = { frameDescriptorSet,
+        viewDescriptorSet, materialDescriptorSet };
+    uint32_t frameOffset = static_cast<uint32_t>(imageIndex
+        * frameUniformStride);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipelineLayout, 0,
+                            static_cast<uint32_t>(sets.size()), sets.data(),
+                            1, &frameOffset);
+
+    DrawConstants drawConstants = {};
+    drawConstants.model = glm::mat4(1.0f);
+    drawConstants.positionScale = glm::vec4(meshRange.scale, 0.0f);
+    drawConstants.positionOffset = glm::vec4(meshRange.offset, 0.0f);
+    drawConstants.textureIndex = textureIndex;
+    drawConstants.feedbackIndex = textureId;
+    DrawPushConstants::push(
+        commandBuffer, pipelineLayout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        drawConstants);
+
+    // the draw list itself is rewritten every frame, by the culling pass
+    // or in updateDrawCommands
+    if (cluster_culling)
+    {
+      cluster_draws->record(commandBuffer, imageIndex);
+    } else
+    {
+      indirect_draws->record(commandBuffer, imageIndex);
+    }
 
-      vkCmdEndRenderPass(commandBuffers[i]);
+    vkCmdEndRenderPass(commandBuffer);
 
-      if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
+    if (GPU_CULLING)
+    {
+      VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+      if (hasStencilComponent(findDepthFormat()))
       {
-        throw std::runtime_error("failed to record command buffer!");
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
       }
+      hiz_pyramid->record_build(commandBuffer, depthImage, depthAspect);
+    }
+
+    // read_feedback reads this image's region once the timeline passes
+    texture_residency->record_feedback_barrier(commandBuffer);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to record command buffer!");
     }
   }
 
   void createSyncObjects()
   {
+    // the swap chain only accepts binary semaphores, so they are kept for
+    // acquire and present. CPU side waits go through the timeline.
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    frameTimelineValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
+    imageTimelineValues.assign(swap_chain->get_num_images(), 0);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
       if (vkCreateSemaphore(device->get_device(), &semaphoreInfo, nullptr,
                             &imageAvailableSemaphores[i]) != VK_SUCCESS
           || vkCreateSemaphore(device->get_device(), &semaphoreInfo, nullptr,
-                               &renderFinishedSemaphores[i]) != VK_SUCCESS
-          || vkCreateFence(device->get_device(), &fenceInfo, nullptr,
-                           &inFlightFences[i]) != VK_SUCCESS)
+                               &renderFinishedSemaphores[i]) != VK_SUCCESS)
       {
         throw std::runtime_error(
             "failed to create synchronization objects for a frame!");
@@ -1084,43 +1981,256 @@ class HelloTriangleApplication
     }
   }
 
-  void updateUniformBuffer(uint32_t currentImage)
+  ViewUniforms updateUniformBuffers(uint32_t currentImage)
   {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+    FrameUniforms frame = {};
+    frame.time = frameTime;
+    std::memcpy(static_cast<char*>(frameUniformData)
+                    + currentImage * frameUniformStride,
+                &frame, sizeof(frame));
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(
-        currentTime - startTime).count();
-
-    UniformBufferObject ubo = {};
-    // per model. updated when model is updated
-    ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f),
-                            glm::vec3(0.0f, 0.0f, 1.0f));
+    ViewUniforms view = {};
     // per camera (usually one). updated when camera is updated
-    ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f),
-                           glm::vec3(0.0f, 0.0f, 0.0f),
-                           glm::vec3(0.0f, 0.0f, 1.0f));
+    view.view = glm::inverse(transforms.get_world(cameraNode));
     // per window, updated when window is updated
-    ubo.proj = glm::perspective(
+    view.proj = glm::perspective(
         glm::radians(45.0f),
         swap_chain->get_extent().width
             / (float) swap_chain->get_extent().height,
-        0.1f, 10.0f);
-    ubo.proj[1][1] *= -1;
+        0.1f, 100.0f);
+    view.proj[1][1] *= -1;
 
-    void* data;
-    vkMapMemory(device->get_device(), uniformBuffersMemory[currentImage], 0,
-                sizeof(ubo), 0, &data);
-    memcpy(data, &ubo, sizeof(ubo));
-    vkUnmapMemory(device->get_device(), uniformBuffersMemory[currentImage]);
+    if (!viewUniformValid[currentImage]
+        || std::memcmp(&viewUniformCache[currentImage], &view, sizeof(view))
+            != 0)
+    {
+      std::memcpy(viewUniformData[currentImage], &view, sizeof(view));
+      viewUniformCache[currentImage] = view;
+      viewUniformValid[currentImage] = true;
+    }
+
+    return view;
+  }
+
+  void updateCulling(uint32_t currentImage, const ViewUniforms& camera)
+  {
+    glm::mat4 viewProjection = camera.proj * camera.view
+        * transforms.get_world(sceneRoot);
+    auto frustum = scene::extract_frustum(viewProjection);
+
+    cull_view view = {};
+    for (int i = 0; i < 6; i++)
+    {
+      for (int j = 0; j < 4; j++)
+      {
+        view.planes[i][j] = frustum.planes[i][j];
+      }
+    }
+    for (int column = 0; column < 4; column++)
+    {
+      for (int row = 0; row < 4; row++)
+      {
+        view.previous_view_projection[column * 4 + row] =
+            previousViewProjection[column][row];
+      }
+    }
+    view.hiz_size[0] = static_cast<float>(hiz_pyramid->get_extent().width);
+    view.hiz_size[1] = static_cast<float>(hiz_pyramid->get_extent().height);
+    view.object_count = gpu_culling->get_num_objects();
+    view.hiz_enabled = hizValid ? 1 : 0;
+    view.hiz_levels = hiz_pyramid->get_num_levels();
+
+    gpu_culling->update(currentImage, view);
+
+    // culled objects get a range too, the shader reads it only when visible
+    selectLods(camera);
+    for (uint32_t i = 0; i < cullRanges.size(); i++)
+    {
+      auto lod = objectLods[i];
+      const auto& location = geometry_residency->get_location(
+          lodGeometries[lod]);
+      cullRanges[i].index_count = meshLods[lod].index_count;
+      cullRanges[i].first_index = location.first_index;
+      cullRanges[i].vertex_offset = location.vertex_offset;
+    }
+    gpu_culling->update_ranges(currentImage, cullRanges.data(),
+                               static_cast<uint32_t>(cullRanges.size()));
+
+    // every object is an instance in the stream's order, the cluster pass
+    // skips those culled above
+    if (cluster_culling)
+    {
+      for (uint32_t i = 0; i < objectNodes.size(); i++)
+      {
+        setClusterInstance(i, i, objectLods[i]);
+      }
+      updateClusterCulling(currentImage, camera,
+                           static_cast<uint32_t>(objectNodes.size()));
+    }
+
+    previousViewProjection = viewProjection;
+  }
+
+  void setClusterInstance(uint32_t slot, uint32_t object, uint32_t lod)
+  {
+    const auto& world = transforms.get_world(objectNodes[object]);
+    auto& instance = clusterInstances[slot];
+    std::memcpy(instance.model, &world, sizeof(instance.model));
+    instance.first_cluster = meshLods[lod].first_meshlet;
+    instance.cluster_count = meshLods[lod].meshlet_count;
+    instance.instance = slot;
+    instance.scale = glm::length(glm::vec3(world[0].x, world[0].y, world[0].z));
+    const auto& location = geometry_residency->get_location(
+        lodGeometries[lod]);
+    instance.index_offset = location.first_index;
+    instance.vertex_offset = location.vertex_offset;
+  }
+
+  // the meshlet culling writes the draws itself, in world space
+  void updateClusterCulling(uint32_t currentImage, const ViewUniforms& camera,
+                            uint32_t numInstances)
+  {
+    auto worldFrustum = scene::extract_frustum(camera.proj * camera.view);
+    glm::mat4 cameraWorld = glm::inverse(camera.view);
+
+    cluster_view view = {};
+    for (int i = 0; i < 6; i++)
+    {
+      for (int j = 0; j < 4; j++)
+      {
+        view.planes[i][j] = worldFrustum.planes[i][j];
+      }
+    }
+    view.eye[0] = cameraWorld[3].x;
+    view.eye[1] = cameraWorld[3].y;
+    view.eye[2] = cameraWorld[3].z;
+    view.instance_count = numInstances;
+    cluster_culling->update(currentImage, view, clusterInstances.data());
+  }
+
+  void updateDrawCommands(uint32_t currentImage, const ViewUniforms& camera)
+  {
+    auto frustum = scene::extract_frustum(
+        camera.proj * camera.view * transforms.get_world(sceneRoot));
+    auto numVisible = scene::cull_spheres(frustum, objectBounds,
+                                          visibleObjects.data());
+    selectLods(camera);
+
+    // the visible copies are packed into the instance stream grouped by
+    // level of detail, and each level is drawn with one instanced draw
+    uint32_t lodInstances[scene::MAX_LOD_LEVELS + 1] = {};
+    for (uint32_t i = 0; i < numVisible; i++)
+    {
+      lodInstances[objectLods[visibleObjects[i]] + 1]++;
+    }
+    for (uint32_t lod = 0; lod < meshLods.size(); lod++)
+    {
+      lodInstances[lod + 1] += lodInstances[lod];
+    }
+
+    uint32_t lodEnds[scene::MAX_LOD_LEVELS];
+    std::copy(lodInstances, lodInstances + scene::MAX_LOD_LEVELS, lodEnds);
+    for (uint32_t i = 0; i < numVisible; i++)
+    {
+      auto object = visibleObjects[i];
+      auto lod = objectLods[object];
+      auto slot = lodEnds[lod]++;
+      const auto& world = transforms.get_world(objectNodes[object]);
+      std::memcpy(streamTransforms[slot].model, &world,
+                  sizeof(streamTransforms[slot].model));
+      streamTransforms[slot].material = object % atlasRegions;
+
+      if (cluster_culling)
+      {
+        setClusterInstance(slot, object, lod);
+      }
+    }
+    instance_stream->write(currentImage, 0, streamTransforms.data(),
+                           numVisible);
+
+    if (cluster_culling)
+    {
+      updateClusterCulling(currentImage, camera, numVisible);
+      return;
+    }
+
+    indirect_draws->begin(currentImage);
+
+    for (uint32_t lod = 0; lod < meshLods.size(); lod++)
+    {
+      auto instanceCount = lodInstances[lod + 1] - lodInstances[lod];
+      if (instanceCount == 0)
+      {
+        continue;
+      }
+
+      const auto& location = geometry_residency->get_location(
+          lodGeometries[lod]);
+      VkDrawIndexedIndirectCommand command = {};
+      command.indexCount = meshLods[lod].index_count;
+      command.instanceCount = instanceCount;
+      command.firstIndex = location.first_index;
+      command.vertexOffset = location.vertex_offset;
+      command.firstInstance = lodInstances[lod];
+      indirect_draws->add(command);
+    }
+
+    indirect_draws->end();
+  }
+
+  // levels of detail of all objects into objectLods, seen from the camera
+  // in the space of sceneRoot where the bounds are. The levels picked are
+  // requested from the geometry residency, nearer objects first, and each
+  // object is drawn with its level or the next coarser one that is resident.
+  void selectLods(const ViewUniforms& camera)
+  {
+    glm::mat4 cameraInScene = glm::inverse(
+        camera.view * transforms.get_world(sceneRoot));
+    glm::vec3 eye(cameraInScene[3].x, cameraInScene[3].y, cameraInScene[3].z);
+
+    auto view = scene::make_lod_view(
+        camera.proj, eye,
+        static_cast<float>(swap_chain->get_extent().height), LOD_PIXEL_ERROR);
+    scene::select_lods(view, objectBounds, lodErrors.data(),
+                       static_cast<uint32_t>(lodErrors.size()),
+                       objectLods.data());
+
+    for (uint32_t i = 0; i < cullObjects.size(); i++)
+    {
+      const auto& sphere = cullObjects[i].sphere;
+      float distance = std::max(
+          glm::length(glm::vec3(sphere[0], sphere[1], sphere[2]) - eye)
+              - sphere[3],
+          0.0f);
+      geometry_residency->request(lodGeometries[objectLods[i]],
+                                  1.0f / (1.0f + distance));
+    }
+    geometry_residency->update();
+
+    // a missing level falls back to a coarser one, the coarsest is always
+    // resident
+    uint32_t numLods = static_cast<uint32_t>(meshLods.size());
+    for (uint32_t i = 0; i < cullObjects.size(); i++)
+    {
+      uint32_t lod = objectLods[i];
+      while (lod < numLods
+          && !geometry_residency->is_resident(lodGeometries[lod]))
+      {
+        lod++;
+      }
+      objectLods[i] = static_cast<uint8_t>(std::min(lod, numLods - 1));
+    }
   }
 
   void drawFrame()
   {
-    vkWaitForFences(device->get_device(), 1, &inFlightFences[currentFrame],
-    VK_TRUE,
-                    std::numeric_limits<uint64_t>::max());
-    vkResetFences(device->get_device(), 1, &inFlightFences[currentFrame]);
+    timeline->wait(frameTimelineValues[currentFrame]);
+    // this frame slot's previous submission is done with its transient sets
+    descriptor_allocator->begin_frame(static_cast<uint32_t>(currentFrame));
+
+    deletion_queue->collect();
+
+    updateTextures();
 
     // TODO: this should be in swap_chain
     uint32_t imageIndex;
@@ -1138,10 +2248,42 @@ class HelloTriangleApplication
       throw std::runtime_error("failed to acquire swap chain image!");
     }
 
-    updateUniformBuffer(imageIndex);
+    // the image may still be rendered to by a submission from another frame slot
+    timeline->wait(imageTimelineValues[imageIndex]);
+    // that submission is done writing the image's feedback region, the next
+    // updateTextures acts on it
+    texture_residency->read_feedback(imageIndex);
+
+    updateScene();
+
+    auto camera = updateUniformBuffers(imageIndex);
+    if (GPU_CULLING)
+    {
+      updateInstanceStream(imageIndex);
+      updateCulling(imageIndex, camera);
+    } else
+    {
+      updateDrawCommands(imageIndex, camera);
+    }
+
+    recordCommandBuffer(imageIndex, createViewDescriptorSet(imageIndex));
+
+    uint64_t signalValue = timeline->next_value();
+
+    // binary semaphores ignore their value
+    uint64_t waitValues[] = { 0 };
+    uint64_t signalValues[] = { 0, signalValue };
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
 
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
 
     VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
     VkPipelineStageFlags waitStages[] = {
@@ -1153,16 +2295,22 @@ class HelloTriangleApplication
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
 
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
+    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame],
+        timeline->get_semaphore() };
+    submitInfo.signalSemaphoreCount = 2;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     if (vkQueueSubmit(device->get_graphics_queue(), 1, &submitInfo,
-                      inFlightFences[currentFrame]) != VK_SUCCESS)
+                      VK_NULL_HANDLE) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to submit draw command buffer!");
     }
 
+    frameTimelineValues[currentFrame] = signalValue;
+    imageTimelineValues[imageIndex] = signalValue;
+    // the next submission culls against the depth of this one
+    hizValid = true;
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -1188,6 +2336,21 @@ class HelloTriangleApplication
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
   }
 
+  // shaders are created straight from the asset pack when it holds them
+  VkShaderModule loadShaderModule(const std::string& fileName)
+  {
+    auto entry = asset_pack ? asset_pack->find(fileName) : nullptr;
+    if (entry)
+    {
+      return helper::create_shader_module(asset_pack->get_data(*entry),
+                                          static_cast<size_t>(entry->size),
+                                          device->get_device());
+    }
+
+    return createShaderModule(
+        tobi_engine::util::file_handler::read_binary_file(fileName));
+  }
+
   VkShaderModule createShaderModule(const std::vector<char>& code)
   {
     VkShaderModuleCreateInfo createInfo = {};
@@ -1228,8 +2391,23 @@ int launch()
   return EXIT_SUCCESS;
 }
 
-int main()
+// vulkan-tutorial --pack <pack> <files...> writes an asset pack and exits
+int main(int argc, char* argv[])
 {
+  if (argc >= 3 && std::string(argv[1]) == "--pack")
+  {
+    try
+    {
+      tobi_engine::assets::asset_pack::build(
+          argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    } catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
   return launch();
 }
 
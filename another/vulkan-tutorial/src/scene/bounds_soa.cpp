@@ -0,0 +1,117 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "bounds_soa.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+const size_t bounds_soa::BOUNDS_ALIGNMENT;
+const size_t bounds_soa::BOUNDS_LANES;
+
+bounds_soa::bounds_soa()
+    : count(0),
+      capacity(0)
+{
+}
+
+void bounds_soa::reserve(size_t new_capacity)
+{
+  new_capacity = (new_capacity + BOUNDS_LANES - 1) / BOUNDS_LANES
+      * BOUNDS_LANES;
+  if (new_capacity <= capacity)
+  {
+    return;
+  }
+
+  aligned_array* arrays[] = { &center_x, &center_y, &center_z, &radius };
+  for (auto array : arrays)
+  {
+    auto grown = allocate(new_capacity);
+    if (count > 0)
+    {
+      std::memcpy(grown.get(), array->get(), count * sizeof(float));
+    }
+    *array = std::move(grown);
+  }
+
+  // the padding is never visible
+  std::fill(center_x.get() + count, center_x.get() + new_capacity, 0.0f);
+  std::fill(center_y.get() + count, center_y.get() + new_capacity, 0.0f);
+  std::fill(center_z.get() + count, center_z.get() + new_capacity, 0.0f);
+  std::fill(radius.get() + count, radius.get() + new_capacity,
+            -std::numeric_limits<float>::infinity());
+
+  capacity = new_capacity;
+}
+
+uint32_t bounds_soa::add(float x, float y, float z, float r)
+{
+  if (count == capacity)
+  {
+    reserve(std::max<size_t>(capacity * 2, BOUNDS_LANES));
+  }
+
+  auto index = static_cast<uint32_t>(count++);
+  set(index, x, y, z, r);
+
+  return index;
+}
+
+void bounds_soa::set(uint32_t index, float x, float y, float z, float r)
+{
+  center_x.get()[index] = x;
+  center_y.get()[index] = y;
+  center_z.get()[index] = z;
+  radius.get()[index] = r;
+}
+
+void bounds_soa::clear()
+{
+  if (count > 0)
+  {
+    std::fill(radius.get(), radius.get() + count,
+              -std::numeric_limits<float>::infinity());
+  }
+  count = 0;
+}
+
+bounds_soa::aligned_array bounds_soa::allocate(size_t size)
+{
+  void *data = nullptr;
+  if (posix_memalign(&data, BOUNDS_ALIGNMENT, size * sizeof(float)) != 0)
+  {
+    throw std::bad_alloc();
+  }
+
+  return aligned_array(static_cast<float*>(data));
+}
+
+}  // namespace scene
+}  // namespace tobi_engine
@@ -0,0 +1,119 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef SCENE_BOUNDS_SOA_HPP_
+#define SCENE_BOUNDS_SOA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+///
+/// Bounding spheres stored as structure of arrays, so a culling kernel can
+/// load the same component of 8 objects with one aligned load.
+///
+/// Every array is aligned to BOUNDS_ALIGNMENT and padded to a multiple of
+/// BOUNDS_LANES. Padding slots have a radius of -infinity, which no plane
+/// test accepts, so kernels can run over the padded size without a tail.
+class bounds_soa
+{
+ public:
+  static const size_t BOUNDS_ALIGNMENT = 32;
+  static const size_t BOUNDS_LANES = 8;
+
+  bounds_soa();
+  ~bounds_soa() = default;
+  bounds_soa(bounds_soa &&) = default;
+  bounds_soa(const bounds_soa &) = delete;
+  bounds_soa &operator=(const bounds_soa &) = delete;
+  bounds_soa &operator=(bounds_soa &&) = default;
+
+  /// Grows the arrays to hold at least capacity spheres.
+  void reserve(size_t capacity);
+
+  /// Appends a sphere and returns its index.
+  uint32_t add(float x, float y, float z, float radius);
+
+  /// Overwrites sphere index.
+  void set(uint32_t index, float x, float y, float z, float radius);
+
+  void clear();
+
+  size_t size() const
+  {
+    return count;
+  }
+  /// size() rounded up to BOUNDS_LANES
+  size_t padded_size() const
+  {
+    return (count + BOUNDS_LANES - 1) / BOUNDS_LANES * BOUNDS_LANES;
+  }
+
+  const float *get_center_x() const
+  {
+    return center_x.get();
+  }
+  const float *get_center_y() const
+  {
+    return center_y.get();
+  }
+  const float *get_center_z() const
+  {
+    return center_z.get();
+  }
+  const float *get_radius() const
+  {
+    return radius.get();
+  }
+
+ private:
+
+  struct aligned_free
+  {
+    void operator()(float *data) const
+    {
+      std::free(data);
+    }
+  };
+  typedef std::unique_ptr<float, aligned_free> aligned_array;
+
+  aligned_array center_x;
+  aligned_array center_y;
+  aligned_array center_z;
+  aligned_array radius;
+
+  size_t count;
+  size_t capacity;
+
+  static aligned_array allocate(size_t size);
+};
+
+}  // namespace scene
+}  // namespace tobi_engine
+
+#endif // SCENE_BOUNDS_SOA_HPP_
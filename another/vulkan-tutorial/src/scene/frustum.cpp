@@ -0,0 +1,92 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "frustum.hpp"
+
+#include <cmath>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+namespace
+{
+
+// glm matrices are column major, m[column][row]
+glm::vec4 row(const glm::mat4 &m, int index)
+{
+  return glm::vec4(m[0][index], m[1][index], m[2][index], m[3][index]);
+}
+
+glm::vec4 combine(const glm::vec4 &a, const glm::vec4 &b, float sign)
+{
+  return glm::vec4(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z,
+                   a.w + sign * b.w);
+}
+
+glm::vec4 normalize_plane(const glm::vec4 &plane)
+{
+  float length = std::sqrt(
+      plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+  return glm::vec4(plane.x / length, plane.y / length, plane.z / length,
+                   plane.w / length);
+}
+
+}  // namespace
+
+frustum extract_frustum(const glm::mat4 &view_projection)
+{
+  auto x = row(view_projection, 0);
+  auto y = row(view_projection, 1);
+  auto z = row(view_projection, 2);
+  auto w = row(view_projection, 3);
+
+  frustum result;
+  result.planes[0] = normalize_plane(combine(w, x, 1.0f));
+  result.planes[1] = normalize_plane(combine(w, x, -1.0f));
+  result.planes[2] = normalize_plane(combine(w, y, 1.0f));
+  result.planes[3] = normalize_plane(combine(w, y, -1.0f));
+  // depth is in [0, 1], so the near plane is z itself and not w + z
+  result.planes[4] = normalize_plane(z);
+  result.planes[5] = normalize_plane(combine(w, z, -1.0f));
+
+  return result;
+}
+
+bool intersects(const frustum &frustum, const glm::vec3 &center, float radius)
+{
+  for (const auto &plane : frustum.planes)
+  {
+    if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w
+        < -radius)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace scene
+}  // namespace tobi_engine
@@ -0,0 +1,58 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef SCENE_FRUSTUM_HPP_
+#define SCENE_FRUSTUM_HPP_
+
+#include <glm/glm.hpp>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+/// The six planes bounding a view volume, in the order left, right, bottom,
+/// top, near, far. Each plane is (normal, distance) with the normal pointing
+/// inwards and normalised, so dot(normal, p) + distance is the signed distance
+/// of p to the plane.
+struct frustum
+{
+  glm::vec4 planes[6];
+};
+
+/// Extracts the planes of a view volume from a combined projection matrix
+/// (Gribb/Hartmann). The projection is expected to map depth to [0, 1].
+///
+/// @param[in] view_projection projection * view (* model for object space)
+///
+/// return frustum planes in the space the matrix transforms from
+frustum extract_frustum(const glm::mat4 &view_projection);
+
+/// Tests a bounding sphere against a frustum.
+///
+/// return false only if the sphere is entirely outside one of the planes
+bool intersects(const frustum &frustum, const glm::vec3 &center, float radius);
+
+}  // namespace scene
+}  // namespace tobi_engine
+
+#endif // SCENE_FRUSTUM_HPP_
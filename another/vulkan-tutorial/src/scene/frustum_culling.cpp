@@ -0,0 +1,227 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "frustum_culling.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRUSTUM_CULLING_X86 1
+#endif
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+namespace
+{
+
+uint32_t cull_scalar(const frustum &frustum, const bounds_soa &bounds,
+                     uint32_t *visible)
+{
+  auto x = bounds.get_center_x();
+  auto y = bounds.get_center_y();
+  auto z = bounds.get_center_z();
+  auto r = bounds.get_radius();
+
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < bounds.size(); i++)
+  {
+    bool inside = true;
+    for (const auto &plane : frustum.planes)
+    {
+      inside = inside
+          && plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w + r[i]
+              >= 0.0f;
+    }
+
+    // branchless append, the slot is overwritten when not visible
+    visible[count] = i;
+    count += inside ? 1 : 0;
+  }
+
+  return count;
+}
+
+#ifdef FRUSTUM_CULLING_X86
+
+uint32_t cull_sse2(const frustum &frustum, const bounds_soa &bounds,
+                   uint32_t *visible)
+{
+  auto x = bounds.get_center_x();
+  auto y = bounds.get_center_y();
+  auto z = bounds.get_center_z();
+  auto r = bounds.get_radius();
+
+  __m128 planes[6][4];
+  for (int p = 0; p < 6; p++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+    }
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < bounds.padded_size(); i += 4)
+  {
+    __m128 cx = _mm_load_ps(x + i);
+    __m128 cy = _mm_load_ps(y + i);
+    __m128 cz = _mm_load_ps(z + i);
+    __m128 cr = _mm_load_ps(r + i);
+
+    // all lanes start visible, every plane can only clear them
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < 6; p++)
+    {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(planes[p][0], cx),
+                     _mm_mul_ps(planes[p][1], cy)),
+          _mm_add_ps(_mm_mul_ps(planes[p][2], cz),
+                     _mm_add_ps(planes[p][3], cr)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+    }
+
+    unsigned mask = static_cast<unsigned>(_mm_movemask_ps(inside));
+    while (mask)
+    {
+      visible[count++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+
+  return count;
+}
+
+__attribute__((target("avx2,fma")))
+uint32_t cull_avx2(const frustum &frustum, const bounds_soa &bounds,
+                   uint32_t *visible)
+{
+  auto x = bounds.get_center_x();
+  auto y = bounds.get_center_y();
+  auto z = bounds.get_center_z();
+  auto r = bounds.get_radius();
+
+  __m256 planes[6][4];
+  for (int p = 0; p < 6; p++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+    }
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < bounds.padded_size(); i += 8)
+  {
+    __m256 cx = _mm256_load_ps(x + i);
+    __m256 cy = _mm256_load_ps(y + i);
+    __m256 cz = _mm256_load_ps(z + i);
+    __m256 cr = _mm256_load_ps(r + i);
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; p++)
+    {
+      __m256 distance = _mm256_fmadd_ps(
+          planes[p][0], cx,
+          _mm256_fmadd_ps(planes[p][1], cy,
+                          _mm256_fmadd_ps(planes[p][2], cz,
+                                          _mm256_add_ps(planes[p][3], cr))));
+      inside = _mm256_and_ps(inside,
+                             _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+    }
+
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+    while (mask)
+    {
+      visible[count++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+
+  return count;
+}
+
+#endif // FRUSTUM_CULLING_X86
+
+simd_level detect_simd_level()
+{
+#ifdef FRUSTUM_CULLING_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    return simd_level::avx2;
+  }
+  if (__builtin_cpu_supports("sse2"))
+  {
+    return simd_level::sse2;
+  }
+#endif
+  return simd_level::scalar;
+}
+
+}  // namespace
+
+simd_level get_simd_level()
+{
+  static const simd_level level = detect_simd_level();
+  return level;
+}
+
+uint32_t cull_spheres(const frustum &frustum, const bounds_soa &bounds,
+                      uint32_t *visible)
+{
+  return cull_spheres(frustum, bounds, visible, get_simd_level());
+}
+
+uint32_t cull_spheres(const frustum &frustum, const bounds_soa &bounds,
+                      uint32_t *visible, simd_level level)
+{
+  if (bounds.size() == 0)
+  {
+    return 0;
+  }
+
+  if (static_cast<int>(level) > static_cast<int>(get_simd_level()))
+  {
+    level = get_simd_level();
+  }
+
+  switch (level)
+  {
+#ifdef FRUSTUM_CULLING_X86
+    case simd_level::avx2:
+      return cull_avx2(frustum, bounds, visible);
+    case simd_level::sse2:
+      return cull_sse2(frustum, bounds, visible);
+#endif
+    default:
+      return cull_scalar(frustum, bounds, visible);
+  }
+}
+
+}  // namespace scene
+}  // namespace tobi_engine
@@ -0,0 +1,62 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef SCENE_FRUSTUM_CULLING_HPP_
+#define SCENE_FRUSTUM_CULLING_HPP_
+
+#include "frustum.hpp"
+#include "bounds_soa.hpp"
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+/// Instruction sets the culling kernels are written for.
+enum class simd_level
+{
+  scalar,
+  sse2,
+  avx2
+};
+
+/// The widest kernel the running CPU supports. Detected once.
+simd_level get_simd_level();
+
+/// Writes the indices of the spheres intersecting the frustum to visible,
+/// in ascending order, using the best kernel for this CPU.
+///
+/// @param[out] visible room for at least bounds.padded_size() indices
+///
+/// return number of visible spheres
+uint32_t cull_spheres(const frustum &frustum, const bounds_soa &bounds,
+                      uint32_t *visible);
+
+/// As above, with a given kernel. Levels the CPU lacks fall back to the best
+/// one it has, so every level can be benchmarked against the others.
+uint32_t cull_spheres(const frustum &frustum, const bounds_soa &bounds,
+                      uint32_t *visible, simd_level level);
+
+}  // namespace scene
+}  // namespace tobi_engine
+
+#endif // SCENE_FRUSTUM_CULLING_HPP_
@@ -0,0 +1,87 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "lod_selection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+lod_view make_lod_view(const glm::mat4 &projection, const glm::vec3 &eye,
+                       float viewport_height, float pixel_error)
+{
+  // projection[1][1] is cot(fov / 2), flipped for a Vulkan viewport
+  lod_view view;
+  view.eye = eye;
+  view.error_scale = std::abs(projection[1][1]) * viewport_height * 0.5f
+      / pixel_error;
+  return view;
+}
+
+void select_lods(const lod_view &view, const bounds_soa &bounds,
+                 const float *lod_errors, uint32_t num_lods, uint8_t *lods)
+{
+  if (num_lods == 0 || num_lods > MAX_LOD_LEVELS)
+  {
+    throw std::runtime_error("unsupported number of levels of detail!");
+  }
+
+  // level k is accepted from the distance where its error projects to the
+  // accepted pixel error
+  float thresholds[MAX_LOD_LEVELS];
+  for (uint32_t k = 1; k < num_lods; k++)
+  {
+    thresholds[k] = lod_errors[k] * view.error_scale;
+  }
+
+  auto x = bounds.get_center_x();
+  auto y = bounds.get_center_y();
+  auto z = bounds.get_center_z();
+  auto r = bounds.get_radius();
+
+  // distance - radius >= threshold is compared squared to avoid the root.
+  // Padding radii are -infinity and end up on the coarsest level.
+  for (uint32_t i = 0; i < bounds.padded_size(); i++)
+  {
+    auto dx = x[i] - view.eye.x;
+    auto dy = y[i] - view.eye.y;
+    auto dz = z[i] - view.eye.z;
+    auto distance_squared = dx * dx + dy * dy + dz * dz;
+
+    uint32_t lod = 0;
+    for (uint32_t k = 1; k < num_lods; k++)
+    {
+      auto reach = std::max(thresholds[k] + r[i], 0.0f);
+      lod += distance_squared >= reach * reach ? 1 : 0;
+    }
+    lods[i] = static_cast<uint8_t>(lod);
+  }
+}
+
+}  // namespace scene
+}  // namespace tobi_engine
@@ -0,0 +1,70 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef SCENE_LOD_SELECTION_HPP_
+#define SCENE_LOD_SELECTION_HPP_
+
+#include <glm/glm.hpp>
+
+#include "bounds_soa.hpp"
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+/// The most levels select_lods picks from.
+const uint32_t MAX_LOD_LEVELS = 8;
+
+/// Where the levels of detail are seen from, in the space the bounds are
+/// given in.
+struct lod_view
+{
+  glm::vec3 eye;
+  /// projected size in pixels of an error of 1 at distance 1, divided by
+  /// the largest error in pixels that is accepted
+  float error_scale;
+};
+
+/// @param[in] projection perspective projection the scene is drawn with
+/// @param[in] eye camera position in the space of the bounds
+/// @param[in] viewport_height height of the render target in pixels
+/// @param[in] pixel_error largest accepted screen space error, in pixels
+lod_view make_lod_view(const glm::mat4 &projection, const glm::vec3 &eye,
+                       float viewport_height, float pixel_error);
+
+/// Picks for every sphere the coarsest level whose error, projected at the
+/// distance of the sphere's closest point, stays within the accepted pixel
+/// error. Runs over the padded arrays without branches.
+///
+/// @param[in] lod_errors object space error of each level, full detail
+///            first and not decreasing
+/// @param[in] num_lods number of levels, at most MAX_LOD_LEVELS
+/// @param[out] lods room for bounds.padded_size() levels
+void select_lods(const lod_view &view, const bounds_soa &bounds,
+                 const float *lod_errors, uint32_t num_lods, uint8_t *lods);
+
+}  // namespace scene
+}  // namespace tobi_engine
+
+#endif // SCENE_LOD_SELECTION_HPP_
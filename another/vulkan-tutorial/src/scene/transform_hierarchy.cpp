@@ -0,0 +1,213 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define TRANSFORM_HIERARCHY_SSE 1
+#endif
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+const uint32_t transform_hierarchy::NO_PARENT;
+
+namespace
+{
+
+// out = a * b for column major 4x4 matrices, out must not alias a or b
+void multiply(const float *a, const float *b, float *out)
+{
+#ifdef TRANSFORM_HIERARCHY_SSE
+  __m128 a0 = _mm_loadu_ps(a);
+  __m128 a1 = _mm_loadu_ps(a + 4);
+  __m128 a2 = _mm_loadu_ps(a + 8);
+  __m128 a3 = _mm_loadu_ps(a + 12);
+
+  for (int column = 0; column < 4; column++)
+  {
+    const float *b_column = b + column * 4;
+    __m128 result = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b_column[0])),
+                   _mm_mul_ps(a1, _mm_set1_ps(b_column[1]))),
+        _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b_column[2])),
+                   _mm_mul_ps(a3, _mm_set1_ps(b_column[3]))));
+    _mm_storeu_ps(out + column * 4, result);
+  }
+#else
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      out[column * 4 + row] = a[row] * b[column * 4]
+          + a[4 + row] * b[column * 4 + 1]
+          + a[8 + row] * b[column * 4 + 2]
+          + a[12 + row] * b[column * 4 + 3];
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+transform_hierarchy::transform_hierarchy()
+    : version(0),
+      sorted(true)
+{
+}
+
+uint32_t transform_hierarchy::add(uint32_t parent, const glm::mat4 &local)
+{
+  uint32_t parent_index = NO_PARENT;
+  uint32_t depth = 0;
+  if (parent != NO_PARENT)
+  {
+    if (parent >= handle_to_index.size())
+    {
+      throw std::runtime_error("parent transform does not exist!");
+    }
+    parent_index = handle_to_index[parent];
+    depth = depths[parent_index] + 1;
+  }
+
+  // appending keeps the order as long as depths do not decrease
+  if (!depths.empty() && depth < depths.back())
+  {
+    sorted = false;
+  }
+
+  auto handle = static_cast<uint32_t>(handle_to_index.size());
+  handle_to_index.push_back(static_cast<uint32_t>(locals.size()));
+  index_to_handle.push_back(handle);
+
+  parents.push_back(parent_index);
+  depths.push_back(depth);
+  dirty.push_back(1);
+  locals.push_back(local);
+  worlds.push_back(local);
+  moved.push_back(0);
+
+  return handle;
+}
+
+void transform_hierarchy::set_local(uint32_t node, const glm::mat4 &local)
+{
+  auto index = handle_to_index[node];
+  locals[index] = local;
+  dirty[index] = 1;
+}
+
+uint32_t transform_hierarchy::update()
+{
+  if (!sorted)
+  {
+    sort_by_depth();
+  }
+
+  changed.clear();
+
+  for (size_t i = 0; i < locals.size(); i++)
+  {
+    auto parent = parents[i];
+    bool parent_moved = parent != NO_PARENT && moved[parent];
+
+    moved[i] = dirty[i] | parent_moved;
+    if (!moved[i])
+    {
+      continue;
+    }
+
+    if (parent == NO_PARENT)
+    {
+      worlds[i] = locals[i];
+    } else
+    {
+      multiply(&worlds[parent][0][0], &locals[i][0][0], &worlds[i][0][0]);
+    }
+
+    dirty[i] = 0;
+    changed.push_back(index_to_handle[i]);
+  }
+
+  if (!changed.empty())
+  {
+    version++;
+  }
+
+  return static_cast<uint32_t>(changed.size());
+}
+
+void transform_hierarchy::sort_by_depth()
+{
+  std::vector<uint32_t> order(locals.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+  {
+    return depths[a] < depths[b];
+  });
+
+  // order[new] = old, parents are remapped through the inverse
+  std::vector<uint32_t> new_index(order.size());
+  for (uint32_t i = 0; i < order.size(); i++)
+  {
+    new_index[order[i]] = i;
+  }
+
+  std::vector<uint32_t> sorted_parents(order.size());
+  std::vector<uint32_t> sorted_depths(order.size());
+  std::vector<uint8_t> sorted_dirty(order.size());
+  std::vector<glm::mat4> sorted_locals(order.size());
+  std::vector<glm::mat4> sorted_worlds(order.size());
+  std::vector<uint32_t> sorted_handles(order.size());
+
+  for (uint32_t i = 0; i < order.size(); i++)
+  {
+    auto old = order[i];
+    sorted_parents[i] =
+        parents[old] == NO_PARENT ? NO_PARENT : new_index[parents[old]];
+    sorted_depths[i] = depths[old];
+    sorted_dirty[i] = dirty[old];
+    sorted_locals[i] = locals[old];
+    sorted_worlds[i] = worlds[old];
+    sorted_handles[i] = index_to_handle[old];
+    handle_to_index[index_to_handle[old]] = i;
+  }
+
+  parents.swap(sorted_parents);
+  depths.swap(sorted_depths);
+  dirty.swap(sorted_dirty);
+  locals.swap(sorted_locals);
+  worlds.swap(sorted_worlds);
+  index_to_handle.swap(sorted_handles);
+
+  sorted = true;
+}
+
+}  // namespace scene
+}  // namespace tobi_engine
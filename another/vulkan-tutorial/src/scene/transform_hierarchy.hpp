@@ -0,0 +1,118 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef SCENE_TRANSFORM_HIERARCHY_HPP_
+#define SCENE_TRANSFORM_HIERARCHY_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace scene
+{
+
+///
+/// Parent/child transforms stored as parallel arrays sorted by depth, so a
+/// single forward pass sees every parent before its children.
+///
+/// Nodes are addressed by the handle add() returns, which stays valid when
+/// the arrays are reordered. set_local() only flags a node; update()
+/// recomputes the world matrices of flagged nodes and their subtrees and
+/// leaves everything else untouched.
+class transform_hierarchy
+{
+ public:
+  static const uint32_t NO_PARENT = ~0u;
+
+  transform_hierarchy();
+  ~transform_hierarchy() = default;
+  transform_hierarchy(transform_hierarchy &&) = delete;
+  transform_hierarchy(const transform_hierarchy &) = delete;
+  transform_hierarchy &operator=(const transform_hierarchy &) = delete;
+  transform_hierarchy &operator=(transform_hierarchy &&) = delete;
+
+  /// Adds a node below parent (or NO_PARENT for a root).
+  ///
+  /// return handle of the node
+  uint32_t add(uint32_t parent, const glm::mat4 &local);
+
+  /// Replaces the transform of node relative to its parent.
+  void set_local(uint32_t node, const glm::mat4 &local);
+
+  /// Recomputes the world matrices of changed nodes and their descendants.
+  ///
+  /// return number of world matrices recomputed
+  uint32_t update();
+
+  const glm::mat4 &get_local(uint32_t node) const
+  {
+    return locals[handle_to_index[node]];
+  }
+  /// World matrix of node as of the last update().
+  const glm::mat4 &get_world(uint32_t node) const
+  {
+    return worlds[handle_to_index[node]];
+  }
+  /// Handles of the nodes the last update() recomputed, parents first.
+  const std::vector<uint32_t> &get_changed() const
+  {
+    return changed;
+  }
+  /// Increases every time an update() changes a world matrix.
+  const uint64_t get_version() const
+  {
+    return version;
+  }
+  const size_t size() const
+  {
+    return locals.size();
+  }
+
+ private:
+
+  // indexed by position in depth order
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> depths;
+  std::vector<uint8_t> dirty;
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  std::vector<uint32_t> index_to_handle;
+
+  std::vector<uint32_t> handle_to_index;
+
+  // scratch for update(), whether a node's world changed this pass
+  std::vector<uint8_t> moved;
+  std::vector<uint32_t> changed;
+
+  uint64_t version;
+  bool sorted;
+
+  void sort_by_depth();
+};
+
+}  // namespace scene
+}  // namespace tobi_engine
+
+#endif // SCENE_TRANSFORM_HIERARCHY_HPP_
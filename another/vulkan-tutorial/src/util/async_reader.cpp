@@ -0,0 +1,430 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "async_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define TOBI_ENGINE_HAS_IO_URING
+#endif
+#endif
+
+namespace tobi_engine
+{
+namespace util
+{
+namespace
+{
+
+#ifdef TOBI_ENGINE_HAS_IO_URING
+// there is no liburing dependency, the two syscalls are all that is needed
+int io_uring_setup(unsigned entries, io_uring_params *params)
+{
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_file, unsigned to_submit, unsigned min_complete,
+                   unsigned flags)
+{
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_file, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+#endif
+
+}  // namespace
+
+async_reader::async_reader(uint32_t queue_depth, uint32_t num_threads)
+    : requests(std::numeric_limits<size_t>::max()),
+      ring_file(-1),
+      queue_depth(0),
+      sq_ring(nullptr),
+      sq_ring_size(0),
+      cq_ring(nullptr),
+      cq_ring_size(0),
+      sqes(nullptr),
+      sqes_size(0),
+      sq_head(nullptr),
+      sq_tail(nullptr),
+      sq_mask(nullptr),
+      sq_array(nullptr),
+      cq_head(nullptr),
+      cq_tail(nullptr),
+      cq_mask(nullptr),
+      cqes(nullptr),
+      num_outstanding(0)
+{
+  if (setup_io_uring(std::max(queue_depth, 1u)))
+  {
+    threads.push_back(std::thread(&async_reader::run_io_uring, this));
+    return;
+  }
+
+  num_threads = std::max(num_threads, 1u);
+  for (uint32_t i = 0; i < num_threads; i++)
+  {
+    threads.push_back(std::thread(&async_reader::run_pread, this));
+  }
+}
+
+async_reader::~async_reader()
+{
+  // the threads drain what is queued before they return
+  requests.close();
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  if (ring_file >= 0)
+  {
+    munmap(sqes, sqes_size);
+    if (cq_ring != sq_ring)
+    {
+      munmap(cq_ring, cq_ring_size);
+    }
+    munmap(sq_ring, sq_ring_size);
+    close(ring_file);
+  }
+}
+
+void async_reader::read(read_request request)
+{
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    num_outstanding++;
+  }
+  requests.push(std::move(request));
+}
+
+void async_reader::read(std::vector<read_request> requests)
+{
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    num_outstanding += requests.size();
+  }
+  for (auto &request : requests)
+  {
+    this->requests.push(std::move(request));
+  }
+}
+
+void async_reader::wait_idle()
+{
+  std::unique_lock<std::mutex> lock(idle_mutex);
+  idle.wait(lock, [this]()
+  {
+    return num_outstanding == 0;
+  });
+}
+
+int64_t async_reader::get_file_size(const std::string &file_name)
+{
+  struct stat status;
+  if (stat(file_name.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+  {
+    return -1;
+  }
+  return static_cast<int64_t>(status.st_size);
+}
+
+void async_reader::complete(read_request &request, int64_t result)
+{
+  if (request.on_complete)
+  {
+    request.on_complete(result);
+  }
+
+  std::lock_guard<std::mutex> lock(idle_mutex);
+  if (--num_outstanding == 0)
+  {
+    idle.notify_all();
+  }
+}
+
+bool async_reader::setup_io_uring(uint32_t queue_depth)
+{
+#ifdef TOBI_ENGINE_HAS_IO_URING
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+
+  int file = io_uring_setup(queue_depth, &params);
+  if (file < 0)
+  {
+    return false;
+  }
+
+  sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size = params.cq_off.cqes
+      + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap)
+  {
+    sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+  }
+
+  sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, file, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED)
+  {
+    close(file);
+    return false;
+  }
+
+  cq_ring = single_mmap ? sq_ring :
+      mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, file, IORING_OFF_CQ_RING);
+  sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  sqes = cq_ring == MAP_FAILED ? MAP_FAILED :
+      mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, file, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+    {
+      munmap(cq_ring, cq_ring_size);
+    }
+    munmap(sq_ring, sq_ring_size);
+    close(file);
+    return false;
+  }
+
+  auto sq = static_cast<uint8_t *>(sq_ring);
+  sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+  auto cq = static_cast<uint8_t *>(cq_ring);
+  cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes = cq + params.cq_off.cqes;
+
+  // every slot owns one submission entry at most, so neither ring overflows
+  this->queue_depth = params.sq_entries;
+  slots.resize(this->queue_depth);
+  for (uint32_t i = this->queue_depth; i > 0; i--)
+  {
+    free_slots.push_back(i - 1);
+  }
+
+  ring_file = file;
+  return true;
+#else
+  (void) queue_depth;
+  return false;
+#endif
+}
+
+void async_reader::run_io_uring()
+{
+#ifdef TOBI_ENGINE_HAS_IO_URING
+  read_request request;
+  while (true)
+  {
+    // sleep on the queue only while nothing is in flight, otherwise take
+    // what has arrived and go back to waiting for completions
+    bool has_request;
+    if (free_slots.size() == queue_depth)
+    {
+      if (!requests.pop(request))
+      {
+        return;
+      }
+      has_request = true;
+    } else
+    {
+      has_request = !free_slots.empty() && requests.try_pop(request);
+    }
+
+    while (has_request)
+    {
+      start(std::move(request));
+      has_request = !free_slots.empty() && requests.try_pop(request);
+    }
+
+    if (free_slots.size() == queue_depth)
+    {
+      continue;
+    }
+
+    // submits everything prepared since the last call in one batch
+    unsigned to_submit = __atomic_load_n(sq_tail, __ATOMIC_RELAXED)
+        - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    if (io_uring_enter(ring_file, to_submit, 1, IORING_ENTER_GETEVENTS) < 0
+        && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+    {
+      // the ring is unusable, fail what is in flight rather than hang
+      int error = errno;
+      for (uint32_t i = 0; i < queue_depth; i++)
+      {
+        if (std::find(free_slots.begin(), free_slots.end(), i)
+            == free_slots.end())
+        {
+          close(slots[i].file);
+          complete(slots[i].request, -error);
+          free_slots.push_back(i);
+        }
+      }
+      continue;
+    }
+
+    reap();
+  }
+#endif
+}
+
+void async_reader::start(read_request request)
+{
+  int file = open(request.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0)
+  {
+    complete(request, -errno);
+    return;
+  }
+
+  auto slot_index = free_slots.back();
+  free_slots.pop_back();
+
+  auto &slot = slots[slot_index];
+  slot.request = std::move(request);
+  slot.file = file;
+  slot.done = 0;
+  prepare(slot_index);
+}
+
+void async_reader::prepare(uint32_t slot_index)
+{
+#ifdef TOBI_ENGINE_HAS_IO_URING
+  auto &slot = slots[slot_index];
+  slot.buffer.iov_base = static_cast<uint8_t *>(slot.request.destination)
+      + slot.done;
+  slot.buffer.iov_len = slot.request.size - slot.done;
+
+  auto tail = __atomic_load_n(sq_tail, __ATOMIC_RELAXED);
+  auto index = tail & *sq_mask;
+  auto &sqe = static_cast<io_uring_sqe *>(sqes)[index];
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_READV;
+  sqe.fd = slot.file;
+  sqe.off = slot.request.offset + slot.done;
+  sqe.addr = reinterpret_cast<uint64_t>(&slot.buffer);
+  sqe.len = 1;
+  sqe.user_data = slot_index;
+
+  sq_array[index] = index;
+  // the kernel may read the entry as soon as it sees the new tail
+  __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+#else
+  (void) slot_index;
+#endif
+}
+
+uint32_t async_reader::reap()
+{
+  uint32_t num_reaped = 0;
+#ifdef TOBI_ENGINE_HAS_IO_URING
+  auto head = __atomic_load_n(cq_head, __ATOMIC_RELAXED);
+  while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+  {
+    const auto &cqe = static_cast<io_uring_cqe *>(cqes)[head & *cq_mask];
+    auto slot_index = static_cast<uint32_t>(cqe.user_data);
+    auto result = cqe.res;
+    head++;
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    num_reaped++;
+
+    auto &slot = slots[slot_index];
+    if (result > 0)
+    {
+      slot.done += static_cast<size_t>(result);
+      // short reads are continued where they stopped
+      if (slot.done < slot.request.size)
+      {
+        prepare(slot_index);
+        continue;
+      }
+    }
+
+    close(slot.file);
+    complete(slot.request,
+             result < 0 ? result : static_cast<int64_t>(slot.done));
+    slot.request = read_request();
+    free_slots.push_back(slot_index);
+  }
+#endif
+  return num_reaped;
+}
+
+void async_reader::run_pread()
+{
+  read_request request;
+  while (requests.pop(request))
+  {
+    int file = open(request.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+      complete(request, -errno);
+      continue;
+    }
+
+    int64_t result = 0;
+    size_t done = 0;
+    while (done < request.size)
+    {
+      auto bytes = pread(file, static_cast<uint8_t *>(request.destination)
+                             + done,
+                         request.size - done,
+                         static_cast<off_t>(request.offset + done));
+      if (bytes < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (bytes <= 0)
+      {
+        result = bytes < 0 ? -errno : 0;
+        break;
+      }
+      done += static_cast<size_t>(bytes);
+    }
+
+    close(file);
+    complete(request, result < 0 ? result : static_cast<int64_t>(done));
+  }
+}
+
+}  // namespace util
+}  // namespace tobi_engine
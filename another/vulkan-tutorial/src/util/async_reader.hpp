@@ -0,0 +1,139 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_ASYNC_READER_HPP__
+#define __TOBI_ENGINE_UTIL_ASYNC_READER_HPP__
+
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.hpp"
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// A read of part of a file into memory the caller owns
+struct read_request
+{
+  std::string file_name;
+  uint64_t offset;
+  size_t size;
+  /// at least size bytes, valid until on_complete has run
+  void *destination;
+  /// called on an I/O thread with the bytes read, or -errno
+  std::function<void(int64_t result)> on_complete;
+};
+
+/// Asynchronous file reads. Queued reads are submitted in batches to an
+/// io_uring, so many small reads keep the device busy without a thread per
+/// read. Where io_uring is not available (old kernels, seccomp) a pool of
+/// threads does blocking preads instead.
+class async_reader
+{
+ public:
+  /// @param[in] queue_depth reads in flight at once on the io_uring
+  /// @param[in] num_threads pread threads if io_uring cannot be used
+  async_reader(uint32_t queue_depth, uint32_t num_threads);
+  /// Finishes all queued reads first
+  ~async_reader();
+  async_reader(async_reader &&) = delete;
+  async_reader(const async_reader &) = delete;
+  async_reader &operator=(const async_reader &) = delete;
+  async_reader &operator=(async_reader &&) = delete;
+
+  void read(read_request request);
+  void read(std::vector<read_request> requests);
+
+  /// Blocks until every queued read has completed and its callback
+  /// returned
+  void wait_idle();
+
+  bool is_using_io_uring() const
+  {
+    return ring_file >= 0;
+  }
+
+  /// return size of a file in bytes, or -1 if it cannot be read
+  static int64_t get_file_size(const std::string &file_name);
+
+ private:
+  /// A read owned by the io_uring thread until its completion is reaped
+  struct io_slot
+  {
+    read_request request;
+    int file;
+    size_t done;
+    iovec buffer;
+  };
+
+  bool setup_io_uring(uint32_t queue_depth);
+  void run_io_uring();
+  void start(read_request request);
+  void prepare(uint32_t slot_index);
+  uint32_t reap();
+  void run_pread();
+  void complete(read_request &request, int64_t result);
+
+  bounded_queue<read_request> requests;
+
+  // io_uring state, ring_file is -1 in pread mode
+  int ring_file;
+  uint32_t queue_depth;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  void *sqes;
+  size_t sqes_size;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  void *cqes;
+  std::vector<io_slot> slots;
+  std::vector<uint32_t> free_slots;
+
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  size_t num_outstanding;
+
+  std::vector<std::thread> threads;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_ASYNC_READER_HPP__
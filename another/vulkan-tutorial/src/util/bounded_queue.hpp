@@ -0,0 +1,139 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_BOUNDED_QUEUE_HPP__
+#define __TOBI_ENGINE_UTIL_BOUNDED_QUEUE_HPP__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// Thread safe FIFO holding at most capacity items. Producers block while it
+/// is full, which keeps fast producers from running ahead of the consumer.
+template<typename T>
+class bounded_queue
+{
+ public:
+  explicit bounded_queue(size_t capacity)
+      : capacity(capacity > 0 ? capacity : 1),
+        closed(false)
+  {
+  }
+  ~bounded_queue() = default;
+  bounded_queue(bounded_queue &&) = delete;
+  bounded_queue(const bounded_queue &) = delete;
+  bounded_queue &operator=(const bounded_queue &) = delete;
+  bounded_queue &operator=(bounded_queue &&) = delete;
+
+  /// Waits for room and appends item.
+  ///
+  /// return false if the queue was closed, item is then dropped
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this]()
+    {
+      return closed || items.size() < capacity;
+    });
+
+    if (closed)
+    {
+      return false;
+    }
+
+    items.push_back(std::move(item));
+    not_empty.notify_one();
+    return true;
+  }
+
+  /// Waits for an item.
+  ///
+  /// return false once the queue is closed and drained
+  bool pop(T &item)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [this]()
+    {
+      return closed || !items.empty();
+    });
+
+    return take(item);
+  }
+
+  /// Takes an item if one is ready. Never blocks.
+  bool try_pop(T &item)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return take(item);
+  }
+
+  /// Wakes all waiting threads, later pushes fail and pops drain what is
+  /// left.
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    not_full.notify_all();
+    not_empty.notify_all();
+  }
+
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size();
+  }
+
+ private:
+  bool take(T &item)
+  {
+    if (items.empty())
+    {
+      return false;
+    }
+
+    item = std::move(items.front());
+    items.pop_front();
+    not_full.notify_one();
+    return true;
+  }
+
+  const size_t capacity;
+  bool closed;
+  std::deque<T> items;
+
+  mutable std::mutex mutex;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_BOUNDED_QUEUE_HPP__
@@ -0,0 +1,325 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "json.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// Recursive descent over the text, one instance per parse
+class json_parser
+{
+ public:
+  json_parser(const char *text, size_t size)
+      : current(text),
+        end(text + size),
+        depth(0)
+  {
+  }
+
+  json_value parse_document()
+  {
+    auto value = parse_value();
+    skip_whitespace();
+    if (current != end)
+    {
+      fail("trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  // nesting deeper than this is rejected instead of overflowing the stack
+  static const int MAX_DEPTH = 256;
+
+  const char *current;
+  const char *end;
+  int depth;
+
+  void fail(const char *message) const
+  {
+    throw std::runtime_error(std::string("invalid JSON: ") + message);
+  }
+
+  void skip_whitespace()
+  {
+    while (current != end
+        && (*current == ' ' || *current == '\t' || *current == '\n'
+            || *current == '\r'))
+    {
+      current++;
+    }
+  }
+
+  void expect(char c)
+  {
+    skip_whitespace();
+    if (current == end || *current != c)
+    {
+      fail("unexpected character");
+    }
+    current++;
+  }
+
+  bool consume(const char *word)
+  {
+    auto length = std::char_traits<char>::length(word);
+    if (static_cast<size_t>(end - current) >= length
+        && std::char_traits<char>::compare(current, word, length) == 0)
+    {
+      current += length;
+      return true;
+    }
+    return false;
+  }
+
+  json_value parse_value()
+  {
+    skip_whitespace();
+    if (current == end)
+    {
+      fail("unexpected end");
+    }
+
+    json_value value;
+    switch (*current)
+    {
+      case '{':
+        return parse_object();
+      case '[':
+        return parse_array();
+      case '"':
+        value.value_type = json_value::type::string;
+        value.text = parse_string();
+        return value;
+      default:
+        break;
+    }
+
+    if (consume("true") || consume("false"))
+    {
+      value.value_type = json_value::type::boolean;
+      value.number = current[-1] == 'e' && current[-2] == 'u' ? 1.0 : 0.0;
+      return value;
+    }
+    if (consume("null"))
+    {
+      return value;
+    }
+
+    // strtod needs a terminated string, numbers are short
+    std::string number;
+    while (current != end
+        && (std::isdigit(static_cast<unsigned char>(*current))
+            || *current == '-' || *current == '+' || *current == '.'
+            || *current == 'e' || *current == 'E'))
+    {
+      number += *current++;
+    }
+    if (number.empty())
+    {
+      fail("unexpected character");
+    }
+
+    char *number_end;
+    value.value_type = json_value::type::number;
+    value.number = std::strtod(number.c_str(), &number_end);
+    if (*number_end != '\0')
+    {
+      fail("malformed number");
+    }
+    return value;
+  }
+
+  std::string parse_string()
+  {
+    expect('"');
+
+    std::string result;
+    while (current != end && *current != '"')
+    {
+      char c = *current++;
+      if (c != '\\')
+      {
+        result += c;
+        continue;
+      }
+
+      if (current == end)
+      {
+        break;
+      }
+      c = *current++;
+      switch (c)
+      {
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u':
+        {
+          if (end - current < 4)
+          {
+            fail("truncated escape");
+          }
+          auto code = std::strtoul(std::string(current, 4).c_str(), nullptr,
+                                   16);
+          current += 4;
+          // encoded as UTF-8, surrogate pairs are not combined
+          if (code < 0x80)
+          {
+            result += static_cast<char>(code);
+          } else if (code < 0x800)
+          {
+            result += static_cast<char>(0xC0 | (code >> 6));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+          } else
+          {
+            result += static_cast<char>(0xE0 | (code >> 12));
+            result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default:
+          result += c;
+          break;
+      }
+    }
+
+    if (current == end)
+    {
+      fail("unterminated string");
+    }
+    current++;
+    return result;
+  }
+
+  json_value parse_array()
+  {
+    if (++depth > MAX_DEPTH)
+    {
+      fail("nested too deeply");
+    }
+
+    json_value value;
+    value.value_type = json_value::type::array;
+
+    expect('[');
+    skip_whitespace();
+    if (current != end && *current == ']')
+    {
+      current++;
+    } else
+    {
+      do
+      {
+        value.elements.push_back(parse_value());
+        skip_whitespace();
+      } while (current != end && *current == ',' && ++current);
+      expect(']');
+    }
+
+    depth--;
+    return value;
+  }
+
+  json_value parse_object()
+  {
+    if (++depth > MAX_DEPTH)
+    {
+      fail("nested too deeply");
+    }
+
+    json_value value;
+    value.value_type = json_value::type::object;
+
+    expect('{');
+    skip_whitespace();
+    if (current != end && *current == '}')
+    {
+      current++;
+    } else
+    {
+      do
+      {
+        skip_whitespace();
+        value.keys.push_back(parse_string());
+        expect(':');
+        value.elements.push_back(parse_value());
+        skip_whitespace();
+      } while (current != end && *current == ',' && ++current);
+      expect('}');
+    }
+
+    depth--;
+    return value;
+  }
+};
+
+namespace
+{
+
+const json_value NULL_VALUE;
+
+}  // namespace
+
+json_value json_value::parse(const char *text, size_t size)
+{
+  json_parser parser(text, size);
+  return parser.parse_document();
+}
+
+const json_value &json_value::operator[](const std::string &key) const
+{
+  if (value_type == type::object)
+  {
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      if (keys[i] == key)
+      {
+        return elements[i];
+      }
+    }
+  }
+  return NULL_VALUE;
+}
+
+const json_value &json_value::operator[](size_t index) const
+{
+  if (value_type == type::array && index < elements.size())
+  {
+    return elements[index];
+  }
+  return NULL_VALUE;
+}
+
+}  // namespace util
+}  // namespace tobi_engine
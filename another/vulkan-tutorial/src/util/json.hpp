@@ -0,0 +1,113 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_JSON_HPP__
+#define __TOBI_ENGINE_UTIL_JSON_HPP__
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// A parsed JSON document. Small and read only, enough for asset headers
+/// such as glTF.
+class json_value
+{
+ public:
+  enum class type
+  {
+    null,
+    boolean,
+    number,
+    string,
+    array,
+    object
+  };
+
+  json_value()
+      : value_type(type::null),
+        number(0.0)
+  {
+  }
+
+  /// Parses a complete document, throws std::runtime_error on errors
+  static json_value parse(const char *text, size_t size);
+
+  type get_type() const
+  {
+    return value_type;
+  }
+
+  bool is_null() const
+  {
+    return value_type == type::null;
+  }
+
+  /// Member of an object, or a null value if there is none
+  const json_value &operator[](const std::string &key) const;
+
+  /// Element of an array, or a null value if out of range
+  const json_value &operator[](size_t index) const;
+
+  /// Elements of an array
+  size_t size() const
+  {
+    return elements.size();
+  }
+
+  double as_number(double fallback = 0.0) const
+  {
+    return value_type == type::number ? number : fallback;
+  }
+
+  /// Booleans are stored as 0 or 1
+  bool as_bool(bool fallback = false) const
+  {
+    return value_type == type::boolean ? number != 0.0 : fallback;
+  }
+
+  const std::string &as_string() const
+  {
+    return text;
+  }
+
+ private:
+  friend class json_parser;
+
+  type value_type;
+  double number;
+  std::string text;
+  std::vector<json_value> elements;
+  /// keys of an object, elements holds the values
+  std::vector<std::string> keys;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_JSON_HPP__
@@ -0,0 +1,83 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+mapped_file::mapped_file(std::string file_name)
+    : data(nullptr),
+      size(0)
+{
+  int file = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0)
+  {
+    throw std::runtime_error("failed to open " + file_name);
+  }
+
+  struct stat status;
+  if (fstat(file, &status) != 0)
+  {
+    close(file);
+    throw std::runtime_error("failed to stat " + file_name);
+  }
+
+  size = static_cast<size_t>(status.st_size);
+  if (size > 0)
+  {
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapping == MAP_FAILED)
+    {
+      close(file);
+      throw std::runtime_error("failed to map " + file_name);
+    }
+
+    // assets are read soon after the file is opened, start the reads now
+    madvise(mapping, size, MADV_WILLNEED);
+    data = static_cast<const uint8_t *>(mapping);
+  }
+
+  // the mapping keeps the file referenced
+  close(file);
+}
+
+mapped_file::~mapped_file()
+{
+  if (data)
+  {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+}
+
+}  // namespace util
+}  // namespace tobi_engine
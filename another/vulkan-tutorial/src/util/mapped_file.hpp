@@ -0,0 +1,66 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_MAPPED_FILE_HPP__
+#define __TOBI_ENGINE_UTIL_MAPPED_FILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// A whole file mapped read only into the address space. Pages are loaded
+/// by the kernel on first touch, nothing is copied to the heap.
+class mapped_file
+{
+ public:
+  explicit mapped_file(std::string file_name);
+  ~mapped_file();
+  mapped_file(mapped_file &&) = delete;
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+  mapped_file &operator=(mapped_file &&) = delete;
+
+  const uint8_t *get_data() const
+  {
+    return data;
+  }
+
+  size_t get_size() const
+  {
+    return size;
+  }
+
+ private:
+  const uint8_t *data;
+  size_t size;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_MAPPED_FILE_HPP__
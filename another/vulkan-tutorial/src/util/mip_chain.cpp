@@ -0,0 +1,153 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "mip_chain.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace tobi_engine
+{
+namespace util
+{
+
+uint32_t mip_chain::get_num_levels(uint32_t width, uint32_t height)
+{
+  uint32_t levels = 1;
+  auto size = std::max(width, height);
+  while (size > 1)
+  {
+    size /= 2;
+    levels++;
+  }
+  return levels;
+}
+
+uint32_t mip_chain::get_tail_level(const std::vector<mip_level> &levels,
+                                   uint32_t tail_size)
+{
+  uint32_t level = 0;
+  while (level + 1 < levels.size()
+      && std::max(levels[level].width, levels[level].height) > tail_size)
+  {
+    level++;
+  }
+  return level;
+}
+
+std::vector<mip_level> mip_chain::build_rgba8(const uint8_t *pixels,
+                                              uint32_t width, uint32_t height,
+                                              std::vector<uint8_t> &data)
+{
+  std::vector<mip_level> levels(get_num_levels(width, height));
+
+  size_t size = 0;
+  for (auto &level : levels)
+  {
+    level.offset = size;
+    level.width = width;
+    level.height = height;
+    size += static_cast<size_t>(width) * height * 4;
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+  }
+
+  data.resize(size);
+  std::memcpy(data.data(), pixels,
+              static_cast<size_t>(levels[0].width) * levels[0].height * 4);
+
+  for (size_t i = 1; i < levels.size(); i++)
+  {
+    downsample_rgba8(data.data() + levels[i - 1].offset, levels[i - 1].width,
+                     levels[i - 1].height, data.data() + levels[i].offset);
+  }
+
+  return levels;
+}
+
+void mip_chain::downsample_rgba8(const uint8_t *source, uint32_t width,
+                                 uint32_t height, uint8_t *destination)
+{
+  auto destination_width = std::max(width / 2, 1u);
+  auto destination_height = std::max(height / 2, 1u);
+
+  for (uint32_t y = 0; y < destination_height; y++)
+  {
+    // a one pixel high or wide level repeats its only row or column
+    auto row0 = source + static_cast<size_t>(std::min(y * 2, height - 1))
+        * width * 4;
+    auto row1 = source + static_cast<size_t>(std::min(y * 2 + 1, height - 1))
+        * width * 4;
+    auto out = destination + static_cast<size_t>(y) * destination_width * 4;
+
+    uint32_t x = 0;
+
+#ifdef __SSE2__
+    // two destination pixels from 4x2 source pixels per iteration
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(2);
+    for (; x + 2 <= destination_width && x * 2 + 4 <= width; x += 2)
+    {
+      auto top = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row0 + x * 8));
+      auto bottom = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row1 + x * 8));
+
+      // 16 bit sums of the two rows, source pixels 0-1 and 2-3
+      auto low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero),
+                               _mm_unpacklo_epi8(bottom, zero));
+      auto high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero),
+                                _mm_unpackhi_epi8(bottom, zero));
+
+      // add the neighbouring pixel in the upper half to the lower half
+      low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+      high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+
+      auto sum = _mm_unpacklo_epi64(low, high);
+      sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4),
+                       _mm_packus_epi16(sum, zero));
+    }
+#endif
+
+    for (; x < destination_width; x++)
+    {
+      auto x0 = std::min(x * 2, width - 1) * 4;
+      auto x1 = std::min(x * 2 + 1, width - 1) * 4;
+      for (uint32_t c = 0; c < 4; c++)
+      {
+        out[x * 4 + c] = static_cast<uint8_t>(
+            (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2)
+                >> 2);
+      }
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace tobi_engine
@@ -0,0 +1,86 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_MIP_CHAIN_HPP__
+#define __TOBI_ENGINE_UTIL_MIP_CHAIN_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// One level of a mip chain packed into a single buffer
+struct mip_level
+{
+  size_t offset;
+  uint32_t width;
+  uint32_t height;
+};
+
+/// CPU mip chain generation, for streamed textures, whose levels are
+/// uploaded one by one, and for formats the GPU cannot blit with linear
+/// filtering.
+class mip_chain
+{
+ public:
+  /// Prevent creation of instances of this class
+  mip_chain() = delete;
+  ~mip_chain() = delete;
+  mip_chain(mip_chain &&) = delete;
+  mip_chain(const mip_chain &) = delete;
+  mip_chain &operator=(const mip_chain &) = delete;
+  mip_chain &operator=(mip_chain &&) = delete;
+
+  /// Number of levels down to 1x1
+  static uint32_t get_num_levels(uint32_t width, uint32_t height);
+
+  /// The first level at most tail_size texels wide and high, the last one
+  /// if none is. Streamed textures keep this level and the coarser ones.
+  static uint32_t get_tail_level(const std::vector<mip_level> &levels,
+                                 uint32_t tail_size);
+
+  /// Builds the full chain of an RGBA8 image with a 2x2 box filter, SSE2
+  /// where available. Levels are tightly packed one after the other.
+  ///
+  /// @param[in] pixels base level, width * height * 4 bytes
+  /// @param[out] data all levels, the base level first
+  ///
+  /// return the levels in data
+  static std::vector<mip_level> build_rgba8(const uint8_t *pixels,
+                                            uint32_t width, uint32_t height,
+                                            std::vector<uint8_t> &data);
+
+  /// Box filters one RGBA8 level into the next, which is
+  /// max(width / 2, 1) by max(height / 2, 1). Odd edges are dropped.
+  static void downsample_rgba8(const uint8_t *source, uint32_t width,
+                               uint32_t height, uint8_t *destination);
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_MIP_CHAIN_HPP__
@@ -0,0 +1,116 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "page_allocator.hpp"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+page_allocator::page_allocator(uint32_t num_pages)
+    : free_runs(std::map<uint32_t, uint32_t> {}),
+      num_pages(num_pages),
+      free_pages(num_pages)
+{
+  if (num_pages > 0)
+  {
+    free_runs[0] = num_pages;
+  }
+}
+
+uint32_t page_allocator::allocate(uint32_t count)
+{
+  if (count == 0)
+  {
+    return INVALID_PAGE;
+  }
+
+  for (auto run = free_runs.begin(); run != free_runs.end(); ++run)
+  {
+    if (run->second < count)
+    {
+      continue;
+    }
+
+    auto first = run->first;
+    auto remaining = run->second - count;
+    free_runs.erase(run);
+    if (remaining > 0)
+    {
+      free_runs[first + count] = remaining;
+    }
+    free_pages -= count;
+    return first;
+  }
+
+  return INVALID_PAGE;
+}
+
+void page_allocator::free(uint32_t first, uint32_t count)
+{
+  if (count == 0 || first > num_pages || count > num_pages - first)
+  {
+    throw std::runtime_error("freed pages are out of range!");
+  }
+
+  auto next = free_runs.lower_bound(first);
+  if (next != free_runs.end() && next->first < first + count)
+  {
+    throw std::runtime_error("freed pages are already free!");
+  }
+
+  // merge with the run ending where this one starts
+  if (next != free_runs.begin())
+  {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second > first)
+    {
+      throw std::runtime_error("freed pages are already free!");
+    }
+    if (previous->first + previous->second == first)
+    {
+      first = previous->first;
+      count += previous->second;
+      free_pages -= previous->second;
+      free_runs.erase(previous);
+    }
+  }
+
+  // and the one starting where it ends
+  if (next != free_runs.end() && next->first == first + count)
+  {
+    count += next->second;
+    free_pages -= next->second;
+    free_runs.erase(next);
+  }
+
+  free_runs[first] = count;
+  free_pages += count;
+}
+
+}  // namespace util
+}  // namespace tobi_engine
@@ -0,0 +1,80 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_PAGE_ALLOCATOR_HPP__
+#define __TOBI_ENGINE_UTIL_PAGE_ALLOCATOR_HPP__
+
+#include <cstdint>
+#include <map>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// Hands out runs of contiguous pages of a fixed size range, for
+/// suballocating a large buffer. Only the bookkeeping, the caller maps pages
+/// to memory. Freed runs merge with their free neighbours.
+class page_allocator
+{
+ public:
+  static const uint32_t INVALID_PAGE = 0xFFFFFFFF;
+
+  page_allocator(uint32_t num_pages);
+  ~page_allocator() = default;
+  page_allocator(page_allocator &&) = delete;
+  page_allocator(const page_allocator &) = delete;
+  page_allocator &operator=(const page_allocator &) = delete;
+  page_allocator &operator=(page_allocator &&) = delete;
+
+  /// First fit, the lowest run of count free pages
+  ///
+  /// return the first page of the run, INVALID_PAGE when no run is long
+  /// enough
+  uint32_t allocate(uint32_t count);
+
+  /// Returns a run handed out by allocate
+  void free(uint32_t first, uint32_t count);
+
+  const uint32_t get_num_pages() const
+  {
+    return num_pages;
+  }
+  const uint32_t get_free_pages() const
+  {
+    return free_pages;
+  }
+
+ private:
+
+  /// free runs, first page to page count
+  std::map<uint32_t, uint32_t> free_runs;
+
+  uint32_t num_pages;
+  uint32_t free_pages;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_PAGE_ALLOCATOR_HPP__
@@ -0,0 +1,177 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+namespace
+{
+
+float sign_not_zero(float value)
+{
+  return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+}  // namespace
+
+uint16_t quantization::float_to_half(float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t float_exponent = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+
+  if (float_exponent == 0xFF)
+  {
+    return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+  }
+  if (exponent >= 31)
+  {
+    return static_cast<uint16_t>(sign | 0x7C00);
+  }
+
+  uint32_t shift = 13;
+  uint32_t half;
+  if (exponent <= 0)
+  {
+    // denormal, or zero when even the rounding cannot reach the last bit
+    if (exponent < -10)
+    {
+      return static_cast<uint16_t>(sign);
+    }
+    mantissa |= 0x800000;
+    shift = static_cast<uint32_t>(14 - exponent);
+    half = mantissa >> shift;
+  } else
+  {
+    half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> shift);
+  }
+
+  // a carry out of the mantissa correctly bumps the exponent
+  uint32_t remainder = mantissa & ((1u << shift) - 1);
+  uint32_t halfway = 1u << (shift - 1);
+  if (remainder > halfway || (remainder == halfway && (half & 1)))
+  {
+    half++;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+float quantization::half_to_float(uint16_t value)
+{
+  uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1F;
+  uint32_t mantissa = value & 0x3FF;
+
+  uint32_t bits;
+  if (exponent == 0x1F)
+  {
+    bits = sign | 0x7F800000 | (mantissa << 13);
+  } else if (exponent != 0)
+  {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else
+  {
+    // zero or denormal, exact in single precision
+    float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -magnitude : magnitude;
+  }
+
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+uint16_t quantization::to_unorm16(float value)
+{
+  return static_cast<uint16_t>(
+      std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+uint8_t quantization::to_unorm8(float value)
+{
+  return static_cast<uint8_t>(
+      std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+int16_t quantization::to_snorm16(float value)
+{
+  return static_cast<int16_t>(
+      std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+void quantization::encode_octahedral(float x, float y, float z, float &u,
+                                     float &v)
+{
+  auto length = std::abs(x) + std::abs(y) + std::abs(z);
+  if (length == 0.0f)
+  {
+    u = 0.0f;
+    v = 0.0f;
+    return;
+  }
+
+  u = x / length;
+  v = y / length;
+  // the lower half folds over the diagonals
+  if (z < 0.0f)
+  {
+    auto folded_u = (1.0f - std::abs(v)) * sign_not_zero(u);
+    v = (1.0f - std::abs(u)) * sign_not_zero(v);
+    u = folded_u;
+  }
+}
+
+void quantization::decode_octahedral(float u, float v, float &x, float &y,
+                                     float &z)
+{
+  x = u;
+  y = v;
+  z = 1.0f - std::abs(u) - std::abs(v);
+
+  auto fold = std::max(-z, 0.0f);
+  x += x >= 0.0f ? -fold : fold;
+  y += y >= 0.0f ? -fold : fold;
+
+  auto length = std::sqrt(x * x + y * y + z * z);
+  if (length > 0.0f)
+  {
+    x /= length;
+    y /= length;
+    z /= length;
+  }
+}
+
+}  // namespace util
+}  // namespace tobi_engine
@@ -0,0 +1,72 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_QUANTIZATION_HPP__
+#define __TOBI_ENGINE_UTIL_QUANTIZATION_HPP__
+
+#include <cstdint>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// Conversions of floats to the compact formats the GPU expands on fetch
+class quantization
+{
+ public:
+  /// Prevent creation of instances of this class
+  quantization() = delete;
+  ~quantization() = delete;
+  quantization(quantization &&) = delete;
+  quantization(const quantization &) = delete;
+  quantization &operator=(const quantization &) = delete;
+  quantization &operator=(quantization &&) = delete;
+
+  /// IEEE 754 binary16, rounded to nearest even. Out of range values become
+  /// infinity, NaN stays NaN.
+  static uint16_t float_to_half(float value);
+
+  static float half_to_float(uint16_t value);
+
+  /// [0, 1] to a UNORM component, values outside are clamped
+  static uint16_t to_unorm16(float value);
+  static uint8_t to_unorm8(float value);
+
+  /// [-1, 1] to a SNORM component, values outside are clamped
+  static int16_t to_snorm16(float value);
+
+  /// Maps a unit vector onto the octahedron unfolded into [-1, 1]^2
+  /// (Cigolle et al. 2014). The two components go in a SNORM format.
+  static void encode_octahedral(float x, float y, float z, float &u,
+                                float &v);
+
+  /// Inverse of encode_octahedral, the result is normalized
+  static void decode_octahedral(float u, float v, float &x, float &y,
+                                float &z);
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_QUANTIZATION_HPP__
@@ -0,0 +1,132 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "skyline_packer.hpp"
+
+#include <algorithm>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+skyline_packer::skyline_packer(uint32_t width, uint32_t height)
+    : skyline(std::vector<segment> {}),
+      width(width),
+      height(height),
+      used_area(0)
+{
+  segment ground = { 0, 0, width };
+  skyline.push_back(ground);
+}
+
+bool skyline_packer::insert(uint32_t width, uint32_t height, uint32_t &x,
+                            uint32_t &y)
+{
+  if (width == 0 || height == 0)
+  {
+    return false;
+  }
+
+  // lowest top edge first, then the narrowest segment to waste less
+  size_t best = skyline.size();
+  uint32_t best_y = 0;
+  for (size_t i = 0; i < skyline.size(); i++)
+  {
+    uint32_t segment_y;
+    if (!find_y(i, width, segment_y) || segment_y + height > this->height)
+    {
+      continue;
+    }
+    if (best == skyline.size() || segment_y < best_y
+        || (segment_y == best_y && skyline[i].width < skyline[best].width))
+    {
+      best = i;
+      best_y = segment_y;
+    }
+  }
+
+  if (best == skyline.size())
+  {
+    return false;
+  }
+
+  x = skyline[best].x;
+  y = best_y;
+
+  // the new segment covers the ones under the rectangle, the last of them
+  // only in part
+  segment top = { x, y + height, width };
+  auto right = x + width;
+  auto end = best;
+  while (end < skyline.size() && skyline[end].x < right)
+  {
+    auto segment_right = skyline[end].x + skyline[end].width;
+    if (segment_right > right)
+    {
+      skyline[end].width = segment_right - right;
+      skyline[end].x = right;
+      break;
+    }
+    end++;
+  }
+  skyline.erase(skyline.begin() + best, skyline.begin() + end);
+  skyline.insert(skyline.begin() + best, top);
+
+  // neighbours at the same height become one segment
+  for (size_t i = 0; i + 1 < skyline.size();)
+  {
+    if (skyline[i].y == skyline[i + 1].y)
+    {
+      skyline[i].width += skyline[i + 1].width;
+      skyline.erase(skyline.begin() + i + 1);
+    } else
+    {
+      i++;
+    }
+  }
+
+  used_area += static_cast<uint64_t>(width) * height;
+  return true;
+}
+
+bool skyline_packer::find_y(size_t index, uint32_t width, uint32_t &y) const
+{
+  if (skyline[index].x + width > this->width)
+  {
+    return false;
+  }
+
+  // rests on the highest segment it spans
+  y = 0;
+  uint32_t covered = 0;
+  for (auto i = index; covered < width; i++)
+  {
+    y = std::max(y, skyline[i].y);
+    covered += skyline[i].width;
+  }
+  return true;
+}
+
+}  // namespace util
+}  // namespace tobi_engine
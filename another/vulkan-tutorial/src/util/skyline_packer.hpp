@@ -0,0 +1,96 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef __TOBI_ENGINE_UTIL_SKYLINE_PACKER_HPP__
+#define __TOBI_ENGINE_UTIL_SKYLINE_PACKER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace util
+{
+
+/// Packs rectangles into a fixed size area by keeping the skyline of what
+/// is placed, the top edge of the rectangles seen from above. Each one goes
+/// where its top edge ends up lowest. Space below the skyline is not reused,
+/// so rectangles sorted by decreasing height pack best.
+class skyline_packer
+{
+ public:
+  skyline_packer(uint32_t width, uint32_t height);
+  ~skyline_packer() = default;
+  skyline_packer(skyline_packer &&) = delete;
+  skyline_packer(const skyline_packer &) = delete;
+  skyline_packer &operator=(const skyline_packer &) = delete;
+  skyline_packer &operator=(skyline_packer &&) = delete;
+
+  /// Places a width by height rectangle, its lower left corner at x and y
+  ///
+  /// return false when it does not fit anywhere
+  bool insert(uint32_t width, uint32_t height, uint32_t &x, uint32_t &y);
+
+  const uint32_t get_width() const
+  {
+    return width;
+  }
+  const uint32_t get_height() const
+  {
+    return height;
+  }
+  /// texels covered by the rectangles placed so far
+  const uint64_t get_used_area() const
+  {
+    return used_area;
+  }
+
+ private:
+
+  /// a horizontal segment of the skyline at height y
+  struct segment
+  {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+  };
+
+  /// left to right, without gaps
+  std::vector<segment> skyline;
+
+  uint32_t width;
+  uint32_t height;
+  uint64_t used_area;
+
+  /// The lowest y a width wide rectangle can rest at with its left edge at
+  /// segment index
+  ///
+  /// return false when it reaches past the right edge
+  bool find_y(size_t index, uint32_t width, uint32_t &y) const;
+};
+
+}  // namespace util
+}  // namespace tobi_engine
+
+#endif // __TOBI_ENGINE_UTIL_SKYLINE_PACKER_HPP__
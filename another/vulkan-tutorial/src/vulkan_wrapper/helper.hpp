@@ -30,20 +30,30 @@ namespace vulkan_wrapper
 namespace helper
 {
 
-inline VkImageView create_image_view(VkImage image, VkFormat format,
-                                   VkImageAspectFlags aspect_flags,
-                                   VkDevice device)
+inline VkImageViewCreateInfo get_image_view_create_info(
+    VkImage image, VkFormat format, VkImageAspectFlags aspect_flags,
+    uint32_t mip_levels = 1, uint32_t array_layers = 1,
+    VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D)
 {
   VkImageViewCreateInfo view_info = {};
   view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   view_info.image = image;
-  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.viewType = view_type;
   view_info.format = format;
   view_info.subresourceRange.aspectMask = aspect_flags;
   view_info.subresourceRange.baseMipLevel = 0;
-  view_info.subresourceRange.levelCount = 1;
+  view_info.subresourceRange.levelCount = mip_levels;
   view_info.subresourceRange.baseArrayLayer = 0;
-  view_info.subresourceRange.layerCount = 1;
+  view_info.subresourceRange.layerCount = array_layers;
+
+  return view_info;
+}
+
+inline VkImageView create_image_view(VkImage image, VkFormat format,
+                                   VkImageAspectFlags aspect_flags,
+                                   VkDevice device)
+{
+  auto view_info = get_image_view_create_info(image, format, aspect_flags);
 
   VkImageView image_view;
   if (vkCreateImageView(device, &view_info, nullptr, &image_view) != VK_SUCCESS)
@@ -77,7 +87,8 @@ inline uint32_t find_memory_type(uint32_t type_filter,
 inline void create_image(uint32_t width, uint32_t height, VkFormat format,
                         VkImageTiling tiling, VkImageUsageFlags usage,
                         VkMemoryPropertyFlags properties, VkImage& image,
-                        VkDeviceMemory& image_memory, VkDevice device, VkPhysicalDevice physical_device)
+                        VkDeviceMemory& image_memory, VkDevice device, VkPhysicalDevice physical_device,
+                        uint32_t mip_levels = 1, uint32_t array_layers = 1)
 {
   VkImageCreateInfo image_info = {};
   image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -85,8 +96,8 @@ inline void create_image(uint32_t width, uint32_t height, VkFormat format,
   image_info.extent.width = width;
   image_info.extent.height = height;
   image_info.extent.depth = 1;
-  image_info.mipLevels = 1;
-  image_info.arrayLayers = 1;
+  image_info.mipLevels = mip_levels;
+  image_info.arrayLayers = array_layers;
   image_info.format = format;
   image_info.tiling = tiling;
   image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -116,6 +127,187 @@ inline void create_image(uint32_t width, uint32_t height, VkFormat format,
   vkBindImageMemory(device, image, image_memory, 0);
 }
 
+inline void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                          VkMemoryPropertyFlags properties, VkBuffer& buffer,
+                          VkDeviceMemory& buffer_memory, VkDevice device,
+                          VkPhysicalDevice physical_device)
+{
+  VkBufferCreateInfo buffer_info = {};
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.size = size;
+  buffer_info.usage = usage;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create buffer!");
+  }
+
+  VkMemoryRequirements mem_requirements;
+  vkGetBufferMemoryRequirements(device, buffer, &mem_requirements);
+
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = mem_requirements.size;
+  alloc_info.memoryTypeIndex = find_memory_type(mem_requirements.memoryTypeBits,
+                                                properties, physical_device);
+
+  if (vkAllocateMemory(device, &alloc_info, nullptr, &buffer_memory) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate buffer memory!");
+  }
+
+  vkBindBufferMemory(device, buffer, buffer_memory, 0);
+}
+
+/// code must be 4 byte aligned, which asset pack entries always are
+inline VkShaderModule create_shader_module(const void* code, size_t size,
+                                           VkDevice device)
+{
+  VkShaderModuleCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  create_info.codeSize = size;
+  create_info.pCode = static_cast<const uint32_t*>(code);
+
+  VkShaderModule shader_module;
+  if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create shader module!");
+  }
+
+  return shader_module;
+}
+
+inline VkShaderModule create_shader_module(const std::vector<char>& code,
+                                           VkDevice device)
+{
+  return create_shader_module(code.data(), code.size(), device);
+}
+
+/// True if optimal tiling images of format can be sampled, which is how
+/// compressed formats are checked before uploading them as they are.
+inline bool supports_sampled_format(VkFormat format,
+                                    VkPhysicalDevice physical_device)
+{
+  VkFormatProperties format_properties;
+  vkGetPhysicalDeviceFormatProperties(physical_device, format,
+                                      &format_properties);
+
+  return (format_properties.optimalTilingFeatures
+      & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+/// True if optimal tiling images of format can be blitted into themselves
+/// with linear filtering, as record_generate_mipmaps does.
+inline bool supports_linear_blit(VkFormat format,
+                                 VkPhysicalDevice physical_device)
+{
+  VkFormatProperties format_properties;
+  vkGetPhysicalDeviceFormatProperties(physical_device, format,
+                                      &format_properties);
+
+  VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT
+      | VK_FORMAT_FEATURE_BLIT_DST_BIT
+      | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  return (format_properties.optimalTilingFeatures & required) == required;
+}
+
+/// Records the mip chain of a color image as a cascade of blits, each level
+/// halving the one above, for all layers at once. All levels must be in
+/// TRANSFER_DST_OPTIMAL with level 0 written, afterwards all are
+/// SHADER_READ_ONLY_OPTIMAL.
+inline void record_generate_mipmaps(VkCommandBuffer command_buffer,
+                                    VkImage image, uint32_t width,
+                                    uint32_t height, uint32_t mip_levels,
+                                    uint32_t array_layers = 1)
+{
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.image = image;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = array_layers;
+  barrier.subresourceRange.levelCount = 1;
+
+  auto level_width = static_cast<int32_t>(width);
+  auto level_height = static_cast<int32_t>(height);
+
+  for (uint32_t level = 1; level < mip_levels; level++)
+  {
+    // the level above is done being written, read it
+    barrier.subresourceRange.baseMipLevel = level - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    auto next_width = level_width > 1 ? level_width / 2 : 1;
+    auto next_height = level_height > 1 ? level_height / 2 : 1;
+
+    VkImageBlit blit = {};
+    blit.srcOffsets[0] = { 0, 0, 0 };
+    blit.srcOffsets[1] = { level_width, level_height, 1 };
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = level - 1;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = array_layers;
+    blit.dstOffsets[0] = { 0, 0, 0 };
+    blit.dstOffsets[1] = { next_width, next_height, 1 };
+    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.dstSubresource.mipLevel = level;
+    blit.dstSubresource.baseArrayLayer = 0;
+    blit.dstSubresource.layerCount = array_layers;
+
+    vkCmdBlitImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                   VK_FILTER_LINEAR);
+
+    // the level above is finished
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+
+    level_width = next_width;
+    level_height = next_height;
+  }
+
+  // the last level was only written
+  barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
+
+/// Starting value for hash_combine.
+const size_t HASH_SEED = static_cast<size_t>(14695981039346656037ull);
+
+/// Mixes the bytes of value into seed (FNV-1a). Hash fields one by one,
+/// padding bytes of whole structs are undefined.
+template<typename T>
+inline void hash_combine(size_t &seed, const T &value)
+{
+  const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&value);
+  for (size_t i = 0; i < sizeof(T); i++)
+  {
+    seed ^= bytes[i];
+    seed *= static_cast<size_t>(1099511628211ull);
+  }
+}
+
 }  // namespace helper
 }  // namespace vulkan_wrapper
 }  // namespace helper
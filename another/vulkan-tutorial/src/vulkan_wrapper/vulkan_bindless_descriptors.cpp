@@ -0,0 +1,243 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "vulkan_bindless_descriptors.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_bindless_descriptors::vulkan_bindless_descriptors(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    uint32_t max_images, uint32_t max_buffers, uint32_t reserved_images,
+    uint32_t reserved_buffers)
+    : layout(VK_NULL_HANDLE),
+      pool(VK_NULL_HANDLE),
+      descriptor_set(VK_NULL_HANDLE),
+      max_images(max_images),
+      max_buffers(max_buffers),
+      reserved_images(reserved_images),
+      reserved_buffers(reserved_buffers),
+      num_images(0),
+      num_buffers(0),
+      device(device),
+      physical_device(physical_device)
+{
+  initialize();
+}
+
+vulkan_bindless_descriptors::~vulkan_bindless_descriptors()
+{
+  vkDestroyDescriptorPool(device->get_device(), pool, nullptr);
+  vkDestroyDescriptorSetLayout(device->get_device(), layout, nullptr);
+}
+
+bool vulkan_bindless_descriptors::is_supported(
+    std::shared_ptr<vulkan_device> device)
+{
+  auto features = device->get_enabled_vulkan12_features();
+  return features.runtimeDescriptorArray
+      && features.descriptorBindingPartiallyBound
+      && features.descriptorBindingUpdateUnusedWhilePending
+      && features.descriptorBindingSampledImageUpdateAfterBind
+      && features.descriptorBindingStorageBufferUpdateAfterBind;
+}
+
+uint32_t vulkan_bindless_descriptors::add_image(VkImageView image_view,
+                                                VkSampler sampler,
+                                                VkImageLayout layout)
+{
+  auto index = allocate_slot(free_images, num_images, max_images);
+
+  VkDescriptorImageInfo image_info = {};
+  image_info.imageLayout = layout;
+  image_info.imageView = image_view;
+  image_info.sampler = sampler;
+
+  VkWriteDescriptorSet write = {};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = descriptor_set;
+  write.dstBinding = IMAGE_BINDING;
+  write.dstArrayElement = index;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  write.descriptorCount = 1;
+  write.pImageInfo = &image_info;
+
+  vkUpdateDescriptorSets(device->get_device(), 1, &write, 0, nullptr);
+
+  return index;
+}
+
+uint32_t vulkan_bindless_descriptors::add_buffer(VkBuffer buffer,
+                                                 VkDeviceSize offset,
+                                                 VkDeviceSize range)
+{
+  auto index = allocate_slot(free_buffers, num_buffers, max_buffers);
+
+  VkDescriptorBufferInfo buffer_info = {};
+  buffer_info.buffer = buffer;
+  buffer_info.offset = offset;
+  buffer_info.range = range;
+
+  VkWriteDescriptorSet write = {};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = descriptor_set;
+  write.dstBinding = BUFFER_BINDING;
+  write.dstArrayElement = index;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write.descriptorCount = 1;
+  write.pBufferInfo = &buffer_info;
+
+  vkUpdateDescriptorSets(device->get_device(), 1, &write, 0, nullptr);
+
+  return index;
+}
+
+void vulkan_bindless_descriptors::remove_image(uint32_t index)
+{
+  free_images.push_back(index);
+}
+
+void vulkan_bindless_descriptors::remove_buffer(uint32_t index)
+{
+  free_buffers.push_back(index);
+}
+
+uint32_t vulkan_bindless_descriptors::allocate_slot(
+    std::vector<uint32_t> &free_slots, uint32_t &count, uint32_t max_count)
+{
+  if (!free_slots.empty())
+  {
+    auto index = free_slots.back();
+    free_slots.pop_back();
+    return index;
+  }
+
+  if (count >= max_count)
+  {
+    throw std::runtime_error("bindless descriptor array is full!");
+  }
+
+  return count++;
+}
+
+void vulkan_bindless_descriptors::initialize() const
+{
+  // the arrays are bounded by the per stage update-after-bind limits, which
+  // also count the descriptors of the other sets in the pipeline layout. A
+  // combined image sampler is both a sampled image and a sampler.
+  auto limits = physical_device->get_descriptor_indexing_properties();
+  auto available = [](uint32_t limit, uint32_t reserved)
+  {
+    return limit > reserved ? limit - reserved : 0;
+  };
+  max_images = std::min( { max_images,
+      available(limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                reserved_images),
+      available(limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+                reserved_images) });
+  max_buffers = std::min(
+      max_buffers,
+      available(limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                reserved_buffers));
+  if (max_images == 0 || max_buffers == 0)
+  {
+    throw std::runtime_error("no room for bindless descriptor arrays!");
+  }
+
+  std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+  bindings[0].binding = IMAGE_BINDING;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[0].descriptorCount = max_images;
+  bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+  bindings[1].binding = BUFFER_BINDING;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[1].descriptorCount = max_buffers;
+  bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+  VkDescriptorBindingFlags binding_flag =
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+          | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+          | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+  std::array<VkDescriptorBindingFlags, 2> binding_flags = { binding_flag,
+      binding_flag };
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {};
+  binding_flags_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+  binding_flags_info.pBindingFlags = binding_flags.data();
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.pNext = &binding_flags_info;
+  layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(device->get_device(), &layout_info, nullptr,
+                                  &layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create bindless descriptor set layout!");
+  }
+
+  std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_sizes[0].descriptorCount = max_images;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  pool_sizes[1].descriptorCount = max_buffers;
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = 1;
+
+  if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr, &pool)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create bindless descriptor pool!");
+  }
+
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = pool;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &layout;
+
+  if (vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                               &descriptor_set) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate bindless descriptor set!");
+  }
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
@@ -0,0 +1,129 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef VULKAN_BINDLESS_DESCRIPTORS_HPP_
+#define VULKAN_BINDLESS_DESCRIPTORS_HPP_
+
+#include "vulkan_device.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// One descriptor set holding large arrays of textures and storage buffers
+/// (descriptor indexing, core in 1.2). Resources are registered once and
+/// addressed by their index from push constants, so switching material or
+/// buffer does not bind a new set.
+///
+/// Binding 0 is the combined image sampler array, binding 1 the storage
+/// buffer array. Both are update-after-bind and partially bound: unused
+/// slots stay unwritten and slots not used by pending command buffers can
+/// be written while those are in flight.
+///
+/// The arrays are sized within the device's update-after-bind limits, less
+/// the descriptors the other sets of the pipeline layouts using them take
+/// per stage.
+class vulkan_bindless_descriptors
+{
+ public:
+  static const uint32_t IMAGE_BINDING = 0;
+  static const uint32_t BUFFER_BINDING = 1;
+
+  vulkan_bindless_descriptors(
+      std::shared_ptr<vulkan_device> device,
+      std::shared_ptr<vulkan_physical_device> physical_device,
+      uint32_t max_images, uint32_t max_buffers,
+      uint32_t reserved_images = 0, uint32_t reserved_buffers = 0);
+  ~vulkan_bindless_descriptors();
+  vulkan_bindless_descriptors(vulkan_bindless_descriptors &&) = delete;
+  vulkan_bindless_descriptors(const vulkan_bindless_descriptors &) = delete;
+  vulkan_bindless_descriptors &operator=(const vulkan_bindless_descriptors &) = delete;
+  vulkan_bindless_descriptors &operator=(vulkan_bindless_descriptors &&) = delete;
+
+  /// True if device was created with the descriptor indexing features
+  /// this class needs.
+  static bool is_supported(std::shared_ptr<vulkan_device> device);
+
+  /// Writes the texture into a free slot and returns its index.
+  uint32_t add_image(VkImageView image_view, VkSampler sampler,
+                     VkImageLayout layout =
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+  /// Writes the buffer range into a free slot and returns its index.
+  uint32_t add_buffer(VkBuffer buffer, VkDeviceSize offset = 0,
+                      VkDeviceSize range = VK_WHOLE_SIZE);
+
+  /// Frees a slot for reuse. No submitted work may still read it, retire
+  /// the call through the deletion queue.
+  void remove_image(uint32_t index);
+  void remove_buffer(uint32_t index);
+
+  const VkDescriptorSetLayout get_layout() const
+  {
+    return layout;
+  }
+  const VkDescriptorSet get_descriptor_set() const
+  {
+    return descriptor_set;
+  }
+  const uint32_t get_max_images() const
+  {
+    return max_images;
+  }
+  const uint32_t get_max_buffers() const
+  {
+    return max_buffers;
+  }
+
+ private:
+
+  mutable VkDescriptorSetLayout layout;
+  mutable VkDescriptorPool pool;
+  mutable VkDescriptorSet descriptor_set;
+
+  mutable uint32_t max_images;
+  mutable uint32_t max_buffers;
+  uint32_t reserved_images;
+  uint32_t reserved_buffers;
+
+  // slots below the high water mark that were freed again
+  std::vector<uint32_t> free_images;
+  std::vector<uint32_t> free_buffers;
+  uint32_t num_images;
+  uint32_t num_buffers;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+
+  void initialize() const;
+
+  uint32_t allocate_slot(std::vector<uint32_t> &free_slots, uint32_t &count,
+                         uint32_t max_count);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_BINDLESS_DESCRIPTORS_HPP_
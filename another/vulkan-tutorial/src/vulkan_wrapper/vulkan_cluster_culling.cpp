@@ -0,0 +1,390 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_cluster_culling.hpp"
+#include "helper.hpp"
+#include "../util/file_handler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_cluster_culling::vulkan_cluster_culling(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    std::shared_ptr<vulkan_indirect_draws> indirect_draws,
+    std::shared_ptr<vulkan_indirect_draws> object_draws,
+    const std::vector<cull_cluster> &clusters, uint32_t max_instances)
+    : cluster_buffer(VK_NULL_HANDLE),
+      cluster_buffer_memory(VK_NULL_HANDLE),
+      view_buffers(std::vector<VkBuffer> {}),
+      view_buffers_memory(std::vector<VkDeviceMemory> {}),
+      view_buffers_mapped(std::vector<void*> {}),
+      instance_buffers(std::vector<VkBuffer> {}),
+      instance_buffers_memory(std::vector<VkDeviceMemory> {}),
+      instance_buffers_mapped(std::vector<void*> {}),
+      descriptor_set_layout(VK_NULL_HANDLE),
+      descriptor_pool(VK_NULL_HANDLE),
+      descriptor_sets(std::vector<VkDescriptorSet> {}),
+      pipeline_layout(VK_NULL_HANDLE),
+      pipeline(VK_NULL_HANDLE),
+      max_instances(max_instances),
+      device(device),
+      physical_device(physical_device),
+      indirect_draws(indirect_draws),
+      object_draws(object_draws)
+{
+  if (object_draws
+      && object_draws->get_num_lists() != indirect_draws->get_num_lists())
+  {
+    throw std::runtime_error("object culling lists do not match!");
+  }
+
+  initialize(clusters);
+}
+
+vulkan_cluster_culling::~vulkan_cluster_culling()
+{
+  vkDestroyPipeline(device->get_device(), pipeline, nullptr);
+  vkDestroyPipelineLayout(device->get_device(), pipeline_layout, nullptr);
+  vkDestroyDescriptorPool(device->get_device(), descriptor_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device->get_device(), descriptor_set_layout,
+                               nullptr);
+
+  for (size_t i = 0; i < view_buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), view_buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), view_buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), view_buffers_memory[i], nullptr);
+  }
+
+  for (size_t i = 0; i < instance_buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), instance_buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), instance_buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), instance_buffers_memory[i], nullptr);
+  }
+
+  vkDestroyBuffer(device->get_device(), cluster_buffer, nullptr);
+  vkFreeMemory(device->get_device(), cluster_buffer_memory, nullptr);
+}
+
+void vulkan_cluster_culling::update(uint32_t index, const cluster_view &view,
+                                    const cluster_instance *instances)
+{
+  if (view.instance_count > max_instances)
+  {
+    throw std::runtime_error("more instances to cull clusters of than room!");
+  }
+
+  std::memcpy(view_buffers_mapped[index], &view, sizeof(view));
+  std::memcpy(instance_buffers_mapped[index], instances,
+              sizeof(cluster_instance) * view.instance_count);
+}
+
+void vulkan_cluster_culling::record(VkCommandBuffer command_buffer,
+                                    uint32_t index) const
+{
+  auto draw_buffer = indirect_draws->get_buffer(index);
+
+  // the previous use of the list has to be drawn before it is overwritten
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = draw_buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr);
+
+  // the count doubles as the append counter. Without drawIndirectCount every
+  // slot is drawn, and a zeroed command draws nothing.
+  VkDeviceSize clear_size = sizeof(uint32_t);
+  if (!indirect_draws->has_draw_count())
+  {
+    clear_size = VK_WHOLE_SIZE;
+  }
+  vkCmdFillBuffer(command_buffer, draw_buffer, 0, clear_size, 0);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+      | VK_ACCESS_SHADER_WRITE_BIT;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr);
+
+  // the object pass has to be done writing which objects are visible
+  if (object_draws)
+  {
+    VkBufferMemoryBarrier object_barrier = barrier;
+    object_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    object_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    object_barrier.buffer = object_draws->get_buffer(index);
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         1, &object_barrier, 0, nullptr);
+  }
+
+  // one workgroup per instance, the ones past instance_count return at once
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline_layout, 0, 1, &descriptor_sets[index], 0,
+                          nullptr);
+  vkCmdDispatch(command_buffer, std::max(max_instances, 1u), 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr);
+}
+
+void vulkan_cluster_culling::initialize(
+    const std::vector<cull_cluster> &clusters) const
+{
+  create_buffers(clusters);
+  create_pipeline();
+  create_descriptor_sets();
+}
+
+void vulkan_cluster_culling::create_buffers(
+    const std::vector<cull_cluster> &clusters) const
+{
+  // clusters are written once, a zero sized buffer is not allowed
+  VkDeviceSize cluster_size = sizeof(cull_cluster)
+      * std::max<size_t>(clusters.size(), 1);
+
+  helper::create_buffer(
+      cluster_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      cluster_buffer, cluster_buffer_memory, device->get_device(),
+      physical_device->get_physical_device());
+
+  void* data;
+  vkMapMemory(device->get_device(), cluster_buffer_memory, 0, cluster_size, 0,
+              &data);
+  std::memcpy(data, clusters.data(), sizeof(cull_cluster) * clusters.size());
+  vkUnmapMemory(device->get_device(), cluster_buffer_memory);
+
+  auto num_lists = indirect_draws->get_num_lists();
+  view_buffers.resize(num_lists);
+  view_buffers_memory.resize(num_lists);
+  view_buffers_mapped.resize(num_lists);
+  instance_buffers.resize(num_lists);
+  instance_buffers_memory.resize(num_lists);
+  instance_buffers_mapped.resize(num_lists);
+
+  VkDeviceSize instance_size = sizeof(cluster_instance)
+      * std::max(max_instances, 1u);
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    helper::create_buffer(
+        sizeof(cluster_view), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        view_buffers[i], view_buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    vkMapMemory(device->get_device(), view_buffers_memory[i], 0,
+                sizeof(cluster_view), 0, &view_buffers_mapped[i]);
+    std::memset(view_buffers_mapped[i], 0, sizeof(cluster_view));
+
+    helper::create_buffer(
+        instance_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        instance_buffers[i], instance_buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    vkMapMemory(device->get_device(), instance_buffers_memory[i], 0,
+                instance_size, 0, &instance_buffers_mapped[i]);
+  }
+}
+
+void vulkan_cluster_culling::create_pipeline() const
+{
+  std::array<VkDescriptorSetLayoutBinding, 5> bindings = {};
+  bindings[0].binding = 0;
+  bindings[0].descriptorCount = 1;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  for (uint32_t binding = 1; binding < bindings.size(); binding++)
+  {
+    bindings[binding].binding = binding;
+    bindings[binding].descriptorCount = 1;
+    bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(device->get_device(), &layout_info, nullptr,
+                                  &descriptor_set_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error(
+        "failed to create cluster culling descriptor set layout!");
+  }
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+
+  if (vkCreatePipelineLayout(device->get_device(), &pipeline_layout_info,
+                             nullptr, &pipeline_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create cluster culling pipeline layout!");
+  }
+
+  VkBool32 object_visibility = object_draws ? VK_TRUE : VK_FALSE;
+
+  VkSpecializationMapEntry visibility_entry = {};
+  visibility_entry.constantID = 0;
+  visibility_entry.offset = 0;
+  visibility_entry.size = sizeof(object_visibility);
+
+  VkSpecializationInfo specialization_info = {};
+  specialization_info.mapEntryCount = 1;
+  specialization_info.pMapEntries = &visibility_entry;
+  specialization_info.dataSize = sizeof(object_visibility);
+  specialization_info.pData = &object_visibility;
+
+  auto shader_code = util::file_handler::read_binary_file(
+      "shaders/cluster_cull.spv");
+  auto shader_module = helper::create_shader_module(shader_code,
+                                                    device->get_device());
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.stage.pSpecializationInfo = &specialization_info;
+  pipeline_info.layout = pipeline_layout;
+
+  auto result = vkCreateComputePipelines(device->get_device(), VK_NULL_HANDLE,
+                                         1, &pipeline_info, nullptr,
+                                         &pipeline);
+
+  vkDestroyShaderModule(device->get_device(), shader_module, nullptr);
+
+  if (result != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create cluster culling pipeline!");
+  }
+}
+
+void vulkan_cluster_culling::create_descriptor_sets() const
+{
+  auto num_lists = indirect_draws->get_num_lists();
+
+  std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  pool_sizes[0].descriptorCount = num_lists;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  pool_sizes[1].descriptorCount = 4 * num_lists;
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = num_lists;
+
+  if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr,
+                             &descriptor_pool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create cluster culling descriptor pool!");
+  }
+
+  std::vector<VkDescriptorSetLayout> layouts(num_lists, descriptor_set_layout);
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = descriptor_pool;
+  alloc_info.descriptorSetCount = num_lists;
+  alloc_info.pSetLayouts = layouts.data();
+
+  descriptor_sets.resize(num_lists);
+  if (vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                               descriptor_sets.data()) != VK_SUCCESS)
+  {
+    throw std::runtime_error(
+        "failed to allocate cluster culling descriptor sets!");
+  }
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    std::array<VkDescriptorBufferInfo, 5> buffer_infos = {};
+    buffer_infos[0].buffer = view_buffers[i];
+    buffer_infos[0].range = sizeof(cluster_view);
+    buffer_infos[1].buffer = cluster_buffer;
+    buffer_infos[1].range = VK_WHOLE_SIZE;
+    buffer_infos[2].buffer = instance_buffers[i];
+    buffer_infos[2].range = VK_WHOLE_SIZE;
+    buffer_infos[3].buffer = indirect_draws->get_buffer(i);
+    buffer_infos[3].range = VK_WHOLE_SIZE;
+    // never read without object culling, the draw list keeps the binding
+    // valid
+    buffer_infos[4].buffer = object_draws ? object_draws->get_buffer(i) :
+        indirect_draws->get_buffer(i);
+    buffer_infos[4].range = VK_WHOLE_SIZE;
+
+    std::array<VkWriteDescriptorSet, 5> writes = {};
+    for (uint32_t binding = 0; binding < writes.size(); binding++)
+    {
+      writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[binding].dstSet = descriptor_sets[i];
+      writes[binding].dstBinding = binding;
+      writes[binding].descriptorCount = 1;
+      writes[binding].descriptorType =
+          binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER :
+              VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[binding].pBufferInfo = &buffer_infos[binding];
+    }
+
+    vkUpdateDescriptorSets(device->get_device(),
+                           static_cast<uint32_t>(writes.size()), writes.data(),
+                           0, nullptr);
+  }
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
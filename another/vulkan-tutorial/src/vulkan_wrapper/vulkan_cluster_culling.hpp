@@ -0,0 +1,155 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_CLUSTER_CULLING_HPP_
+#define VULKAN_CLUSTER_CULLING_HPP_
+
+#include "vulkan_device.hpp"
+#include "vulkan_indirect_draws.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// A meshlet as seen by the cluster culling shader, in mesh space. Matches
+/// Cluster in cluster_cull.comp.
+struct cull_cluster
+{
+  /// bounding sphere, center and radius
+  float sphere[4];
+  /// normal cone axis and the sine of its half angle, 1 to never cull
+  float cone[4];
+  uint32_t index_count;
+  uint32_t first_index;
+  uint32_t padding[2];
+};
+
+/// An object whose clusters are culled: where it is, which clusters it is
+/// made of and the instance its draws use. Matches ClusterInstance in
+/// cluster_cull.comp.
+struct cluster_instance
+{
+  /// mesh to the space of the planes, without shear and non uniform scale
+  float model[16];
+  uint32_t first_cluster;
+  uint32_t cluster_count;
+  uint32_t instance;
+  /// scale of model, for the sphere radii
+  float scale;
+  /// where the level the clusters belong to is resident, cluster index
+  /// ranges are relative to index_offset
+  uint32_t index_offset;
+  int32_t vertex_offset;
+  uint32_t padding[2];
+};
+
+/// Per frame cluster culling input, uniform buffer layout of ClusterView in
+/// cluster_cull.comp. Planes and eye are in the space model transforms to.
+struct cluster_view
+{
+  float planes[6][4];
+  float eye[4];
+  uint32_t instance_count;
+  uint32_t padding[3];
+};
+
+///
+/// Compute pass culling the meshlets of a list of objects against the
+/// frustum and their normal cones, appending a draw of one instance for
+/// every visible meshlet to a vulkan_indirect_draws list. Each object gets
+/// a workgroup that loops over its clusters.
+///
+/// Behind a vulkan_gpu_culling writing its lists in place, the instances
+/// are all objects in order, and the clusters of those the object pass
+/// culled are skipped.
+///
+/// Without drawIndirectCount the whole list is cleared first, so the unused
+/// slots draw nothing. The lists need multiDrawIndirect to draw more than
+/// one cluster.
+class vulkan_cluster_culling
+{
+ public:
+  vulkan_cluster_culling(std::shared_ptr<vulkan_device> device,
+                         std::shared_ptr<vulkan_physical_device> physical_device,
+                         std::shared_ptr<vulkan_indirect_draws> indirect_draws,
+                         std::shared_ptr<vulkan_indirect_draws> object_draws,
+                         const std::vector<cull_cluster> &clusters,
+                         uint32_t max_instances);
+  ~vulkan_cluster_culling();
+  vulkan_cluster_culling(vulkan_cluster_culling &&) = delete;
+  vulkan_cluster_culling(const vulkan_cluster_culling &) = delete;
+  vulkan_cluster_culling &operator=(const vulkan_cluster_culling &) = delete;
+  vulkan_cluster_culling &operator=(vulkan_cluster_culling &&) = delete;
+
+  /// Sets the view and objects list index is culled with, view.instance_count
+  /// of them. The GPU must be done with it.
+  void update(uint32_t index, const cluster_view &view,
+              const cluster_instance *instances);
+
+  /// Records the culling of list index into command_buffer, outside of a
+  /// render pass. The object pass, if any, is recorded before it.
+  void record(VkCommandBuffer command_buffer, uint32_t index) const;
+
+  const uint32_t get_max_instances() const
+  {
+    return max_instances;
+  }
+
+ private:
+
+  mutable VkBuffer cluster_buffer;
+  mutable VkDeviceMemory cluster_buffer_memory;
+
+  mutable std::vector<VkBuffer> view_buffers;
+  mutable std::vector<VkDeviceMemory> view_buffers_memory;
+  mutable std::vector<void*> view_buffers_mapped;
+
+  mutable std::vector<VkBuffer> instance_buffers;
+  mutable std::vector<VkDeviceMemory> instance_buffers_memory;
+  mutable std::vector<void*> instance_buffers_mapped;
+
+  mutable VkDescriptorSetLayout descriptor_set_layout;
+  mutable VkDescriptorPool descriptor_pool;
+  mutable std::vector<VkDescriptorSet> descriptor_sets;
+  mutable VkPipelineLayout pipeline_layout;
+  mutable VkPipeline pipeline;
+
+  uint32_t max_instances;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+  std::shared_ptr<vulkan_indirect_draws> indirect_draws;
+  // the in place lists of the object culling, null without it
+  std::shared_ptr<vulkan_indirect_draws> object_draws;
+
+  void initialize(const std::vector<cull_cluster> &clusters) const;
+
+  void create_buffers(const std::vector<cull_cluster> &clusters) const;
+  void create_pipeline() const;
+  void create_descriptor_sets() const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_CLUSTER_CULLING_HPP_
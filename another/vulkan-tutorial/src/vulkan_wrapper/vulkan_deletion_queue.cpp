@@ -0,0 +1,93 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_deletion_queue.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_deletion_queue::vulkan_deletion_queue(
+    std::shared_ptr<vulkan_timeline> timeline)
+    : retired(std::deque<retired_resource> {}),
+      timeline(timeline)
+{
+}
+
+vulkan_deletion_queue::~vulkan_deletion_queue()
+{
+  flush();
+}
+
+void vulkan_deletion_queue::retire(uint64_t value,
+                                   std::function<void()> destroy)
+{
+  retired_resource resource;
+  resource.value = value;
+  resource.destroy = destroy;
+  push(resource);
+}
+
+void vulkan_deletion_queue::retire_object(uint64_t value,
+                                          std::shared_ptr<void> object)
+{
+  retired_resource resource;
+  resource.value = value;
+  resource.object = object;
+  push(resource);
+}
+
+void vulkan_deletion_queue::collect()
+{
+  // values are pushed in order, so stop at the first one not yet reached
+  while (!retired.empty() && timeline->is_complete(retired.front().value))
+  {
+    if (retired.front().destroy)
+    {
+      retired.front().destroy();
+    }
+    retired.pop_front();
+  }
+}
+
+void vulkan_deletion_queue::flush()
+{
+  if (!retired.empty())
+  {
+    timeline->wait(retired.back().value);
+    collect();
+  }
+}
+
+void vulkan_deletion_queue::push(retired_resource resource)
+{
+  // keep the queue sorted even if a caller retires with an older value
+  if (!retired.empty() && resource.value < retired.back().value)
+  {
+    resource.value = retired.back().value;
+  }
+  retired.push_back(resource);
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
@@ -0,0 +1,87 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_DELETION_QUEUE_HPP_
+#define VULKAN_DELETION_QUEUE_HPP_
+
+#include <deque>
+#include <functional>
+
+#include "vulkan_timeline.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Resources that are no longer used by new work, but may still be referenced
+/// by submitted command buffers. Each is tagged with the timeline value of the
+/// last submission using it, and destroyed once the GPU has passed that value.
+class vulkan_deletion_queue
+{
+ public:
+  vulkan_deletion_queue(std::shared_ptr<vulkan_timeline> timeline);
+  ~vulkan_deletion_queue();
+  vulkan_deletion_queue(vulkan_deletion_queue &&) = delete;
+  vulkan_deletion_queue(const vulkan_deletion_queue &) = delete;
+  vulkan_deletion_queue &operator=(const vulkan_deletion_queue &) = delete;
+  vulkan_deletion_queue &operator=(vulkan_deletion_queue &&) = delete;
+
+  /// Calls destroy once the GPU has reached value.
+  void retire(uint64_t value, std::function<void()> destroy);
+
+  /// Keeps object alive until the GPU has reached value. Used for wrappers
+  /// that destroy their handles in the destructor.
+  void retire_object(uint64_t value, std::shared_ptr<void> object);
+
+  /// Destroys everything the GPU is done with. Never blocks.
+  void collect();
+
+  /// Waits for all retired resources and destroys them.
+  void flush();
+
+  const size_t get_num_pending() const
+  {
+    return retired.size();
+  }
+
+ private:
+
+  struct retired_resource
+  {
+    uint64_t value;
+    std::function<void()> destroy;
+    std::shared_ptr<void> object;
+  };
+
+  std::deque<retired_resource> retired;
+
+  std::shared_ptr<vulkan_timeline> timeline;
+
+  void push(retired_resource resource);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_DELETION_QUEUE_HPP_
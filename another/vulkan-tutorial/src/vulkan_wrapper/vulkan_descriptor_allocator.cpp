@@ -0,0 +1,341 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "vulkan_descriptor_allocator.hpp"
+#include "helper.hpp"
+
+#include <algorithm>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+namespace
+{
+
+// pools grow up to this many sets each
+const uint32_t MAX_SETS_PER_POOL = 4096;
+
+// descriptors of each type per set in a pool, generous enough that an
+// ordinary set never exhausts one type before the pool runs out of sets
+const std::pair<VkDescriptorType, float> POOL_RATIOS[] =
+{
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+    { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+    { VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+    { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f }
+};
+
+}  // namespace
+
+vulkan_descriptor_allocator::vulkan_descriptor_allocator(
+    std::shared_ptr<vulkan_device> device, uint32_t num_frames,
+    uint32_t sets_per_pool)
+    : transient(std::vector<pool_chain>(num_frames)),
+      sets_per_pool(sets_per_pool),
+      num_pools(0),
+      num_cached(0),
+      device(device)
+{
+  persistent.current = get_pool();
+  for (auto &chain : transient)
+  {
+    chain.current = get_pool();
+  }
+}
+
+vulkan_descriptor_allocator::~vulkan_descriptor_allocator()
+{
+  auto destroy_chain = [this](const pool_chain &chain)
+  {
+    vkDestroyDescriptorPool(device->get_device(), chain.current, nullptr);
+    for (const auto &pool : chain.full)
+    {
+      vkDestroyDescriptorPool(device->get_device(), pool, nullptr);
+    }
+  };
+
+  destroy_chain(persistent);
+  for (const auto &chain : transient)
+  {
+    destroy_chain(chain);
+  }
+  for (const auto &pool : free_pools)
+  {
+    vkDestroyDescriptorPool(device->get_device(), pool, nullptr);
+  }
+}
+
+VkDescriptorSet vulkan_descriptor_allocator::allocate(
+    VkDescriptorSetLayout layout)
+{
+  return allocate(persistent, layout);
+}
+
+VkDescriptorSet vulkan_descriptor_allocator::allocate_transient(
+    uint32_t frame, VkDescriptorSetLayout layout,
+    const std::vector<descriptor_binding> &bindings)
+{
+  auto descriptor_set = allocate(transient[frame], layout);
+  write(descriptor_set, bindings);
+  return descriptor_set;
+}
+
+void vulkan_descriptor_allocator::begin_frame(uint32_t frame)
+{
+  auto &chain = transient[frame];
+
+  // everything allocated last time this frame was used goes at once
+  vkResetDescriptorPool(device->get_device(), chain.current, 0);
+  for (const auto &pool : chain.full)
+  {
+    vkResetDescriptorPool(device->get_device(), pool, 0);
+    free_pools.push_back(pool);
+  }
+  chain.full.clear();
+}
+
+VkDescriptorSet vulkan_descriptor_allocator::get_cached(
+    VkDescriptorSetLayout layout,
+    const std::vector<descriptor_binding> &bindings)
+{
+  auto &bucket = cache[hash(layout, bindings)];
+
+  for (const auto &entry : bucket)
+  {
+    if (entry.layout == layout && entry.bindings.size() == bindings.size()
+        && std::equal(bindings.begin(), bindings.end(), entry.bindings.begin(),
+                      equals))
+    {
+      return entry.descriptor_set;
+    }
+  }
+
+  cache_entry entry;
+  entry.layout = layout;
+  entry.bindings = bindings;
+  auto &free_sets = recycled[layout];
+  if (!free_sets.empty())
+  {
+    entry.descriptor_set = free_sets.back();
+    free_sets.pop_back();
+  } else
+  {
+    entry.descriptor_set = allocate(persistent, layout);
+  }
+  write(entry.descriptor_set, bindings);
+  bucket.push_back(entry);
+  num_cached++;
+
+  return entry.descriptor_set;
+}
+
+void vulkan_descriptor_allocator::invalidate_image_view(
+    VkImageView image_view)
+{
+  invalidate([=](const descriptor_binding &binding)
+  {
+    return binding.image.imageView == image_view;
+  });
+}
+
+void vulkan_descriptor_allocator::invalidate_buffer(VkBuffer buffer)
+{
+  invalidate([=](const descriptor_binding &binding)
+  {
+    return binding.buffer.buffer == buffer;
+  });
+}
+
+template<typename Predicate>
+void vulkan_descriptor_allocator::invalidate(Predicate holds)
+{
+  for (auto &bucket : cache)
+  {
+    auto &entries = bucket.second;
+    auto end = std::remove_if(entries.begin(), entries.end(),
+                              [&](const cache_entry &entry)
+                              {
+                                if (std::none_of(entry.bindings.begin(),
+                                                 entry.bindings.end(), holds))
+                                {
+                                  return false;
+                                }
+                                recycled[entry.layout].push_back(
+                                    entry.descriptor_set);
+                                return true;
+                              });
+    num_cached -= entries.end() - end;
+    entries.erase(end, entries.end());
+  }
+}
+
+VkDescriptorSet vulkan_descriptor_allocator::allocate(
+    pool_chain &chain, VkDescriptorSetLayout layout)
+{
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = chain.current;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &layout;
+
+  VkDescriptorSet descriptor_set;
+  auto result = vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                                         &descriptor_set);
+
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY
+      || result == VK_ERROR_FRAGMENTED_POOL)
+  {
+    // the current pool is full, continue in a fresh one
+    chain.full.push_back(chain.current);
+    chain.current = get_pool();
+    alloc_info.descriptorPool = chain.current;
+
+    result = vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                                      &descriptor_set);
+  }
+
+  if (result != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate descriptor set!");
+  }
+
+  return descriptor_set;
+}
+
+VkDescriptorPool vulkan_descriptor_allocator::get_pool()
+{
+  if (!free_pools.empty())
+  {
+    auto pool = free_pools.back();
+    free_pools.pop_back();
+    return pool;
+  }
+
+  auto pool = create_pool(sets_per_pool);
+  // a chain that keeps running out needs fewer, larger pools
+  sets_per_pool = std::min(sets_per_pool * 2, MAX_SETS_PER_POOL);
+  return pool;
+}
+
+VkDescriptorPool vulkan_descriptor_allocator::create_pool(uint32_t max_sets)
+{
+  std::vector<VkDescriptorPoolSize> pool_sizes;
+  for (const auto &ratio : POOL_RATIOS)
+  {
+    VkDescriptorPoolSize pool_size = {};
+    pool_size.type = ratio.first;
+    pool_size.descriptorCount = static_cast<uint32_t>(ratio.second * max_sets);
+    pool_sizes.push_back(pool_size);
+  }
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = max_sets;
+
+  VkDescriptorPool pool;
+  if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr, &pool)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create descriptor pool!");
+  }
+
+  num_pools++;
+  return pool;
+}
+
+void vulkan_descriptor_allocator::write(
+    VkDescriptorSet descriptor_set,
+    const std::vector<descriptor_binding> &bindings) const
+{
+  std::vector<VkWriteDescriptorSet> writes(bindings.size());
+
+  for (size_t i = 0; i < bindings.size(); i++)
+  {
+    auto &write = writes[i];
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptor_set;
+    write.dstBinding = bindings[i].binding;
+    write.dstArrayElement = 0;
+    write.descriptorType = bindings[i].type;
+    write.descriptorCount = 1;
+
+    switch (bindings[i].type)
+    {
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        write.pBufferInfo = &bindings[i].buffer;
+        break;
+      default:
+        write.pImageInfo = &bindings[i].image;
+        break;
+    }
+  }
+
+  vkUpdateDescriptorSets(device->get_device(),
+                         static_cast<uint32_t>(writes.size()), writes.data(),
+                         0, nullptr);
+}
+
+size_t vulkan_descriptor_allocator::hash(
+    VkDescriptorSetLayout layout,
+    const std::vector<descriptor_binding> &bindings)
+{
+  size_t seed = helper::HASH_SEED;
+  helper::hash_combine(seed, layout);
+  for (const auto &binding : bindings)
+  {
+    helper::hash_combine(seed, binding.binding);
+    helper::hash_combine(seed, binding.type);
+    helper::hash_combine(seed, binding.buffer.buffer);
+    helper::hash_combine(seed, binding.buffer.offset);
+    helper::hash_combine(seed, binding.buffer.range);
+    helper::hash_combine(seed, binding.image.sampler);
+    helper::hash_combine(seed, binding.image.imageView);
+    helper::hash_combine(seed, binding.image.imageLayout);
+  }
+  return seed;
+}
+
+bool vulkan_descriptor_allocator::equals(const descriptor_binding &a,
+                                         const descriptor_binding &b)
+{
+  return a.binding == b.binding && a.type == b.type
+      && a.buffer.buffer == b.buffer.buffer
+      && a.buffer.offset == b.buffer.offset
+      && a.buffer.range == b.buffer.range
+      && a.image.sampler == b.image.sampler
+      && a.image.imageView == b.image.imageView
+      && a.image.imageLayout == b.image.imageLayout;
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
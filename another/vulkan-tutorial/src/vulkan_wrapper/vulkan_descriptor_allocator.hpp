@@ -0,0 +1,160 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef VULKAN_DESCRIPTOR_ALLOCATOR_HPP_
+#define VULKAN_DESCRIPTOR_ALLOCATOR_HPP_
+
+#include "vulkan_device.hpp"
+
+#include <unordered_map>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// One descriptor of a set, the key of the set cache. buffer is used for
+/// buffer types, image for image and sampler types. The unused one has to
+/// be zeroed, it is part of the key.
+struct descriptor_binding
+{
+  uint32_t binding;
+  VkDescriptorType type;
+  VkDescriptorBufferInfo buffer;
+  VkDescriptorImageInfo image;
+};
+
+///
+/// Hands out descriptor sets from chains of pools. When a pool runs out a
+/// new, larger one is added, so allocation does not fail for lack of space.
+///
+/// Persistent sets live as long as the allocator. Transient sets belong to
+/// a frame in flight, and begin_frame() resets all of that frame's pools at
+/// once. Persistent sets can also be looked up by their contents through
+/// get_cached(), which only allocates and writes a set the first time.
+/// Cached sets holding a view or buffer that is destroyed are dropped with
+/// invalidate_image_view() / invalidate_buffer() and reused for later
+/// contents, a new handle may have the value of a destroyed one.
+///
+/// Layouts with large arrays (like the bindless set) should keep their own
+/// pool, pools here are sized for ordinary sets.
+class vulkan_descriptor_allocator
+{
+ public:
+  vulkan_descriptor_allocator(std::shared_ptr<vulkan_device> device,
+                              uint32_t num_frames,
+                              uint32_t sets_per_pool = 64);
+  ~vulkan_descriptor_allocator();
+  vulkan_descriptor_allocator(vulkan_descriptor_allocator &&) = delete;
+  vulkan_descriptor_allocator(const vulkan_descriptor_allocator &) = delete;
+  vulkan_descriptor_allocator &operator=(const vulkan_descriptor_allocator &) = delete;
+  vulkan_descriptor_allocator &operator=(vulkan_descriptor_allocator &&) = delete;
+
+  /// Allocates a set that stays valid until the allocator is destroyed.
+  VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+  /// Allocates a set of layout holding bindings that stays valid until
+  /// begin_frame(frame) is called again.
+  VkDescriptorSet allocate_transient(
+      uint32_t frame, VkDescriptorSetLayout layout,
+      const std::vector<descriptor_binding> &bindings);
+
+  /// Resets the transient pools of frame. The GPU must be done with the
+  /// frame's sets.
+  void begin_frame(uint32_t frame);
+
+  /// Returns a persistent set of layout holding bindings, writing it the
+  /// first time these contents are asked for.
+  VkDescriptorSet get_cached(VkDescriptorSetLayout layout,
+                             const std::vector<descriptor_binding> &bindings);
+
+  /// Drops the cached sets that hold image_view, to be written again with
+  /// other contents. Called when the view is destroyed, the GPU must be done
+  /// with those sets.
+  void invalidate_image_view(VkImageView image_view);
+
+  /// Drops the cached sets that hold buffer, like invalidate_image_view().
+  void invalidate_buffer(VkBuffer buffer);
+
+  const uint32_t get_num_pools() const
+  {
+    return num_pools;
+  }
+  const size_t get_num_cached() const
+  {
+    return num_cached;
+  }
+
+ private:
+
+  struct pool_chain
+  {
+    VkDescriptorPool current;
+    std::vector<VkDescriptorPool> full;
+  };
+
+  struct cache_entry
+  {
+    VkDescriptorSetLayout layout;
+    std::vector<descriptor_binding> bindings;
+    VkDescriptorSet descriptor_set;
+  };
+
+  pool_chain persistent;
+  std::vector<pool_chain> transient;
+
+  // pools that were reset and can start a chain again
+  std::vector<VkDescriptorPool> free_pools;
+
+  // entries with the same hash, compared in full on lookup
+  std::unordered_map<size_t, std::vector<cache_entry>> cache;
+
+  // sets of invalidated entries by layout, written again by get_cached()
+  std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> recycled;
+
+  uint32_t sets_per_pool;
+  uint32_t num_pools;
+  size_t num_cached;
+
+  std::shared_ptr<vulkan_device> device;
+
+  VkDescriptorSet allocate(pool_chain &chain, VkDescriptorSetLayout layout);
+
+  template<typename Predicate>
+  void invalidate(Predicate holds);
+
+  VkDescriptorPool get_pool();
+  VkDescriptorPool create_pool(uint32_t max_sets);
+
+  void write(VkDescriptorSet descriptor_set,
+             const std::vector<descriptor_binding> &bindings) const;
+
+  static size_t hash(VkDescriptorSetLayout layout,
+                     const std::vector<descriptor_binding> &bindings);
+  static bool equals(const descriptor_binding &a, const descriptor_binding &b);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_DESCRIPTOR_ALLOCATOR_HPP_
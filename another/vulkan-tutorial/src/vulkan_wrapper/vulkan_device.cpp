@@ -34,6 +34,8 @@ vulkan_device::vulkan_device(
     : device(VK_NULL_HANDLE),
       graphics_queue(VK_NULL_HANDLE),
       present_queue(VK_NULL_HANDLE),
+      enabled_features(),
+      enabled_vulkan12_features(),
       physical_device(physical_device),
       instance(instance)
 {
@@ -75,11 +77,49 @@ void vulkan_device::initialize() const
     queue_create_infos.push_back(queue_create_info);
   }
 
+  auto supported_features = physical_device->get_features();
+  auto supported_vulkan12_features = physical_device->get_vulkan12_features();
+
   VkPhysicalDeviceFeatures device_features = {};
   device_features.samplerAnisotropy = VK_TRUE;
+  device_features.drawIndirectFirstInstance = VK_TRUE;
+  // texture streaming feedback is written from the fragment shaders
+  device_features.fragmentStoresAndAtomics = VK_TRUE;
+  device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+  // 32 bit indices above 2^24 - 1, for large meshes
+  device_features.fullDrawIndexUint32 = supported_features.fullDrawIndexUint32;
+  // block compressed textures are uploaded as they are where supported
+  device_features.textureCompressionBC = supported_features.textureCompressionBC;
+  device_features.textureCompressionETC2 =
+      supported_features.textureCompressionETC2;
+  device_features.textureCompressionASTC_LDR =
+      supported_features.textureCompressionASTC_LDR;
+
+  VkPhysicalDeviceVulkan12Features vulkan12_features = {};
+  vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12_features.timelineSemaphore = VK_TRUE;
+  vulkan12_features.drawIndirectCount =
+      supported_vulkan12_features.drawIndirectCount;
+  // descriptor indexing for vulkan_bindless_descriptors, where supported
+  vulkan12_features.runtimeDescriptorArray =
+      supported_vulkan12_features.runtimeDescriptorArray;
+  vulkan12_features.descriptorBindingPartiallyBound =
+      supported_vulkan12_features.descriptorBindingPartiallyBound;
+  vulkan12_features.descriptorBindingUpdateUnusedWhilePending =
+      supported_vulkan12_features.descriptorBindingUpdateUnusedWhilePending;
+  vulkan12_features.descriptorBindingSampledImageUpdateAfterBind =
+      supported_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind;
+  vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind =
+      supported_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind;
+  vulkan12_features.shaderSampledImageArrayNonUniformIndexing =
+      supported_vulkan12_features.shaderSampledImageArrayNonUniformIndexing;
+  vulkan12_features.shaderStorageBufferArrayNonUniformIndexing =
+      supported_vulkan12_features.shaderStorageBufferArrayNonUniformIndexing;
 
   VkDeviceCreateInfo device_create_info = {};
   device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_create_info.pNext = &vulkan12_features;
   device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
   device_create_info.pQueueCreateInfos = queue_create_infos.data();
   device_create_info.pEnabledFeatures = &device_features;
@@ -98,6 +138,10 @@ void vulkan_device::initialize() const
     throw std::runtime_error("failed to create logical device!");
   }
 
+  enabled_features = device_features;
+  enabled_vulkan12_features = vulkan12_features;
+  enabled_vulkan12_features.pNext = nullptr;
+
   vkGetDeviceQueue(device, indices.graphics_family, 0, &graphics_queue);
   vkGetDeviceQueue(device, indices.present_family, 0, &present_queue);
 }
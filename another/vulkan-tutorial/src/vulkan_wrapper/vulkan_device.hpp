@@ -57,11 +57,24 @@ class vulkan_device
     return present_queue;
   }
 
+  /// Features enabled on the device, a subset of what the physical device
+  /// supports. pNext is cleared.
+  const VkPhysicalDeviceFeatures get_enabled_features() const
+  {
+    return enabled_features;
+  }
+  const VkPhysicalDeviceVulkan12Features get_enabled_vulkan12_features() const
+  {
+    return enabled_vulkan12_features;
+  }
+
  private:
 
   mutable VkDevice device;
   mutable VkQueue graphics_queue;
   mutable VkQueue present_queue;
+  mutable VkPhysicalDeviceFeatures enabled_features;
+  mutable VkPhysicalDeviceVulkan12Features enabled_vulkan12_features;
 
   std::shared_ptr<vulkan_physical_device> physical_device;
   std::shared_ptr<vulkan_instance> instance;
@@ -0,0 +1,421 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_geometry_residency.hpp"
+#include "helper.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+namespace
+{
+
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+VkDeviceSize get_index_size(VkIndexType index_type)
+{
+  return index_type == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+}
+
+}  // namespace
+
+vulkan_geometry_residency::vulkan_geometry_residency(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    std::shared_ptr<vulkan_timeline> timeline,
+    std::shared_ptr<vulkan_deletion_queue> deletion_queue,
+    VkDeviceSize budget, VkDeviceSize page_size, uint32_t vertex_stride,
+    VkIndexType index_type, VkDeviceSize max_upload_size)
+    : buffer(VK_NULL_HANDLE),
+      buffer_memory(VK_NULL_HANDLE),
+      command_pool(VK_NULL_HANDLE),
+      geometries(std::vector<geometry> {}),
+      pages(new util::page_allocator(
+          static_cast<uint32_t>(budget / std::max<VkDeviceSize>(page_size, 1)))),
+      pending_frees(std::deque<pending_free> {}),
+      pending_pages(0),
+      update_count(1),
+      page_size(page_size),
+      vertex_stride(vertex_stride),
+      index_type(index_type),
+      max_upload_size(max_upload_size),
+      device(device),
+      physical_device(physical_device),
+      timeline(timeline),
+      deletion_queue(deletion_queue)
+{
+  if (page_size == 0 || pages->get_num_pages() == 0 || vertex_stride == 0)
+  {
+    throw std::runtime_error("geometry budget holds no pages!");
+  }
+
+  initialize(get_budget());
+}
+
+vulkan_geometry_residency::~vulkan_geometry_residency()
+{
+  vkDestroyCommandPool(device->get_device(), command_pool, nullptr);
+  vkDestroyBuffer(device->get_device(), buffer, nullptr);
+  vkFreeMemory(device->get_device(), buffer_memory, nullptr);
+}
+
+uint32_t vulkan_geometry_residency::add(std::vector<uint8_t> vertex_data,
+                                        std::vector<uint8_t> index_data,
+                                        bool pinned)
+{
+  geometry item = {};
+  item.vertex_data = std::move(vertex_data);
+  item.index_data = std::move(index_data);
+  item.pinned = pinned;
+  item.page_count = get_page_count(item);
+
+  if (item.page_count > pages->get_num_pages())
+  {
+    throw std::runtime_error("geometry is larger than the whole budget!");
+  }
+
+  geometries.push_back(std::move(item));
+  return static_cast<uint32_t>(geometries.size() - 1);
+}
+
+void vulkan_geometry_residency::request(uint32_t id, float priority)
+{
+  auto &item = geometries[id];
+  if (item.last_request != update_count)
+  {
+    item.last_request = update_count;
+    item.priority = priority;
+  } else
+  {
+    item.priority = std::max(item.priority, priority);
+  }
+}
+
+void vulkan_geometry_residency::update()
+{
+  // evicted pages the GPU is done with can be handed out again
+  while (!pending_frees.empty()
+      && timeline->is_complete(pending_frees.front().value))
+  {
+    const auto &run = pending_frees.front();
+    pages->free(run.first_page, run.page_count);
+    pending_pages -= run.page_count;
+    pending_frees.pop_front();
+  }
+
+  std::vector<uint32_t> candidates;
+  for (uint32_t id = 0; id < geometries.size(); id++)
+  {
+    const auto &item = geometries[id];
+    if (!item.resident && (item.pinned || item.last_request == update_count))
+    {
+      candidates.push_back(id);
+    }
+  }
+
+  // pinned geometries first, then by priority
+  std::sort(candidates.begin(), candidates.end(),
+            [this](uint32_t a, uint32_t b)
+            {
+              const auto &first = geometries[a];
+              const auto &second = geometries[b];
+              if (first.pinned != second.pinned)
+              {
+                return first.pinned;
+              }
+              return first.priority > second.priority;
+            });
+
+  std::vector<uint32_t> uploads;
+  VkDeviceSize upload_size = 0;
+  for (auto id : candidates)
+  {
+    const auto &item = geometries[id];
+    auto size = item.vertex_data.size() + item.index_data.size();
+    if (!uploads.empty() && upload_size + size > max_upload_size
+        && !item.pinned)
+    {
+      break;
+    }
+
+    if (allocate(id))
+    {
+      uploads.push_back(id);
+      upload_size += size;
+    }
+  }
+
+  if (!uploads.empty())
+  {
+    submit(uploads, upload_size);
+  }
+
+  update_count++;
+}
+
+void vulkan_geometry_residency::initialize(VkDeviceSize budget) const
+{
+  create_buffer(budget);
+  create_command_pool();
+}
+
+void vulkan_geometry_residency::create_buffer(VkDeviceSize budget) const
+{
+  helper::create_buffer(
+      budget,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+          | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, buffer_memory,
+      device->get_device(), physical_device->get_physical_device());
+}
+
+void vulkan_geometry_residency::create_command_pool() const
+{
+  VkCommandPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pool_info.queueFamilyIndex =
+      physical_device->find_queue_families().graphics_family;
+
+  if (vkCreateCommandPool(device->get_device(), &pool_info, nullptr,
+                          &command_pool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create geometry command pool!");
+  }
+}
+
+uint32_t vulkan_geometry_residency::get_page_count(
+    const geometry &item) const
+{
+  // worst case alignment of the vertices to the stride and the indices to
+  // their size
+  auto size = vertex_stride - 1 + item.vertex_data.size()
+      + get_index_size(index_type) - 1 + item.index_data.size();
+  return static_cast<uint32_t>((size + page_size - 1) / page_size);
+}
+
+bool vulkan_geometry_residency::allocate(uint32_t id)
+{
+  auto &item = geometries[id];
+
+  auto first_page = pages->allocate(item.page_count);
+  if (first_page == util::page_allocator::INVALID_PAGE)
+  {
+    // while evictions are still waiting for the GPU only as much as is
+    // missing is evicted, otherwise at least one geometry for a run
+    bool evicted = false;
+    while ((!evicted && pending_pages == 0)
+        || pages->get_free_pages() + pending_pages < item.page_count)
+    {
+      if (!evict_one())
+      {
+        break;
+      }
+      evicted = true;
+    }
+    return false;
+  }
+
+  auto vertex_start = align_up(first_page * page_size, vertex_stride);
+  auto index_size = get_index_size(index_type);
+  auto index_start = align_up(vertex_start + item.vertex_data.size(),
+                              index_size);
+
+  item.first_page = first_page;
+  item.location.vertex_offset = static_cast<int32_t>(vertex_start
+      / vertex_stride);
+  item.location.first_index = static_cast<uint32_t>(index_start / index_size);
+  return true;
+}
+
+bool vulkan_geometry_residency::evict_one()
+{
+  auto victim = INVALID_GEOMETRY;
+  for (uint32_t id = 0; id < geometries.size(); id++)
+  {
+    const auto &item = geometries[id];
+    if (!item.resident || item.pinned || item.last_request == update_count)
+    {
+      continue;
+    }
+    if (victim == INVALID_GEOMETRY
+        || item.last_request < geometries[victim].last_request)
+    {
+      victim = id;
+    }
+  }
+
+  if (victim == INVALID_GEOMETRY)
+  {
+    return false;
+  }
+
+  // submissions up to the last one may still draw it, new ones will not
+  auto &item = geometries[victim];
+  item.resident = false;
+  pending_free run = { timeline->get_last_value(), item.first_page,
+      item.page_count };
+  pending_frees.push_back(run);
+  pending_pages += item.page_count;
+  return true;
+}
+
+void vulkan_geometry_residency::submit(const std::vector<uint32_t> &uploads,
+                                       VkDeviceSize upload_size)
+{
+  auto vk_device = device->get_device();
+
+  VkBuffer staging_buffer;
+  VkDeviceMemory staging_buffer_memory;
+  helper::create_buffer(
+      upload_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      staging_buffer, staging_buffer_memory, vk_device,
+      physical_device->get_physical_device());
+
+  VkCommandBufferAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  alloc_info.commandPool = command_pool;
+  alloc_info.commandBufferCount = 1;
+
+  VkCommandBuffer command_buffer;
+  if (vkAllocateCommandBuffers(vk_device, &alloc_info, &command_buffer)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate geometry command buffer!");
+  }
+
+  VkCommandBufferBeginInfo begin_info = {};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(command_buffer, &begin_info);
+
+  uint8_t* staging;
+  vkMapMemory(vk_device, staging_buffer_memory, 0, upload_size, 0,
+              reinterpret_cast<void**>(&staging));
+
+  std::vector<VkBufferCopy> regions;
+  VkDeviceSize staging_offset = 0;
+  for (auto id : uploads)
+  {
+    auto &item = geometries[id];
+
+    VkBufferCopy vertex_region = {};
+    vertex_region.srcOffset = staging_offset;
+    vertex_region.dstOffset = static_cast<VkDeviceSize>(
+        item.location.vertex_offset) * vertex_stride;
+    vertex_region.size = item.vertex_data.size();
+    std::memcpy(staging + staging_offset, item.vertex_data.data(),
+                item.vertex_data.size());
+    staging_offset += item.vertex_data.size();
+
+    VkBufferCopy index_region = {};
+    index_region.srcOffset = staging_offset;
+    index_region.dstOffset = static_cast<VkDeviceSize>(
+        item.location.first_index) * get_index_size(index_type);
+    index_region.size = item.index_data.size();
+    std::memcpy(staging + staging_offset, item.index_data.data(),
+                item.index_data.size());
+    staging_offset += item.index_data.size();
+
+    // empty copies are not allowed
+    if (vertex_region.size > 0)
+    {
+      regions.push_back(vertex_region);
+    }
+    if (index_region.size > 0)
+    {
+      regions.push_back(index_region);
+    }
+
+    item.resident = true;
+  }
+
+  vkUnmapMemory(vk_device, staging_buffer_memory);
+
+  if (!regions.empty())
+  {
+    vkCmdCopyBuffer(command_buffer, staging_buffer, buffer,
+                    static_cast<uint32_t>(regions.size()), regions.data());
+  }
+
+  // later submissions on the queue read the copies as vertices and indices
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+      | VK_ACCESS_INDEX_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr);
+
+  vkEndCommandBuffer(command_buffer);
+
+  uint64_t signal_value = timeline->next_value();
+  VkSemaphore signal_semaphore = timeline->get_semaphore();
+
+  VkTimelineSemaphoreSubmitInfo timeline_info = {};
+  timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_info.signalSemaphoreValueCount = 1;
+  timeline_info.pSignalSemaphoreValues = &signal_value;
+
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_info;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &signal_semaphore;
+
+  if (vkQueueSubmit(device->get_graphics_queue(), 1, &submit_info,
+                    VK_NULL_HANDLE) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to submit geometry uploads!");
+  }
+
+  auto pool = command_pool;
+  deletion_queue->retire(signal_value, [=]()
+  {
+    vkFreeCommandBuffers(vk_device, pool, 1, &command_buffer);
+    vkDestroyBuffer(vk_device, staging_buffer, nullptr);
+    vkFreeMemory(vk_device, staging_buffer_memory, nullptr);
+  });
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
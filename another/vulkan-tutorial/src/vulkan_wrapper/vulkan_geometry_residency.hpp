@@ -0,0 +1,189 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_GEOMETRY_RESIDENCY_HPP_
+#define VULKAN_GEOMETRY_RESIDENCY_HPP_
+
+#include <deque>
+
+#include "vulkan_device.hpp"
+#include "vulkan_deletion_queue.hpp"
+#include "../util/page_allocator.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// Where a resident geometry is in the shared buffer, in the units of an
+/// indexed draw
+struct geometry_location
+{
+  uint32_t first_index;
+  int32_t vertex_offset;
+};
+
+///
+/// Vertex and index data in one large device local buffer, bound once as
+/// both vertex and index buffer. The buffer is the budget: it is split into
+/// pages, and every geometry that is resident holds a run of pages with its
+/// vertices followed by its indices.
+///
+/// Each frame the renderer requests the geometries it wants with a priority,
+/// and update() streams in the most important missing ones, evicting the
+/// least recently requested ones to make room. Evicted pages are reused only
+/// once the GPU is done with every submission that could have drawn them.
+/// The CPU keeps a copy of every geometry to stream it in again.
+///
+/// Staging buffers and command buffers go through the deletion queue, which
+/// has to be flushed before this is destroyed.
+class vulkan_geometry_residency
+{
+ public:
+  static const uint32_t INVALID_GEOMETRY = 0xFFFFFFFF;
+
+  /// @param[in] budget size of the shared buffer in bytes
+  /// @param[in] page_size granularity of the suballocation
+  /// @param[in] vertex_stride size of one vertex of every geometry
+  /// @param[in] index_type type of the indices of every geometry
+  /// @param[in] max_upload_size bytes streamed in per update, a larger
+  ///            geometry goes alone
+  vulkan_geometry_residency(
+      std::shared_ptr<vulkan_device> device,
+      std::shared_ptr<vulkan_physical_device> physical_device,
+      std::shared_ptr<vulkan_timeline> timeline,
+      std::shared_ptr<vulkan_deletion_queue> deletion_queue,
+      VkDeviceSize budget, VkDeviceSize page_size, uint32_t vertex_stride,
+      VkIndexType index_type, VkDeviceSize max_upload_size);
+  ~vulkan_geometry_residency();
+  vulkan_geometry_residency(vulkan_geometry_residency &&) = delete;
+  vulkan_geometry_residency(const vulkan_geometry_residency &) = delete;
+  vulkan_geometry_residency &operator=(const vulkan_geometry_residency &) = delete;
+  vulkan_geometry_residency &operator=(vulkan_geometry_residency &&) = delete;
+
+  /// Registers a geometry, not resident until an update streams it in.
+  /// Pinned geometries are streamed in first and never evicted.
+  ///
+  /// return the id of the geometry
+  uint32_t add(std::vector<uint8_t> vertex_data,
+               std::vector<uint8_t> index_data, bool pinned);
+
+  /// Asks for id to be resident. Priorities of the same frame are not
+  /// added up, the highest one counts.
+  void request(uint32_t id, float priority);
+
+  /// Evicts and streams in for the requests since the last update, and
+  /// submits the copies. Geometries streamed in can be drawn by every
+  /// submission after this one.
+  void update();
+
+  bool is_resident(uint32_t id) const
+  {
+    return geometries[id].resident;
+  }
+  const geometry_location &get_location(uint32_t id) const
+  {
+    return geometries[id].location;
+  }
+  const VkBuffer get_buffer() const
+  {
+    return buffer;
+  }
+  const VkIndexType get_index_type() const
+  {
+    return index_type;
+  }
+  const VkDeviceSize get_budget() const
+  {
+    return page_size * pages->get_num_pages();
+  }
+  /// bytes held by resident geometries and pages waiting for the GPU
+  const VkDeviceSize get_used_size() const
+  {
+    return page_size * (pages->get_num_pages() - pages->get_free_pages());
+  }
+
+ private:
+
+  struct geometry
+  {
+    std::vector<uint8_t> vertex_data;
+    std::vector<uint8_t> index_data;
+    geometry_location location;
+    uint32_t first_page;
+    uint32_t page_count;
+    /// update the geometry was last requested before
+    uint64_t last_request;
+    float priority;
+    bool pinned;
+    bool resident;
+  };
+
+  /// pages of an evicted geometry, free once the GPU has reached value
+  struct pending_free
+  {
+    uint64_t value;
+    uint32_t first_page;
+    uint32_t page_count;
+  };
+
+  mutable VkBuffer buffer;
+  mutable VkDeviceMemory buffer_memory;
+  mutable VkCommandPool command_pool;
+
+  std::vector<geometry> geometries;
+  std::unique_ptr<util::page_allocator> pages;
+  std::deque<pending_free> pending_frees;
+  uint32_t pending_pages;
+  uint64_t update_count;
+
+  VkDeviceSize page_size;
+  uint32_t vertex_stride;
+  VkIndexType index_type;
+  VkDeviceSize max_upload_size;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+  std::shared_ptr<vulkan_timeline> timeline;
+  std::shared_ptr<vulkan_deletion_queue> deletion_queue;
+
+  void initialize(VkDeviceSize budget) const;
+  void create_buffer(VkDeviceSize budget) const;
+  void create_command_pool() const;
+
+  uint32_t get_page_count(const geometry &item) const;
+
+  /// Places id in a run of pages. Without room it evicts towards enough,
+  /// the evicted pages come back once the GPU is done with them.
+  bool allocate(uint32_t id);
+
+  /// Evicts the least recently requested geometry not wanted by this update
+  bool evict_one();
+
+  /// Copies the geometries to their pages and makes them resident
+  void submit(const std::vector<uint32_t> &uploads, VkDeviceSize upload_size);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_GEOMETRY_RESIDENCY_HPP_
@@ -0,0 +1,428 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_gpu_culling.hpp"
+#include "helper.hpp"
+#include "../util/file_handler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+namespace
+{
+const uint32_t CULL_GROUP_SIZE = 64;
+}
+
+vulkan_gpu_culling::vulkan_gpu_culling(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    std::shared_ptr<vulkan_indirect_draws> indirect_draws,
+    std::shared_ptr<vulkan_hiz_pyramid> hiz_pyramid,
+    const std::vector<cull_object> &objects, bool in_place)
+    : object_buffer(VK_NULL_HANDLE),
+      object_buffer_memory(VK_NULL_HANDLE),
+      view_buffers(std::vector<VkBuffer> {}),
+      view_buffers_memory(std::vector<VkDeviceMemory> {}),
+      view_buffers_mapped(std::vector<void*> {}),
+      range_buffers(std::vector<VkBuffer> {}),
+      range_buffers_memory(std::vector<VkDeviceMemory> {}),
+      range_buffers_mapped(std::vector<void*> {}),
+      descriptor_set_layout(VK_NULL_HANDLE),
+      descriptor_pool(VK_NULL_HANDLE),
+      descriptor_sets(std::vector<VkDescriptorSet> {}),
+      pipeline_layout(VK_NULL_HANDLE),
+      pipeline(VK_NULL_HANDLE),
+      num_objects(static_cast<uint32_t>(objects.size())),
+      compact(indirect_draws->has_draw_count() && !in_place),
+      device(device),
+      physical_device(physical_device),
+      indirect_draws(indirect_draws),
+      hiz_pyramid(hiz_pyramid)
+{
+  if (num_objects > indirect_draws->get_max_draws())
+  {
+    throw std::runtime_error("more objects to cull than draws in the lists!");
+  }
+
+  initialize(objects);
+}
+
+vulkan_gpu_culling::~vulkan_gpu_culling()
+{
+  vkDestroyPipeline(device->get_device(), pipeline, nullptr);
+  vkDestroyPipelineLayout(device->get_device(), pipeline_layout, nullptr);
+  vkDestroyDescriptorPool(device->get_device(), descriptor_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device->get_device(), descriptor_set_layout,
+                               nullptr);
+
+  for (size_t i = 0; i < view_buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), view_buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), view_buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), view_buffers_memory[i], nullptr);
+  }
+
+  for (size_t i = 0; i < range_buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), range_buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), range_buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), range_buffers_memory[i], nullptr);
+  }
+
+  vkDestroyBuffer(device->get_device(), object_buffer, nullptr);
+  vkFreeMemory(device->get_device(), object_buffer_memory, nullptr);
+}
+
+void vulkan_gpu_culling::update(uint32_t index, const cull_view &view)
+{
+  std::memcpy(view_buffers_mapped[index], &view, sizeof(view));
+}
+
+void vulkan_gpu_culling::update_ranges(uint32_t index,
+                                       const cull_range *ranges,
+                                       uint32_t count)
+{
+  if (count > num_objects)
+  {
+    throw std::runtime_error("more culling ranges than objects!");
+  }
+  std::memcpy(range_buffers_mapped[index], ranges, sizeof(cull_range) * count);
+}
+
+void vulkan_gpu_culling::record(VkCommandBuffer command_buffer,
+                                uint32_t index) const
+{
+  auto draw_buffer = indirect_draws->get_buffer(index);
+
+  // the previous use of the list has to be drawn before it is overwritten
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+      | VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = draw_buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(
+      command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+      0, nullptr, 1, &barrier, 0, nullptr);
+
+  auto num_invocations = num_objects;
+  if (compact)
+  {
+    vkCmdFillBuffer(command_buffer, draw_buffer, 0, sizeof(uint32_t), 0);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+        | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                         &barrier, 0, nullptr);
+  } else
+  {
+    // in place every slot is drawn, so every slot is written
+    num_invocations = indirect_draws->get_max_draws();
+  }
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline_layout, 0, 1, &descriptor_sets[index], 0,
+                          nullptr);
+  vkCmdDispatch(command_buffer,
+                (num_invocations + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1,
+                1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr);
+}
+
+void vulkan_gpu_culling::initialize(
+    const std::vector<cull_object> &objects) const
+{
+  create_buffers(objects);
+  create_pipeline();
+  create_descriptor_sets();
+}
+
+void vulkan_gpu_culling::create_buffers(
+    const std::vector<cull_object> &objects) const
+{
+  // objects are written once, a zero sized buffer is not allowed
+  VkDeviceSize object_size = sizeof(cull_object)
+      * std::max<size_t>(objects.size(), 1);
+
+  helper::create_buffer(
+      object_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      object_buffer, object_buffer_memory, device->get_device(),
+      physical_device->get_physical_device());
+
+  void* data;
+  vkMapMemory(device->get_device(), object_buffer_memory, 0, object_size, 0,
+              &data);
+  std::memcpy(data, objects.data(), sizeof(cull_object) * objects.size());
+  vkUnmapMemory(device->get_device(), object_buffer_memory);
+
+  auto num_lists = indirect_draws->get_num_lists();
+  view_buffers.resize(num_lists);
+  view_buffers_memory.resize(num_lists);
+  view_buffers_mapped.resize(num_lists);
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    helper::create_buffer(
+        sizeof(cull_view), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        view_buffers[i], view_buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    vkMapMemory(device->get_device(), view_buffers_memory[i], 0,
+                sizeof(cull_view), 0, &view_buffers_mapped[i]);
+    std::memset(view_buffers_mapped[i], 0, sizeof(cull_view));
+  }
+
+  // every list starts out with the ranges the objects were created with
+  VkDeviceSize range_size = sizeof(cull_range)
+      * std::max<size_t>(objects.size(), 1);
+  range_buffers.resize(num_lists);
+  range_buffers_memory.resize(num_lists);
+  range_buffers_mapped.resize(num_lists);
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    helper::create_buffer(
+        range_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        range_buffers[i], range_buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    vkMapMemory(device->get_device(), range_buffers_memory[i], 0, range_size,
+                0, &range_buffers_mapped[i]);
+
+    auto ranges = static_cast<cull_range*>(range_buffers_mapped[i]);
+    for (size_t j = 0; j < objects.size(); j++)
+    {
+      ranges[j].index_count = objects[j].index_count;
+      ranges[j].first_index = objects[j].first_index;
+    }
+  }
+}
+
+void vulkan_gpu_culling::create_pipeline() const
+{
+  std::array<VkDescriptorSetLayoutBinding, 5> bindings = {};
+  bindings[0].binding = 0;
+  bindings[0].descriptorCount = 1;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  bindings[1].binding = 1;
+  bindings[1].descriptorCount = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  bindings[2].binding = 2;
+  bindings[2].descriptorCount = 1;
+  bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  bindings[3].binding = 3;
+  bindings[3].descriptorCount = 1;
+  bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  bindings[4].binding = 4;
+  bindings[4].descriptorCount = 1;
+  bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(device->get_device(), &layout_info, nullptr,
+                                  &descriptor_set_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create culling descriptor set layout!");
+  }
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+
+  if (vkCreatePipelineLayout(device->get_device(), &pipeline_layout_info,
+                             nullptr, &pipeline_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create culling pipeline layout!");
+  }
+
+  VkBool32 compact_value = compact ? VK_TRUE : VK_FALSE;
+
+  VkSpecializationMapEntry compact_entry = {};
+  compact_entry.constantID = 0;
+  compact_entry.offset = 0;
+  compact_entry.size = sizeof(compact_value);
+
+  VkSpecializationInfo specialization_info = {};
+  specialization_info.mapEntryCount = 1;
+  specialization_info.pMapEntries = &compact_entry;
+  specialization_info.dataSize = sizeof(compact_value);
+  specialization_info.pData = &compact_value;
+
+  auto shader_code = util::file_handler::read_binary_file("shaders/cull.spv");
+  auto shader_module = helper::create_shader_module(shader_code,
+                                                    device->get_device());
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.stage.pSpecializationInfo = &specialization_info;
+  pipeline_info.layout = pipeline_layout;
+
+  auto result = vkCreateComputePipelines(device->get_device(), VK_NULL_HANDLE,
+                                         1, &pipeline_info, nullptr,
+                                         &pipeline);
+
+  vkDestroyShaderModule(device->get_device(), shader_module, nullptr);
+
+  if (result != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create culling pipeline!");
+  }
+}
+
+void vulkan_gpu_culling::create_descriptor_sets() const
+{
+  auto num_lists = indirect_draws->get_num_lists();
+
+  std::array<VkDescriptorPoolSize, 3> pool_sizes = {};
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  pool_sizes[0].descriptorCount = num_lists;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  pool_sizes[1].descriptorCount = 3 * num_lists;
+  pool_sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_sizes[2].descriptorCount = num_lists;
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = num_lists;
+
+  if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr,
+                             &descriptor_pool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create culling descriptor pool!");
+  }
+
+  std::vector<VkDescriptorSetLayout> layouts(num_lists, descriptor_set_layout);
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = descriptor_pool;
+  alloc_info.descriptorSetCount = num_lists;
+  alloc_info.pSetLayouts = layouts.data();
+
+  descriptor_sets.resize(num_lists);
+  if (vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                               descriptor_sets.data()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate culling descriptor sets!");
+  }
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    VkDescriptorBufferInfo view_info = {};
+    view_info.buffer = view_buffers[i];
+    view_info.offset = 0;
+    view_info.range = sizeof(cull_view);
+
+    VkDescriptorBufferInfo object_info = {};
+    object_info.buffer = object_buffer;
+    object_info.offset = 0;
+    object_info.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo draw_info = {};
+    draw_info.buffer = indirect_draws->get_buffer(i);
+    draw_info.offset = 0;
+    draw_info.range = VK_WHOLE_SIZE;
+
+    VkDescriptorImageInfo hiz_info = {};
+    hiz_info.sampler = hiz_pyramid->get_sampler();
+    hiz_info.imageView = hiz_pyramid->get_image_view();
+    hiz_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkDescriptorBufferInfo range_info = {};
+    range_info.buffer = range_buffers[i];
+    range_info.offset = 0;
+    range_info.range = VK_WHOLE_SIZE;
+
+    std::array<VkWriteDescriptorSet, 5> writes = {};
+    for (uint32_t binding = 0; binding < writes.size(); binding++)
+    {
+      writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[binding].dstSet = descriptor_sets[i];
+      writes[binding].dstBinding = binding;
+      writes[binding].descriptorCount = 1;
+    }
+
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    writes[0].pBufferInfo = &view_info;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[1].pBufferInfo = &object_info;
+    writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[2].pBufferInfo = &draw_info;
+    writes[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[3].pImageInfo = &hiz_info;
+    writes[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[4].pBufferInfo = &range_info;
+
+    vkUpdateDescriptorSets(device->get_device(),
+                           static_cast<uint32_t>(writes.size()), writes.data(),
+                           0, nullptr);
+  }
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
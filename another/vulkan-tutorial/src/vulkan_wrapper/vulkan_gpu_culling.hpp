@@ -0,0 +1,152 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_GPU_CULLING_HPP_
+#define VULKAN_GPU_CULLING_HPP_
+
+#include "vulkan_device.hpp"
+#include "vulkan_indirect_draws.hpp"
+#include "vulkan_hiz_pyramid.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// An object as seen by the culling shader: its bounding sphere and the
+/// draw it turns into when visible. Matches CullObject in cull.comp.
+struct cull_object
+{
+  float sphere[4];
+  uint32_t index_count;
+  uint32_t first_index;
+  int32_t vertex_offset;
+  uint32_t first_instance;
+};
+
+/// The index range an object is drawn with this frame, its level of detail
+/// where that is resident. Matches CullRange in cull.comp and replaces the
+/// range and vertex offset in cull_object.
+struct cull_range
+{
+  uint32_t index_count;
+  uint32_t first_index;
+  int32_t vertex_offset;
+};
+
+/// Per frame culling input, uniform buffer layout of CullView in cull.comp.
+/// Planes and matrices are in the space the spheres are given in.
+struct cull_view
+{
+  float planes[6][4];
+  float previous_view_projection[16];
+  float hiz_size[2];
+  uint32_t object_count;
+  uint32_t hiz_enabled;
+  uint32_t hiz_levels;
+  uint32_t padding[3];
+};
+
+///
+/// Compute pass culling objects against the frustum and a Hi-Z pyramid of
+/// the previous frame, writing the visible ones into the lists of a
+/// vulkan_indirect_draws. With drawIndirectCount the draws are compacted and
+/// the count is produced on the GPU, otherwise culled slots get
+/// instanceCount = 0. Written in place, slot i of a list also tells whether
+/// object i is visible, which is how vulkan_cluster_culling reads it.
+///
+/// The pass is recorded in front of the render pass on the same queue, so
+/// the draw lists must not be written by the CPU while it is in use.
+class vulkan_gpu_culling
+{
+ public:
+  vulkan_gpu_culling(std::shared_ptr<vulkan_device> device,
+                     std::shared_ptr<vulkan_physical_device> physical_device,
+                     std::shared_ptr<vulkan_indirect_draws> indirect_draws,
+                     std::shared_ptr<vulkan_hiz_pyramid> hiz_pyramid,
+                     const std::vector<cull_object> &objects,
+                     bool in_place = false);
+  ~vulkan_gpu_culling();
+  vulkan_gpu_culling(vulkan_gpu_culling &&) = delete;
+  vulkan_gpu_culling(const vulkan_gpu_culling &) = delete;
+  vulkan_gpu_culling &operator=(const vulkan_gpu_culling &) = delete;
+  vulkan_gpu_culling &operator=(vulkan_gpu_culling &&) = delete;
+
+  /// Sets the view list index is culled against. The GPU must be done with it.
+  void update(uint32_t index, const cull_view &view);
+
+  /// Sets the index ranges of the first count objects for list index, the
+  /// others keep their last range. The GPU must be done with it.
+  void update_ranges(uint32_t index, const cull_range *ranges,
+                     uint32_t count);
+
+  /// Records the culling of list index into command_buffer, outside of a
+  /// render pass.
+  void record(VkCommandBuffer command_buffer, uint32_t index) const;
+
+  const uint32_t get_num_objects() const
+  {
+    return num_objects;
+  }
+  const bool is_compact() const
+  {
+    return compact;
+  }
+
+ private:
+
+  mutable VkBuffer object_buffer;
+  mutable VkDeviceMemory object_buffer_memory;
+
+  mutable std::vector<VkBuffer> view_buffers;
+  mutable std::vector<VkDeviceMemory> view_buffers_memory;
+  mutable std::vector<void*> view_buffers_mapped;
+
+  mutable std::vector<VkBuffer> range_buffers;
+  mutable std::vector<VkDeviceMemory> range_buffers_memory;
+  mutable std::vector<void*> range_buffers_mapped;
+
+  mutable VkDescriptorSetLayout descriptor_set_layout;
+  mutable VkDescriptorPool descriptor_pool;
+  mutable std::vector<VkDescriptorSet> descriptor_sets;
+  mutable VkPipelineLayout pipeline_layout;
+  mutable VkPipeline pipeline;
+
+  uint32_t num_objects;
+  bool compact;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+  std::shared_ptr<vulkan_indirect_draws> indirect_draws;
+  std::shared_ptr<vulkan_hiz_pyramid> hiz_pyramid;
+
+  void initialize(const std::vector<cull_object> &objects) const;
+
+  void create_buffers(const std::vector<cull_object> &objects) const;
+  void create_pipeline() const;
+  void create_descriptor_sets() const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_GPU_CULLING_HPP_
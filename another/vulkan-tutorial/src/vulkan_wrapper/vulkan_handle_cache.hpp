@@ -0,0 +1,182 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_HANDLE_CACHE_HPP_
+#define VULKAN_HANDLE_CACHE_HPP_
+
+#include "vulkan_device.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Shares Vulkan handles created from equal create infos. acquire() returns
+/// the existing handle for an equal create info and counts the reference,
+/// release() destroys the handle when the last one goes. The caches of the
+/// different handle types only supply how their create info is hashed and
+/// compared.
+///
+/// The pNext chain is not part of the key and must be null.
+template<typename CreateInfo, typename Handle>
+class vulkan_handle_cache
+{
+ public:
+  typedef VkResult (VKAPI_PTR *create_function)(
+      VkDevice, const CreateInfo*, const VkAllocationCallbacks*, Handle*);
+  typedef void (VKAPI_PTR *destroy_function)(VkDevice, Handle,
+                                             const VkAllocationCallbacks*);
+  typedef size_t (*hash_function)(const CreateInfo&);
+  typedef bool (*equals_function)(const CreateInfo&, const CreateInfo&);
+
+  /// @param[in] name the kind of handle, for error messages
+  /// @param[in] max_handles distinct handles alive at once
+  vulkan_handle_cache(std::shared_ptr<vulkan_device> device,
+                      create_function create, destroy_function destroy,
+                      hash_function hash, equals_function equals,
+                      std::string name,
+                      size_t max_handles = std::numeric_limits<size_t>::max())
+      : device(device),
+        create(create),
+        destroy(destroy),
+        hash(hash),
+        equals(equals),
+        name(name),
+        max_handles(max_handles)
+  {
+  }
+  ~vulkan_handle_cache()
+  {
+    for (const auto &handle : handles)
+    {
+      destroy(device->get_device(), handle.first, nullptr);
+    }
+  }
+  vulkan_handle_cache(vulkan_handle_cache &&) = delete;
+  vulkan_handle_cache(const vulkan_handle_cache &) = delete;
+  vulkan_handle_cache &operator=(const vulkan_handle_cache &) = delete;
+  vulkan_handle_cache &operator=(vulkan_handle_cache &&) = delete;
+
+  Handle acquire(const CreateInfo &create_info)
+  {
+    auto key = hash(create_info);
+    auto &bucket = entries[key];
+
+    for (auto &entry : bucket)
+    {
+      if (equals(entry.create_info, create_info))
+      {
+        entry.references++;
+        return entry.handle;
+      }
+    }
+
+    if (handles.size() >= max_handles)
+    {
+      throw std::runtime_error("too many distinct " + name + "s!");
+    }
+
+    entry new_entry;
+    new_entry.create_info = create_info;
+    new_entry.create_info.pNext = nullptr;
+    new_entry.references = 1;
+
+    if (create(device->get_device(), &create_info, nullptr,
+               &new_entry.handle) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create " + name + "!");
+    }
+
+    bucket.push_back(new_entry);
+    handles[new_entry.handle] = key;
+
+    return new_entry.handle;
+  }
+
+  /// Drops a reference. No submitted work may still use the handle if it
+  /// is the last one, retire the call through the deletion queue.
+  void release(Handle handle)
+  {
+    auto found = handles.find(handle);
+    if (found == handles.end())
+    {
+      throw std::runtime_error("released a handle that is not in the "
+          + name + " cache!");
+    }
+
+    auto &bucket = entries[found->second];
+    for (size_t i = 0; i < bucket.size(); i++)
+    {
+      if (bucket[i].handle == handle && --bucket[i].references == 0)
+      {
+        destroy(device->get_device(), handle, nullptr);
+        bucket.erase(bucket.begin() + i);
+        if (bucket.empty())
+        {
+          entries.erase(found->second);
+        }
+        handles.erase(found);
+        return;
+      }
+    }
+  }
+
+  /// Number of distinct handles alive.
+  const size_t get_num_handles() const
+  {
+    return handles.size();
+  }
+
+ private:
+
+  struct entry
+  {
+    CreateInfo create_info;
+    Handle handle;
+    uint32_t references;
+  };
+
+  // entries with the same hash, compared in full on lookup
+  std::unordered_map<size_t, std::vector<entry>> entries;
+  // the hash of every live handle, to find its entry on release
+  std::unordered_map<Handle, size_t> handles;
+
+  std::shared_ptr<vulkan_device> device;
+  create_function create;
+  destroy_function destroy;
+  hash_function hash;
+  equals_function equals;
+  std::string name;
+  size_t max_handles;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_HANDLE_CACHE_HPP_
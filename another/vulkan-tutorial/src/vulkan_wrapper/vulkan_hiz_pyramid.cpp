@@ -0,0 +1,475 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_hiz_pyramid.hpp"
+#include "helper.hpp"
+#include "vulkan_push_constants.hpp"
+#include "../util/file_handler.hpp"
+
+#include <algorithm>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+namespace
+{
+
+// matches the push constant block of hiz.comp
+struct hiz_sizes
+{
+  int32_t source_size[2];
+  int32_t destination_size[2];
+};
+
+typedef vulkan_push_constants<hiz_sizes> hiz_push_constants;
+
+}  // namespace
+
+vulkan_hiz_pyramid::vulkan_hiz_pyramid(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    VkExtent2D depth_extent, VkImageView depth_view)
+    : image(VK_NULL_HANDLE),
+      image_memory(VK_NULL_HANDLE),
+      image_view(VK_NULL_HANDLE),
+      level_views(std::vector<VkImageView> {}),
+      sampler(VK_NULL_HANDLE),
+      descriptor_set_layout(VK_NULL_HANDLE),
+      descriptor_pool(VK_NULL_HANDLE),
+      descriptor_sets(std::vector<VkDescriptorSet> {}),
+      pipeline_layout(VK_NULL_HANDLE),
+      pipeline(VK_NULL_HANDLE),
+      depth_extent(depth_extent),
+      extent(
+      {
+          std::max(depth_extent.width / 2, 1u),
+          std::max(depth_extent.height / 2, 1u)
+      }),
+      num_levels(1),
+      device(device),
+      physical_device(physical_device)
+{
+  auto size = std::max(extent.width, extent.height);
+  while (size > 1)
+  {
+    size /= 2;
+    num_levels++;
+  }
+
+  initialize(depth_view);
+}
+
+vulkan_hiz_pyramid::~vulkan_hiz_pyramid()
+{
+  vkDestroyPipeline(device->get_device(), pipeline, nullptr);
+  vkDestroyPipelineLayout(device->get_device(), pipeline_layout, nullptr);
+  vkDestroyDescriptorPool(device->get_device(), descriptor_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device->get_device(), descriptor_set_layout,
+                               nullptr);
+  vkDestroySampler(device->get_device(), sampler, nullptr);
+
+  for (const auto &level_view : level_views)
+  {
+    vkDestroyImageView(device->get_device(), level_view, nullptr);
+  }
+  vkDestroyImageView(device->get_device(), image_view, nullptr);
+  vkDestroyImage(device->get_device(), image, nullptr);
+  vkFreeMemory(device->get_device(), image_memory, nullptr);
+}
+
+void vulkan_hiz_pyramid::record_initial_transition(
+    VkCommandBuffer command_buffer) const
+{
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = num_levels;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  VkClearColorValue far_plane = {};
+  far_plane.float32[0] = 1.0f;
+  vkCmdClearColorImage(command_buffer, image, VK_IMAGE_LAYOUT_GENERAL,
+                       &far_plane, 1, &barrier.subresourceRange);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
+
+void vulkan_hiz_pyramid::record_build(VkCommandBuffer command_buffer,
+                                      VkImage depth_image,
+                                      VkImageAspectFlags depth_aspect) const
+{
+  std::array<VkImageMemoryBarrier, 2> barriers = {};
+
+  // depth writes of the scene have to land before they are reduced
+  barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+  barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[0].image = depth_image;
+  barriers[0].subresourceRange.aspectMask = depth_aspect;
+  barriers[0].subresourceRange.baseMipLevel = 0;
+  barriers[0].subresourceRange.levelCount = 1;
+  barriers[0].subresourceRange.baseArrayLayer = 0;
+  barriers[0].subresourceRange.layerCount = 1;
+
+  // and the culling pass of this frame has to be done reading the pyramid
+  barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[1].image = image;
+  barriers[1].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barriers[1].subresourceRange.baseMipLevel = 0;
+  barriers[1].subresourceRange.levelCount = num_levels;
+  barriers[1].subresourceRange.baseArrayLayer = 0;
+  barriers[1].subresourceRange.layerCount = 1;
+
+  vkCmdPipelineBarrier(
+      command_buffer,
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
+          | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+      static_cast<uint32_t>(barriers.size()), barriers.data());
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+  auto source_extent = depth_extent;
+  for (uint32_t level = 0; level < num_levels; level++)
+  {
+    auto level_extent = get_level_extent(level);
+
+    hiz_sizes sizes =
+    {
+        { static_cast<int32_t>(source_extent.width),
+          static_cast<int32_t>(source_extent.height) },
+        { static_cast<int32_t>(level_extent.width),
+          static_cast<int32_t>(level_extent.height) }
+    };
+
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipeline_layout, 0, 1, &descriptor_sets[level], 0,
+                            nullptr);
+    hiz_push_constants::push(command_buffer, pipeline_layout,
+                             VK_SHADER_STAGE_COMPUTE_BIT, sizes);
+    vkCmdDispatch(command_buffer, (level_extent.width + 7) / 8,
+                  (level_extent.height + 7) / 8, 1);
+
+    // the next level reads this one, the next frame's culling reads all
+    VkImageMemoryBarrier barrier = barriers[1];
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.subresourceRange.baseMipLevel = level;
+    barrier.subresourceRange.levelCount = 1;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    source_extent = level_extent;
+  }
+}
+
+void vulkan_hiz_pyramid::initialize(VkImageView depth_view) const
+{
+  create_image();
+  create_sampler();
+  create_pipeline();
+  create_descriptor_sets(depth_view);
+}
+
+void vulkan_hiz_pyramid::create_image() const
+{
+  VkImageCreateInfo image_info = {};
+  image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  image_info.imageType = VK_IMAGE_TYPE_2D;
+  image_info.extent.width = extent.width;
+  image_info.extent.height = extent.height;
+  image_info.extent.depth = 1;
+  image_info.mipLevels = num_levels;
+  image_info.arrayLayers = 1;
+  image_info.format = VK_FORMAT_R32_SFLOAT;
+  image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  image_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+      | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+  image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  if (vkCreateImage(device->get_device(), &image_info, nullptr, &image)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z image!");
+  }
+
+  VkMemoryRequirements mem_requirements;
+  vkGetImageMemoryRequirements(device->get_device(), image, &mem_requirements);
+
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = mem_requirements.size;
+  alloc_info.memoryTypeIndex = helper::find_memory_type(
+      mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      physical_device->get_physical_device());
+
+  if (vkAllocateMemory(device->get_device(), &alloc_info, nullptr,
+                       &image_memory) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate hi-z image memory!");
+  }
+
+  vkBindImageMemory(device->get_device(), image, image_memory, 0);
+
+  VkImageViewCreateInfo view_info = {};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.image = image;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = VK_FORMAT_R32_SFLOAT;
+  view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  view_info.subresourceRange.baseMipLevel = 0;
+  view_info.subresourceRange.levelCount = num_levels;
+  view_info.subresourceRange.baseArrayLayer = 0;
+  view_info.subresourceRange.layerCount = 1;
+
+  if (vkCreateImageView(device->get_device(), &view_info, nullptr, &image_view)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z image view!");
+  }
+
+  level_views.resize(num_levels);
+  for (uint32_t level = 0; level < num_levels; level++)
+  {
+    view_info.subresourceRange.baseMipLevel = level;
+    view_info.subresourceRange.levelCount = 1;
+
+    if (vkCreateImageView(device->get_device(), &view_info, nullptr,
+                          &level_views[level]) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create hi-z level view!");
+    }
+  }
+}
+
+void vulkan_hiz_pyramid::create_sampler() const
+{
+  // only fetched with explicit levels, never filtered
+  VkSamplerCreateInfo sampler_info = {};
+  sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampler_info.magFilter = VK_FILTER_NEAREST;
+  sampler_info.minFilter = VK_FILTER_NEAREST;
+  sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.anisotropyEnable = VK_FALSE;
+  sampler_info.maxAnisotropy = 1.0f;
+  sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+  sampler_info.unnormalizedCoordinates = VK_FALSE;
+  sampler_info.compareEnable = VK_FALSE;
+  sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+  sampler_info.minLod = 0.0f;
+  sampler_info.maxLod = static_cast<float>(num_levels);
+
+  if (vkCreateSampler(device->get_device(), &sampler_info, nullptr, &sampler)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z sampler!");
+  }
+}
+
+void vulkan_hiz_pyramid::create_pipeline() const
+{
+  std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+  bindings[0].binding = 0;
+  bindings[0].descriptorCount = 1;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  bindings[1].binding = 1;
+  bindings[1].descriptorCount = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(device->get_device(), &layout_info, nullptr,
+                                  &descriptor_set_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z descriptor set layout!");
+  }
+
+  auto push_constant_range = hiz_push_constants::get_range(
+      VK_SHADER_STAGE_COMPUTE_BIT, physical_device);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+  if (vkCreatePipelineLayout(device->get_device(), &pipeline_layout_info,
+                             nullptr, &pipeline_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z pipeline layout!");
+  }
+
+  auto shader_code = util::file_handler::read_binary_file("shaders/hiz.spv");
+  auto shader_module = helper::create_shader_module(shader_code,
+                                                    device->get_device());
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.layout = pipeline_layout;
+
+  auto result = vkCreateComputePipelines(device->get_device(), VK_NULL_HANDLE,
+                                         1, &pipeline_info, nullptr,
+                                         &pipeline);
+
+  vkDestroyShaderModule(device->get_device(), shader_module, nullptr);
+
+  if (result != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z pipeline!");
+  }
+}
+
+void vulkan_hiz_pyramid::create_descriptor_sets(VkImageView depth_view) const
+{
+  std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_sizes[0].descriptorCount = num_levels;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  pool_sizes[1].descriptorCount = num_levels;
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = num_levels;
+
+  if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr,
+                             &descriptor_pool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create hi-z descriptor pool!");
+  }
+
+  std::vector<VkDescriptorSetLayout> layouts(num_levels,
+                                             descriptor_set_layout);
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = descriptor_pool;
+  alloc_info.descriptorSetCount = num_levels;
+  alloc_info.pSetLayouts = layouts.data();
+
+  descriptor_sets.resize(num_levels);
+  if (vkAllocateDescriptorSets(device->get_device(), &alloc_info,
+                               descriptor_sets.data()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate hi-z descriptor sets!");
+  }
+
+  for (uint32_t level = 0; level < num_levels; level++)
+  {
+    // level 0 reduces the depth buffer, the others the level below
+    VkDescriptorImageInfo source_info = {};
+    source_info.sampler = sampler;
+    if (level == 0)
+    {
+      source_info.imageView = depth_view;
+      source_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    } else
+    {
+      source_info.imageView = level_views[level - 1];
+      source_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    VkDescriptorImageInfo destination_info = {};
+    destination_info.imageView = level_views[level];
+    destination_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkWriteDescriptorSet, 2> writes = {};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = descriptor_sets[level];
+    writes[0].dstBinding = 0;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].descriptorCount = 1;
+    writes[0].pImageInfo = &source_info;
+
+    writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstSet = descriptor_sets[level];
+    writes[1].dstBinding = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].descriptorCount = 1;
+    writes[1].pImageInfo = &destination_info;
+
+    vkUpdateDescriptorSets(device->get_device(),
+                           static_cast<uint32_t>(writes.size()), writes.data(),
+                           0, nullptr);
+  }
+}
+
+VkExtent2D vulkan_hiz_pyramid::get_level_extent(uint32_t level) const
+{
+  return
+  {
+    std::max(extent.width >> level, 1u),
+    std::max(extent.height >> level, 1u)
+  };
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
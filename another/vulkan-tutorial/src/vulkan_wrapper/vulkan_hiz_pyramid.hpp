@@ -0,0 +1,114 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_HIZ_PYRAMID_HPP_
+#define VULKAN_HIZ_PYRAMID_HPP_
+
+#include "vulkan_device.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Hierarchical depth pyramid for occlusion culling. Level 0 is half the
+/// size of the depth buffer and every texel of a level holds the farthest
+/// depth of the texels it covers in the level below.
+///
+/// The pyramid is rebuilt with a compute shader after the scene has been
+/// drawn, and read by the culling pass of the next frame. The image stays in
+/// VK_IMAGE_LAYOUT_GENERAL after record_initial_transition().
+class vulkan_hiz_pyramid
+{
+ public:
+  vulkan_hiz_pyramid(std::shared_ptr<vulkan_device> device,
+                     std::shared_ptr<vulkan_physical_device> physical_device,
+                     VkExtent2D depth_extent, VkImageView depth_view);
+  ~vulkan_hiz_pyramid();
+  vulkan_hiz_pyramid(vulkan_hiz_pyramid &&) = delete;
+  vulkan_hiz_pyramid(const vulkan_hiz_pyramid &) = delete;
+  vulkan_hiz_pyramid &operator=(const vulkan_hiz_pyramid &) = delete;
+  vulkan_hiz_pyramid &operator=(vulkan_hiz_pyramid &&) = delete;
+
+  /// Moves the pyramid to its working layout and fills it with the far
+  /// plane, so nothing is occluded before the first build.
+  void record_initial_transition(VkCommandBuffer command_buffer) const;
+
+  /// Records the build of every level from the depth image. The depth image
+  /// has to be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL and is left
+  /// in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL.
+  void record_build(VkCommandBuffer command_buffer, VkImage depth_image,
+                    VkImageAspectFlags depth_aspect) const;
+
+  const VkImageView get_image_view() const
+  {
+    return image_view;
+  }
+  const VkSampler get_sampler() const
+  {
+    return sampler;
+  }
+  const VkExtent2D get_extent() const
+  {
+    return extent;
+  }
+  const uint32_t get_num_levels() const
+  {
+    return num_levels;
+  }
+
+ private:
+
+  mutable VkImage image;
+  mutable VkDeviceMemory image_memory;
+  mutable VkImageView image_view;
+  mutable std::vector<VkImageView> level_views;
+  mutable VkSampler sampler;
+
+  mutable VkDescriptorSetLayout descriptor_set_layout;
+  mutable VkDescriptorPool descriptor_pool;
+  mutable std::vector<VkDescriptorSet> descriptor_sets;
+  mutable VkPipelineLayout pipeline_layout;
+  mutable VkPipeline pipeline;
+
+  VkExtent2D depth_extent;
+  VkExtent2D extent;
+  uint32_t num_levels;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+
+  void initialize(VkImageView depth_view) const;
+
+  void create_image() const;
+  void create_sampler() const;
+  void create_pipeline() const;
+  void create_descriptor_sets(VkImageView depth_view) const;
+
+  VkExtent2D get_level_extent(uint32_t level) const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_HIZ_PYRAMID_HPP_
@@ -0,0 +1,75 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "vulkan_image_view_cache.hpp"
+#include "helper.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_image_view_cache::vulkan_image_view_cache(
+    std::shared_ptr<vulkan_device> device)
+    : cache(device, vkCreateImageView, vkDestroyImageView, hash, equals,
+            "image view")
+{
+}
+
+size_t vulkan_image_view_cache::hash(const VkImageViewCreateInfo &create_info)
+{
+  size_t seed = helper::HASH_SEED;
+  helper::hash_combine(seed, create_info.flags);
+  helper::hash_combine(seed, create_info.image);
+  helper::hash_combine(seed, create_info.viewType);
+  helper::hash_combine(seed, create_info.format);
+  helper::hash_combine(seed, create_info.components.r);
+  helper::hash_combine(seed, create_info.components.g);
+  helper::hash_combine(seed, create_info.components.b);
+  helper::hash_combine(seed, create_info.components.a);
+  helper::hash_combine(seed, create_info.subresourceRange.aspectMask);
+  helper::hash_combine(seed, create_info.subresourceRange.baseMipLevel);
+  helper::hash_combine(seed, create_info.subresourceRange.levelCount);
+  helper::hash_combine(seed, create_info.subresourceRange.baseArrayLayer);
+  helper::hash_combine(seed, create_info.subresourceRange.layerCount);
+  return seed;
+}
+
+bool vulkan_image_view_cache::equals(const VkImageViewCreateInfo &a,
+                                     const VkImageViewCreateInfo &b)
+{
+  const auto &range_a = a.subresourceRange;
+  const auto &range_b = b.subresourceRange;
+  return a.flags == b.flags && a.image == b.image
+      && a.viewType == b.viewType && a.format == b.format
+      && a.components.r == b.components.r && a.components.g == b.components.g
+      && a.components.b == b.components.b && a.components.a == b.components.a
+      && range_a.aspectMask == range_b.aspectMask
+      && range_a.baseMipLevel == range_b.baseMipLevel
+      && range_a.levelCount == range_b.levelCount
+      && range_a.baseArrayLayer == range_b.baseArrayLayer
+      && range_a.layerCount == range_b.layerCount;
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
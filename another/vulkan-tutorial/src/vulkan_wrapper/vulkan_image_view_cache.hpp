@@ -0,0 +1,79 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef VULKAN_IMAGE_VIEW_CACHE_HPP_
+#define VULKAN_IMAGE_VIEW_CACHE_HPP_
+
+#include "vulkan_handle_cache.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Shares image views with equal create infos, see vulkan_handle_cache.
+/// Views of an image have to be released before the image is destroyed.
+///
+/// The pNext chain is not part of the key and must be null.
+class vulkan_image_view_cache
+{
+ public:
+  explicit vulkan_image_view_cache(std::shared_ptr<vulkan_device> device);
+  ~vulkan_image_view_cache() = default;
+  vulkan_image_view_cache(vulkan_image_view_cache &&) = delete;
+  vulkan_image_view_cache(const vulkan_image_view_cache &) = delete;
+  vulkan_image_view_cache &operator=(const vulkan_image_view_cache &) = delete;
+  vulkan_image_view_cache &operator=(vulkan_image_view_cache &&) = delete;
+
+  VkImageView acquire(const VkImageViewCreateInfo &create_info)
+  {
+    return cache.acquire(create_info);
+  }
+
+  /// Drops a reference. No submitted work may still use the view if it is
+  /// the last one, retire the call through the deletion queue.
+  void release(VkImageView image_view)
+  {
+    cache.release(image_view);
+  }
+
+  /// Number of distinct views alive.
+  const size_t get_num_image_views() const
+  {
+    return cache.get_num_handles();
+  }
+
+ private:
+
+  vulkan_handle_cache<VkImageViewCreateInfo, VkImageView> cache;
+
+  static size_t hash(const VkImageViewCreateInfo &create_info);
+  static bool equals(const VkImageViewCreateInfo &a,
+                     const VkImageViewCreateInfo &b);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_IMAGE_VIEW_CACHE_HPP_
@@ -0,0 +1,156 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_indirect_draws.hpp"
+#include "helper.hpp"
+
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_indirect_draws::vulkan_indirect_draws(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    uint32_t max_draws, uint32_t num_lists)
+    : buffers(std::vector<VkBuffer> {}),
+      buffers_memory(std::vector<VkDeviceMemory> {}),
+      mapped(std::vector<uint8_t*> {}),
+      draw_counts(num_lists, 0),
+      current_list(0),
+      current_count(0),
+      max_draws(max_draws),
+      commands_offset(16),
+      draw_indirect_count(
+          device->get_enabled_vulkan12_features().drawIndirectCount),
+      multi_draw_indirect(device->get_enabled_features().multiDrawIndirect),
+      device(device),
+      physical_device(physical_device)
+{
+  initialize(num_lists);
+}
+
+vulkan_indirect_draws::~vulkan_indirect_draws()
+{
+  for (size_t i = 0; i < buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), buffers_memory[i], nullptr);
+  }
+}
+
+void vulkan_indirect_draws::begin(uint32_t index)
+{
+  current_list = index;
+  current_count = 0;
+}
+
+bool vulkan_indirect_draws::add(const VkDrawIndexedIndirectCommand &command)
+{
+  if (current_count >= max_draws)
+  {
+    return false;
+  }
+
+  get_commands(current_list)[current_count++] = command;
+  return true;
+}
+
+void vulkan_indirect_draws::end()
+{
+  if (!draw_indirect_count && current_count < draw_counts[current_list])
+  {
+    // every slot is drawn, so the ones left over from last time must be empty
+    std::memset(get_commands(current_list) + current_count, 0,
+                (draw_counts[current_list] - current_count)
+                    * sizeof(VkDrawIndexedIndirectCommand));
+  }
+
+  std::memcpy(mapped[current_list], &current_count, sizeof(current_count));
+  draw_counts[current_list] = current_count;
+}
+
+void vulkan_indirect_draws::record(VkCommandBuffer command_buffer,
+                                   uint32_t index) const
+{
+  const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+  if (draw_indirect_count)
+  {
+    vkCmdDrawIndexedIndirectCount(command_buffer, buffers[index],
+                                  commands_offset, buffers[index], 0,
+                                  max_draws, stride);
+  } else if (multi_draw_indirect)
+  {
+    vkCmdDrawIndexedIndirect(command_buffer, buffers[index], commands_offset,
+                             max_draws, stride);
+  } else
+  {
+    // without multiDrawIndirect the draw count must be 0 or 1
+    for (uint32_t i = 0; i < max_draws; i++)
+    {
+      vkCmdDrawIndexedIndirect(command_buffer, buffers[index],
+                               commands_offset + i * stride, 1, stride);
+    }
+  }
+}
+
+void vulkan_indirect_draws::initialize(uint32_t num_lists) const
+{
+  auto size = commands_offset
+      + max_draws * sizeof(VkDrawIndexedIndirectCommand);
+
+  buffers.resize(num_lists);
+  buffers_memory.resize(num_lists);
+  mapped.resize(num_lists);
+
+  for (uint32_t i = 0; i < num_lists; i++)
+  {
+    helper::create_buffer(
+        size,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffers[i], buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    void* data;
+    vkMapMemory(device->get_device(), buffers_memory[i], 0, size, 0, &data);
+    std::memset(data, 0, size);
+    mapped[i] = static_cast<uint8_t*>(data);
+  }
+}
+
+VkDrawIndexedIndirectCommand *vulkan_indirect_draws::get_commands(
+    uint32_t index) const
+{
+  return reinterpret_cast<VkDrawIndexedIndirectCommand*>(mapped[index]
+      + commands_offset);
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
@@ -0,0 +1,114 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_INDIRECT_DRAWS_HPP_
+#define VULKAN_INDIRECT_DRAWS_HPP_
+
+#include "vulkan_device.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Lists of indexed draws in persistently mapped buffers, one list per
+/// swap chain image. The command buffers record a single indirect draw per
+/// list once, and the CPU (or a compute pass) rewrites the list every frame.
+///
+/// Each buffer holds the draw count at offset 0 followed by the commands at
+/// get_commands_offset(). With drawIndirectCount the GPU reads the count,
+/// otherwise every slot is drawn and unused ones have instanceCount = 0.
+class vulkan_indirect_draws
+{
+ public:
+  vulkan_indirect_draws(std::shared_ptr<vulkan_device> device,
+                        std::shared_ptr<vulkan_physical_device> physical_device,
+                        uint32_t max_draws, uint32_t num_lists);
+  ~vulkan_indirect_draws();
+  vulkan_indirect_draws(vulkan_indirect_draws &&) = delete;
+  vulkan_indirect_draws(const vulkan_indirect_draws &) = delete;
+  vulkan_indirect_draws &operator=(const vulkan_indirect_draws &) = delete;
+  vulkan_indirect_draws &operator=(vulkan_indirect_draws &&) = delete;
+
+  /// Starts rewriting list index. The GPU must be done with it.
+  void begin(uint32_t index);
+
+  /// Appends a draw to the list being written. Returns false if it is full.
+  bool add(const VkDrawIndexedIndirectCommand &command);
+
+  /// Publishes the draws added since begin().
+  void end();
+
+  /// Records the draws of list index into command_buffer.
+  void record(VkCommandBuffer command_buffer, uint32_t index) const;
+
+  const VkBuffer get_buffer(uint32_t index) const
+  {
+    return buffers[index];
+  }
+  const VkDeviceSize get_commands_offset() const
+  {
+    return commands_offset;
+  }
+  const uint32_t get_max_draws() const
+  {
+    return max_draws;
+  }
+  const uint32_t get_num_lists() const
+  {
+    return static_cast<uint32_t>(buffers.size());
+  }
+  const bool has_draw_count() const
+  {
+    return draw_indirect_count;
+  }
+
+ private:
+
+  mutable std::vector<VkBuffer> buffers;
+  mutable std::vector<VkDeviceMemory> buffers_memory;
+  mutable std::vector<uint8_t*> mapped;
+
+  // draws published per list, used to clear stale slots without a draw count
+  std::vector<uint32_t> draw_counts;
+
+  uint32_t current_list;
+  uint32_t current_count;
+
+  uint32_t max_draws;
+  VkDeviceSize commands_offset;
+  bool draw_indirect_count;
+  bool multi_draw_indirect;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+
+  void initialize(uint32_t num_lists) const;
+
+  VkDrawIndexedIndirectCommand *get_commands(uint32_t index) const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_INDIRECT_DRAWS_HPP_
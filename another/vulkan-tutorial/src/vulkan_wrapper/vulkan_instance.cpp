@@ -63,7 +63,7 @@ void vulkan_instance::initialize() const
   application_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   application_info.pEngineName = "No Engine";
   application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  application_info.apiVersion = VK_API_VERSION_1_1;
+  application_info.apiVersion = VK_API_VERSION_1_2;
 
   auto extensions = get_required_extensions();
 
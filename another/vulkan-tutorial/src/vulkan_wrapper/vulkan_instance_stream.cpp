@@ -0,0 +1,135 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_instance_stream.hpp"
+#include "helper.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_instance_stream::vulkan_instance_stream(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    uint32_t max_instances, uint32_t num_streams)
+    : buffers(std::vector<VkBuffer> {}),
+      buffers_memory(std::vector<VkDeviceMemory> {}),
+      mapped(std::vector<instance_transform*> {}),
+      max_instances(max_instances),
+      device(device),
+      physical_device(physical_device)
+{
+  initialize(num_streams);
+}
+
+vulkan_instance_stream::~vulkan_instance_stream()
+{
+  for (size_t i = 0; i < buffers.size(); i++)
+  {
+    vkUnmapMemory(device->get_device(), buffers_memory[i]);
+    vkDestroyBuffer(device->get_device(), buffers[i], nullptr);
+    vkFreeMemory(device->get_device(), buffers_memory[i], nullptr);
+  }
+}
+
+void vulkan_instance_stream::write(uint32_t index, uint32_t first,
+                                   const instance_transform *transforms,
+                                   uint32_t count)
+{
+  if (first + count > max_instances)
+  {
+    throw std::runtime_error("too many instances for the instance stream!");
+  }
+
+  std::memcpy(mapped[index] + first, transforms,
+              count * sizeof(instance_transform));
+}
+
+void vulkan_instance_stream::bind(VkCommandBuffer command_buffer,
+                                  uint32_t binding, uint32_t index) const
+{
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(command_buffer, binding, 1, &buffers[index], &offset);
+}
+
+VkVertexInputBindingDescription vulkan_instance_stream::get_binding_description(
+    uint32_t binding)
+{
+  VkVertexInputBindingDescription binding_description = {};
+  binding_description.binding = binding;
+  binding_description.stride = sizeof(instance_transform);
+  binding_description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+  return binding_description;
+}
+
+std::array<VkVertexInputAttributeDescription, 5> vulkan_instance_stream::get_attribute_descriptions(
+    uint32_t binding, uint32_t first_location)
+{
+  std::array<VkVertexInputAttributeDescription, 5> attribute_descriptions = {};
+
+  for (uint32_t column = 0; column < 4; column++)
+  {
+    attribute_descriptions[column].binding = binding;
+    attribute_descriptions[column].location = first_location + column;
+    attribute_descriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attribute_descriptions[column].offset = column * 4 * sizeof(float);
+  }
+
+  attribute_descriptions[4].binding = binding;
+  attribute_descriptions[4].location = first_location + 4;
+  attribute_descriptions[4].format = VK_FORMAT_R32_UINT;
+  attribute_descriptions[4].offset = offsetof(instance_transform, material);
+
+  return attribute_descriptions;
+}
+
+void vulkan_instance_stream::initialize(uint32_t num_streams) const
+{
+  VkDeviceSize size = max_instances * sizeof(instance_transform);
+
+  buffers.resize(num_streams);
+  buffers_memory.resize(num_streams);
+  mapped.resize(num_streams);
+
+  for (uint32_t i = 0; i < num_streams; i++)
+  {
+    helper::create_buffer(
+        size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffers[i], buffers_memory[i], device->get_device(),
+        physical_device->get_physical_device());
+
+    // kept mapped for the lifetime of the buffer
+    void* data;
+    vkMapMemory(device->get_device(), buffers_memory[i], 0, size, 0, &data);
+    mapped[i] = static_cast<instance_transform*>(data);
+  }
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
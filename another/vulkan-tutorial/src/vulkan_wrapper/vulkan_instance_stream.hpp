@@ -0,0 +1,112 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_INSTANCE_STREAM_HPP_
+#define VULKAN_INSTANCE_STREAM_HPP_
+
+#include "vulkan_device.hpp"
+
+#include <array>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// Per instance vertex data, a column major model matrix and the index of
+/// the instance's material. Read in the vertex shader as a mat4 over four
+/// consecutive locations and a uint at the location after them.
+struct instance_transform
+{
+  float model[16];
+  uint32_t material;
+  uint32_t padding[3];
+};
+
+///
+/// Per instance vertex streams in persistently mapped buffers, one stream per
+/// swap chain image. The streams are bound at a binding with
+/// VK_VERTEX_INPUT_RATE_INSTANCE, so N copies of a mesh are drawn with a
+/// single draw of instanceCount = N, instance i reading transform
+/// firstInstance + i.
+class vulkan_instance_stream
+{
+ public:
+  vulkan_instance_stream(
+      std::shared_ptr<vulkan_device> device,
+      std::shared_ptr<vulkan_physical_device> physical_device,
+      uint32_t max_instances, uint32_t num_streams);
+  ~vulkan_instance_stream();
+  vulkan_instance_stream(vulkan_instance_stream &&) = delete;
+  vulkan_instance_stream(const vulkan_instance_stream &) = delete;
+  vulkan_instance_stream &operator=(const vulkan_instance_stream &) = delete;
+  vulkan_instance_stream &operator=(vulkan_instance_stream &&) = delete;
+
+  /// Copies count transforms to stream index, starting at instance first.
+  /// The GPU must be done with the stream.
+  void write(uint32_t index, uint32_t first,
+             const instance_transform *transforms, uint32_t count);
+
+  /// Binds stream index to binding of command_buffer.
+  void bind(VkCommandBuffer command_buffer, uint32_t binding,
+            uint32_t index) const;
+
+  /// Vertex input of the stream when bound to binding.
+  static VkVertexInputBindingDescription get_binding_description(
+      uint32_t binding);
+
+  /// The four columns of the transform, at first_location and up, and the
+  /// material at first_location + 4.
+  static std::array<VkVertexInputAttributeDescription, 5> get_attribute_descriptions(
+      uint32_t binding, uint32_t first_location);
+
+  const VkBuffer get_buffer(uint32_t index) const
+  {
+    return buffers[index];
+  }
+  const uint32_t get_max_instances() const
+  {
+    return max_instances;
+  }
+  const uint32_t get_num_streams() const
+  {
+    return static_cast<uint32_t>(buffers.size());
+  }
+
+ private:
+
+  mutable std::vector<VkBuffer> buffers;
+  mutable std::vector<VkDeviceMemory> buffers_memory;
+  mutable std::vector<instance_transform*> mapped;
+
+  uint32_t max_instances;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+
+  void initialize(uint32_t num_streams) const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_INSTANCE_STREAM_HPP_
@@ -33,6 +33,10 @@ vulkan_physical_device::vulkan_physical_device(
     std::shared_ptr<vulkan_instance> instance,
     std::shared_ptr<vulkan_surface> surface)
     : physical_device(VK_NULL_HANDLE),
+      properties(),
+      features(),
+      vulkan12_features(),
+      descriptor_indexing_properties(),
       instance(instance),
       surface(surface)
 {
@@ -66,6 +70,28 @@ void vulkan_physical_device::initialize() const
   {
     throw std::runtime_error("failed to find a suitable GPU!");
   }
+
+  vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+  VkPhysicalDeviceFeatures2 features2 = {};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = &vulkan12_features;
+  vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+  features = features2.features;
+  vulkan12_features.pNext = nullptr;
+
+  descriptor_indexing_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+  VkPhysicalDeviceProperties2 properties2 = {};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &descriptor_indexing_properties;
+  vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+
+  properties = properties2.properties;
+  descriptor_indexing_properties.pNext = nullptr;
 }
 
 bool vulkan_physical_device::is_device_suitable(VkPhysicalDevice device) const
@@ -86,10 +112,31 @@ bool vulkan_physical_device::is_device_suitable(VkPhysicalDevice device) const
   VkPhysicalDeviceFeatures supported_features;
   vkGetPhysicalDeviceFeatures(device, &supported_features);
 
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device, &properties);
+
+  // frame synchronization is built on timeline semaphores, core in 1.2
+  auto timeline_supported = false;
+  if (properties.apiVersion >= VK_API_VERSION_1_2)
+  {
+    VkPhysicalDeviceVulkan12Features supported_vulkan12_features = {};
+    supported_vulkan12_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &supported_vulkan12_features;
+    vkGetPhysicalDeviceFeatures2(device, &features2);
+
+    timeline_supported = supported_vulkan12_features.timelineSemaphore;
+  }
+
   physical_device = VK_NULL_HANDLE;
 
   return indices.is_complete() && extensions_supported && swap_chain_adequate
-      && supported_features.samplerAnisotropy;
+      && supported_features.samplerAnisotropy
+      && supported_features.drawIndirectFirstInstance
+      && supported_features.fragmentStoresAndAtomics && timeline_supported;
 }
 
 const queue_family_indices vulkan_physical_device::find_queue_families() const
@@ -77,9 +77,36 @@ class vulkan_physical_device
     return physical_device;
   }
 
+  /// Properties and limits of the selected device.
+  const VkPhysicalDeviceProperties get_properties() const
+  {
+    return properties;
+  }
+
+  const VkPhysicalDeviceFeatures get_features() const
+  {
+    return features;
+  }
+
+  /// Vulkan 1.2 features supported by the selected device. pNext is cleared.
+  const VkPhysicalDeviceVulkan12Features get_vulkan12_features() const
+  {
+    return vulkan12_features;
+  }
+
+  /// Limits of update-after-bind descriptors. pNext is cleared.
+  const VkPhysicalDeviceDescriptorIndexingProperties get_descriptor_indexing_properties() const
+  {
+    return descriptor_indexing_properties;
+  }
+
  private:
 
   mutable VkPhysicalDevice physical_device;
+  mutable VkPhysicalDeviceProperties properties;
+  mutable VkPhysicalDeviceFeatures features;
+  mutable VkPhysicalDeviceVulkan12Features vulkan12_features;
+  mutable VkPhysicalDeviceDescriptorIndexingProperties descriptor_indexing_properties;
 
   std::shared_ptr<vulkan_instance> instance;
   std::shared_ptr<vulkan_surface> surface;
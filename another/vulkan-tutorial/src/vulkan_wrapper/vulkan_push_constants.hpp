@@ -0,0 +1,91 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef VULKAN_PUSH_CONSTANTS_HPP_
+#define VULKAN_PUSH_CONSTANTS_HPP_
+
+#include "vulkan_physical_device.hpp"
+
+#include <stdexcept>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+/// Every implementation supports at least this many bytes of push constants.
+const uint32_t MIN_PUSH_CONSTANTS_SIZE = 128;
+
+///
+/// A push constant block of type T at a fixed offset, for small per-draw
+/// data (matrices, ids) that should not go through a mapped buffer and a
+/// descriptor bind.
+///
+/// The size is checked against the guaranteed minimum at compile time and
+/// against the device's maxPushConstantsSize when the range is created.
+/// T must match the std430 layout of the block in the shader.
+template<typename T, uint32_t OFFSET = 0>
+class vulkan_push_constants
+{
+  static_assert(sizeof(T) % 4 == 0,
+                "push constant blocks must be a multiple of 4 bytes");
+  static_assert(OFFSET % 4 == 0,
+                "push constant offsets must be a multiple of 4 bytes");
+  static_assert(OFFSET + sizeof(T) <= MIN_PUSH_CONSTANTS_SIZE,
+                "push constant block does not fit the guaranteed 128 bytes");
+
+ public:
+  /// The range to put in the pipeline layout.
+  static VkPushConstantRange get_range(
+      VkShaderStageFlags stages,
+      std::shared_ptr<vulkan_physical_device> physical_device)
+  {
+    auto max_size = physical_device->get_properties().limits
+        .maxPushConstantsSize;
+    if (OFFSET + sizeof(T) > max_size)
+    {
+      throw std::runtime_error(
+          "push constant block exceeds maxPushConstantsSize!");
+    }
+
+    VkPushConstantRange range = {};
+    range.stageFlags = stages;
+    range.offset = OFFSET;
+    range.size = static_cast<uint32_t>(sizeof(T));
+    return range;
+  }
+
+  /// Records the block into command_buffer for the following draws. stages
+  /// must be the ones the range was created with.
+  static void push(VkCommandBuffer command_buffer, VkPipelineLayout layout,
+                   VkShaderStageFlags stages, const T &data)
+  {
+    vkCmdPushConstants(command_buffer, layout, stages, OFFSET,
+                       static_cast<uint32_t>(sizeof(T)), &data);
+  }
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_PUSH_CONSTANTS_HPP_
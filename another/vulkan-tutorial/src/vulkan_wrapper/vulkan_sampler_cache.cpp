@@ -0,0 +1,79 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#include "vulkan_sampler_cache.hpp"
+#include "helper.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_sampler_cache::vulkan_sampler_cache(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device)
+    : cache(device, vkCreateSampler, vkDestroySampler, hash, equals,
+            "sampler",
+            physical_device->get_properties().limits.maxSamplerAllocationCount)
+{
+}
+
+size_t vulkan_sampler_cache::hash(const VkSamplerCreateInfo &create_info)
+{
+  size_t seed = helper::HASH_SEED;
+  helper::hash_combine(seed, create_info.flags);
+  helper::hash_combine(seed, create_info.magFilter);
+  helper::hash_combine(seed, create_info.minFilter);
+  helper::hash_combine(seed, create_info.mipmapMode);
+  helper::hash_combine(seed, create_info.addressModeU);
+  helper::hash_combine(seed, create_info.addressModeV);
+  helper::hash_combine(seed, create_info.addressModeW);
+  helper::hash_combine(seed, create_info.mipLodBias);
+  helper::hash_combine(seed, create_info.anisotropyEnable);
+  helper::hash_combine(seed, create_info.maxAnisotropy);
+  helper::hash_combine(seed, create_info.compareEnable);
+  helper::hash_combine(seed, create_info.compareOp);
+  helper::hash_combine(seed, create_info.minLod);
+  helper::hash_combine(seed, create_info.maxLod);
+  helper::hash_combine(seed, create_info.borderColor);
+  helper::hash_combine(seed, create_info.unnormalizedCoordinates);
+  return seed;
+}
+
+bool vulkan_sampler_cache::equals(const VkSamplerCreateInfo &a,
+                                  const VkSamplerCreateInfo &b)
+{
+  return a.flags == b.flags && a.magFilter == b.magFilter
+      && a.minFilter == b.minFilter && a.mipmapMode == b.mipmapMode
+      && a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV
+      && a.addressModeW == b.addressModeW && a.mipLodBias == b.mipLodBias
+      && a.anisotropyEnable == b.anisotropyEnable
+      && a.maxAnisotropy == b.maxAnisotropy
+      && a.compareEnable == b.compareEnable && a.compareOp == b.compareOp
+      && a.minLod == b.minLod && a.maxLod == b.maxLod
+      && a.borderColor == b.borderColor
+      && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
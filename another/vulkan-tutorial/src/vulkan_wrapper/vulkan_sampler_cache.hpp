@@ -0,0 +1,81 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+
+#ifndef VULKAN_SAMPLER_CACHE_HPP_
+#define VULKAN_SAMPLER_CACHE_HPP_
+
+#include "vulkan_handle_cache.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Shares samplers between users with the same filtering state, see
+/// vulkan_handle_cache. Distinct samplers are a limited resource on some
+/// devices, acquire() throws beyond maxSamplerAllocationCount.
+///
+/// The pNext chain is not part of the key and must be null.
+class vulkan_sampler_cache
+{
+ public:
+  vulkan_sampler_cache(std::shared_ptr<vulkan_device> device,
+                       std::shared_ptr<vulkan_physical_device> physical_device);
+  ~vulkan_sampler_cache() = default;
+  vulkan_sampler_cache(vulkan_sampler_cache &&) = delete;
+  vulkan_sampler_cache(const vulkan_sampler_cache &) = delete;
+  vulkan_sampler_cache &operator=(const vulkan_sampler_cache &) = delete;
+  vulkan_sampler_cache &operator=(vulkan_sampler_cache &&) = delete;
+
+  VkSampler acquire(const VkSamplerCreateInfo &create_info)
+  {
+    return cache.acquire(create_info);
+  }
+
+  /// Drops a reference. No submitted work may still use the sampler if it
+  /// is the last one, retire the call through the deletion queue.
+  void release(VkSampler sampler)
+  {
+    cache.release(sampler);
+  }
+
+  /// Number of distinct samplers alive.
+  const size_t get_num_samplers() const
+  {
+    return cache.get_num_handles();
+  }
+
+ private:
+
+  vulkan_handle_cache<VkSamplerCreateInfo, VkSampler> cache;
+
+  static size_t hash(const VkSamplerCreateInfo &create_info);
+  static bool equals(const VkSamplerCreateInfo &a,
+                     const VkSamplerCreateInfo &b);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_SAMPLER_CACHE_HPP_
@@ -31,8 +31,11 @@ vulkan_swap_chain::vulkan_swap_chain(
     std::shared_ptr<window_handler> window,
     std::shared_ptr<vulkan_device> device,
     std::shared_ptr<vulkan_physical_device> physical_device,
-    std::shared_ptr<vulkan_surface> surface)
-    : window(window),
+    std::shared_ptr<vulkan_surface> surface,
+    std::shared_ptr<vulkan_swap_chain> old_swap_chain)
+    : swap_chain(VK_NULL_HANDLE),
+      old_swap_chain(old_swap_chain ? old_swap_chain->get_swap_chain() : VK_NULL_HANDLE),
+      window(window),
       device(device),
       physical_device(physical_device),
       surface(surface)
@@ -97,6 +100,7 @@ void vulkan_swap_chain::initialize()
   create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   create_info.presentMode = present_mode;
   create_info.clipped = VK_TRUE;
+  create_info.oldSwapchain = old_swap_chain;
 
   if (vkCreateSwapchainKHR(device->get_device(), &create_info, nullptr, &swap_chain)
       != VK_SUCCESS)
@@ -41,7 +41,8 @@ class vulkan_swap_chain
   vulkan_swap_chain(std::shared_ptr<window_handler> window,
                     std::shared_ptr<vulkan_device> device,
                     std::shared_ptr<vulkan_physical_device> physical_device,
-                    std::shared_ptr<vulkan_surface> surface);
+                    std::shared_ptr<vulkan_surface> surface,
+                    std::shared_ptr<vulkan_swap_chain> old_swap_chain = nullptr);
   ~vulkan_swap_chain();
   vulkan_swap_chain(vulkan_swap_chain &&) = delete;
   vulkan_swap_chain(const vulkan_swap_chain &) = delete;
@@ -75,6 +76,8 @@ class vulkan_swap_chain
  private:
 
   VkSwapchainKHR swap_chain;
+  // the swap chain being replaced, if any. It is retired by the caller.
+  VkSwapchainKHR old_swap_chain;
   VkExtent2D extent;
   VkFormat image_format;
   std::vector<VkImage> images;
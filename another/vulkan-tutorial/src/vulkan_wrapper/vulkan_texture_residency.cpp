@@ -0,0 +1,728 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_texture_residency.hpp"
+#include "helper.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+namespace
+{
+
+uint32_t floor_log2(uint32_t value)
+{
+  uint32_t result = 0;
+  while (value >>= 1)
+  {
+    result++;
+  }
+  return result;
+}
+
+}  // namespace
+
+vulkan_texture_residency::vulkan_texture_residency(
+    std::shared_ptr<vulkan_device> device,
+    std::shared_ptr<vulkan_physical_device> physical_device,
+    std::shared_ptr<vulkan_timeline> timeline,
+    std::shared_ptr<vulkan_deletion_queue> deletion_queue,
+    std::shared_ptr<vulkan_image_view_cache> image_view_cache,
+    std::shared_ptr<util::async_reader> reader, VkDeviceSize budget,
+    uint32_t max_textures, uint32_t num_feedback_slots,
+    VkDeviceSize max_upload_size)
+    : feedback_buffer(VK_NULL_HANDLE),
+      feedback_buffer_memory(VK_NULL_HANDLE),
+      feedback_data(nullptr),
+      feedback_stride(0),
+      command_pool(VK_NULL_HANDLE),
+      textures(std::vector<texture> {}),
+      uploads(std::vector<upload> {}),
+      update_count(1),
+      used_size(0),
+      budget(budget),
+      max_textures(max_textures),
+      num_feedback_slots(num_feedback_slots),
+      max_upload_size(max_upload_size),
+      device(device),
+      physical_device(physical_device),
+      timeline(timeline),
+      deletion_queue(deletion_queue),
+      image_view_cache(image_view_cache),
+      reader(reader)
+{
+  initialize();
+}
+
+vulkan_texture_residency::~vulkan_texture_residency()
+{
+  // reads still in flight write to the staging memory
+  if (reader && !uploads.empty())
+  {
+    reader->wait_idle();
+  }
+  for (const auto &pending : uploads)
+  {
+    destroy_staging(pending);
+  }
+
+  for (auto &item : textures)
+  {
+    if (item.used)
+    {
+      image_view_cache->release(item.image_view);
+      vkDestroyImage(device->get_device(), item.image, nullptr);
+      vkFreeMemory(device->get_device(), item.image_memory, nullptr);
+    }
+  }
+
+  vkDestroyCommandPool(device->get_device(), command_pool, nullptr);
+  vkUnmapMemory(device->get_device(), feedback_buffer_memory);
+  vkDestroyBuffer(device->get_device(), feedback_buffer, nullptr);
+  vkFreeMemory(device->get_device(), feedback_buffer_memory, nullptr);
+}
+
+uint32_t vulkan_texture_residency::add(VkFormat format,
+                                       std::vector<util::mip_level> levels,
+                                       const std::vector<uint8_t> &tail_data,
+                                       texture_source source)
+{
+  if (levels.empty())
+  {
+    throw std::runtime_error("streamed textures need a level!");
+  }
+
+  uint32_t id = 0;
+  while (id < textures.size() && textures[id].used)
+  {
+    id++;
+  }
+  if (id == max_textures)
+  {
+    throw std::runtime_error("too many streamed textures!");
+  }
+  if (id == textures.size())
+  {
+    textures.push_back(texture {});
+  }
+
+  auto &item = textures[id];
+  item.format = format;
+  item.levels = std::move(levels);
+  item.source = std::move(source);
+  item.image = VK_NULL_HANDLE;
+  item.image_memory = VK_NULL_HANDLE;
+  item.image_view = VK_NULL_HANDLE;
+  item.uploading = false;
+  item.used = true;
+
+  item.tail_level = util::mip_chain::get_tail_level(item.levels,
+                                                    RESIDENT_TAIL_SIZE);
+  item.size = item.levels[item.tail_level].offset + tail_data.size();
+  item.resident_level = static_cast<uint32_t>(item.levels.size());
+  item.wanted_level = item.tail_level;
+  item.wanted_update = 0;
+
+  // without a source the texture never gets finer than its tail
+  bool streamable = item.source.offsets.size() >= item.tail_level
+      && (item.source.mapping
+          || (reader && !item.source.file_name.empty()));
+  item.finest_level = streamable ? 0 : item.tail_level;
+
+  make_resident(id, item.tail_level, tail_data.data());
+  return id;
+}
+
+void vulkan_texture_residency::remove(uint32_t id)
+{
+  auto &item = textures[id];
+  if (item.uploading)
+  {
+    // the reads may still write to its staging memory
+    for (auto &pending : uploads)
+    {
+      if (pending.id == id)
+      {
+        pending.cancelled = true;
+      }
+    }
+  }
+
+  if (item.image != VK_NULL_HANDLE)
+  {
+    // submissions up to the last one may still sample it
+    retire_image(item.image, item.image_memory, item.image_view,
+                 timeline->get_last_value());
+    used_size -= get_chain_size(item, item.resident_level);
+  }
+
+  item.image = VK_NULL_HANDLE;
+  item.image_memory = VK_NULL_HANDLE;
+  item.image_view = VK_NULL_HANDLE;
+  item.levels.clear();
+  item.source = texture_source {};
+  item.uploading = false;
+  item.used = false;
+}
+
+void vulkan_texture_residency::record_feedback_barrier(
+    VkCommandBuffer command_buffer) const
+{
+  // waiting for the timeline alone does not make shader writes available
+  // to the host
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = feedback_buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier,
+                       0, nullptr);
+}
+
+void vulkan_texture_residency::read_feedback(uint32_t slot)
+{
+  auto resolutions = reinterpret_cast<uint32_t*>(feedback_data
+      + get_feedback_offset(slot));
+
+  for (uint32_t id = 0; id < textures.size(); id++)
+  {
+    auto &item = textures[id];
+    if (!item.used || resolutions[id] == 0)
+    {
+      continue;
+    }
+
+    // the level with at least the sampled resolution across
+    auto size = std::max(item.levels[0].width, item.levels[0].height);
+    auto resolution = resolutions[id] - 1;
+    auto top = floor_log2(size);
+    uint32_t level = top > resolution ? top - resolution : 0;
+    level = std::max(std::min(level, item.tail_level), item.finest_level);
+
+    // finer requests win at once, coarser ones after the delay
+    if (level <= item.wanted_level
+        || update_count - item.wanted_update > EVICT_DELAY)
+    {
+      item.wanted_level = level;
+      item.wanted_update = update_count;
+    }
+  }
+
+  std::memset(resolutions, 0, static_cast<size_t>(get_feedback_range()));
+}
+
+bool vulkan_texture_residency::update()
+{
+  bool changed = false;
+
+  // uploads whose reads have completed replace their images
+  for (auto pending = uploads.begin(); pending != uploads.end();)
+  {
+    if (pending->reads->remaining > 0)
+    {
+      ++pending;
+      continue;
+    }
+
+    if (pending->cancelled)
+    {
+      destroy_staging(*pending);
+    } else if (pending->reads->failed)
+    {
+      // the source went away, the texture stays as fine as it is
+      auto &item = textures[pending->id];
+      item.finest_level = item.resident_level;
+      item.wanted_level = item.resident_level;
+      item.uploading = false;
+      destroy_staging(*pending);
+    } else
+    {
+      finish_upload(*pending);
+      changed = true;
+    }
+    pending = uploads.erase(pending);
+  }
+
+  // levels nobody sampled for a while go back to the tail
+  std::vector<uint32_t> targets(textures.size());
+  VkDeviceSize total = 0;
+  for (uint32_t id = 0; id < textures.size(); id++)
+  {
+    auto &item = textures[id];
+    if (!item.used)
+    {
+      continue;
+    }
+    if (update_count - item.wanted_update > EVICT_DELAY)
+    {
+      item.wanted_level = item.tail_level;
+    }
+    targets[id] = item.uploading ? item.pending_level : item.wanted_level;
+    total += get_chain_size(item, targets[id]);
+  }
+
+  // over the budget, the largest wanted level is dropped until it fits
+  while (total > budget)
+  {
+    auto largest = INVALID_TEXTURE;
+    VkDeviceSize largest_size = 0;
+    for (uint32_t id = 0; id < textures.size(); id++)
+    {
+      const auto &item = textures[id];
+      if (!item.used || item.uploading || targets[id] >= item.tail_level)
+      {
+        continue;
+      }
+      auto size = get_chain_size(item, targets[id])
+          - get_chain_size(item, targets[id] + 1);
+      if (size > largest_size)
+      {
+        largest = id;
+        largest_size = size;
+      }
+    }
+    if (largest == INVALID_TEXTURE)
+    {
+      break;
+    }
+    targets[largest]++;
+    total -= largest_size;
+  }
+
+  // shrinking first, so the budget holds before anything grows
+  std::vector<uint32_t> changes;
+  for (uint32_t id = 0; id < textures.size(); id++)
+  {
+    const auto &item = textures[id];
+    if (item.used && !item.uploading && targets[id] != item.resident_level)
+    {
+      changes.push_back(id);
+    }
+  }
+  std::stable_sort(changes.begin(), changes.end(),
+                   [&](uint32_t a, uint32_t b)
+                   {
+                     return targets[a] > textures[a].resident_level
+                         && targets[b] < textures[b].resident_level;
+                   });
+
+  VkDeviceSize upload_size = 0;
+  bool started = false;
+  for (auto id : changes)
+  {
+    auto size = get_chain_size(textures[id], targets[id]);
+    if (started && upload_size + size > max_upload_size)
+    {
+      break;
+    }
+    make_resident(id, targets[id], nullptr);
+    changed = changed || !textures[id].uploading;
+    upload_size += size;
+    started = true;
+  }
+
+  update_count++;
+  return changed;
+}
+
+void vulkan_texture_residency::initialize() const
+{
+  create_feedback_buffer();
+  create_command_pool();
+}
+
+void vulkan_texture_residency::create_feedback_buffer() const
+{
+  // regions are bound at their offset, aligned to the device limit
+  auto alignment = physical_device->get_properties().limits
+      .minStorageBufferOffsetAlignment;
+  feedback_stride = get_feedback_range();
+  if (alignment > 0)
+  {
+    feedback_stride = (feedback_stride + alignment - 1) / alignment
+        * alignment;
+  }
+
+  VkDeviceSize size = feedback_stride * num_feedback_slots;
+  helper::create_buffer(
+      size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      feedback_buffer, feedback_buffer_memory, device->get_device(),
+      physical_device->get_physical_device());
+
+  vkMapMemory(device->get_device(), feedback_buffer_memory, 0, VK_WHOLE_SIZE,
+              0, reinterpret_cast<void**>(&feedback_data));
+  std::memset(feedback_data, 0, static_cast<size_t>(size));
+}
+
+void vulkan_texture_residency::create_command_pool() const
+{
+  VkCommandPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pool_info.queueFamilyIndex =
+      physical_device->find_queue_families().graphics_family;
+
+  if (vkCreateCommandPool(device->get_device(), &pool_info, nullptr,
+                          &command_pool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create texture command pool!");
+  }
+}
+
+VkDeviceSize vulkan_texture_residency::get_chain_size(const texture &item,
+                                                      uint32_t level) const
+{
+  // the levels are packed in order, so the chain is one range
+  if (level >= item.levels.size())
+  {
+    return 0;
+  }
+  return item.size - item.levels[level].offset;
+}
+
+void vulkan_texture_residency::make_resident(uint32_t id, uint32_t level,
+                                             const uint8_t *tail_data)
+{
+  auto &item = textures[id];
+  auto vk_device = device->get_device();
+
+  upload pending = {};
+  pending.id = id;
+  pending.level = level;
+  pending.staging_buffer = VK_NULL_HANDLE;
+  pending.staging_buffer_memory = VK_NULL_HANDLE;
+  pending.cancelled = false;
+
+  // levels that stay resident are copied on the GPU, only finer ones are
+  // staged
+  auto staged_end = std::min(item.resident_level,
+                             static_cast<uint32_t>(item.levels.size()));
+  if (level >= staged_end)
+  {
+    finish_upload(pending);
+    return;
+  }
+
+  auto staged_offset = item.levels[level].offset;
+  auto staged_size = get_chain_size(item, level)
+      - get_chain_size(item, staged_end);
+  helper::create_buffer(
+      staged_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      pending.staging_buffer, pending.staging_buffer_memory, vk_device,
+      physical_device->get_physical_device());
+
+  uint8_t *staging;
+  vkMapMemory(vk_device, pending.staging_buffer_memory, 0, staged_size, 0,
+              reinterpret_cast<void**>(&staging));
+
+  std::vector<util::read_request> reads;
+  for (uint32_t i = level; i < staged_end; i++)
+  {
+    auto destination = staging + item.levels[i].offset - staged_offset;
+    auto size = static_cast<size_t>(get_chain_size(item, i)
+        - get_chain_size(item, i + 1));
+
+    if (i >= item.tail_level)
+    {
+      std::memcpy(destination, tail_data + item.levels[i].offset
+          - item.levels[item.tail_level].offset, size);
+    } else if (item.source.mapping)
+    {
+      std::memcpy(destination,
+                  item.source.mapping + item.source.offsets[i], size);
+    } else
+    {
+      util::read_request read;
+      read.file_name = item.source.file_name;
+      read.offset = item.source.offsets[i];
+      read.size = size;
+      read.destination = destination;
+      reads.push_back(std::move(read));
+    }
+  }
+
+  if (reads.empty())
+  {
+    finish_upload(pending);
+    return;
+  }
+
+  // the image is replaced by the update that finds the reads completed
+  pending.reads = std::make_shared<read_state>();
+  pending.reads->remaining = static_cast<uint32_t>(reads.size());
+  pending.reads->failed = false;
+  for (auto &read : reads)
+  {
+    auto state = pending.reads;
+    auto size = read.size;
+    read.on_complete = [state, size](int64_t result)
+    {
+      if (result != static_cast<int64_t>(size))
+      {
+        state->failed = true;
+      }
+      state->remaining--;
+    };
+  }
+
+  item.pending_level = level;
+  item.uploading = true;
+  uploads.push_back(pending);
+  reader->read(std::move(reads));
+}
+
+void vulkan_texture_residency::finish_upload(const upload &pending)
+{
+  auto &item = textures[pending.id];
+  auto vk_device = device->get_device();
+  auto level = pending.level;
+  auto chain_end = static_cast<uint32_t>(item.levels.size());
+  auto num_levels = chain_end - level;
+
+  auto old_image = item.image;
+  auto old_image_memory = item.image_memory;
+  auto old_image_view = item.image_view;
+  auto old_level = item.resident_level;
+  auto copied_level = std::max(level, old_level);
+
+  if (pending.staging_buffer != VK_NULL_HANDLE)
+  {
+    vkUnmapMemory(vk_device, pending.staging_buffer_memory);
+  }
+
+  // a later update may copy its levels into the next image
+  helper::create_image(item.levels[level].width, item.levels[level].height,
+                       item.format, VK_IMAGE_TILING_OPTIMAL,
+                       VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                           | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                           | VK_IMAGE_USAGE_SAMPLED_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, item.image,
+                       item.image_memory, vk_device,
+                       physical_device->get_physical_device(), num_levels);
+  item.image_view = image_view_cache->acquire(
+      helper::get_image_view_create_info(item.image, item.format,
+                                         VK_IMAGE_ASPECT_COLOR_BIT,
+                                         num_levels));
+  used_size += get_chain_size(item, level) - get_chain_size(item, old_level);
+  item.resident_level = level;
+  item.uploading = false;
+
+  VkCommandBufferAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  alloc_info.commandPool = command_pool;
+  alloc_info.commandBufferCount = 1;
+
+  VkCommandBuffer command_buffer;
+  if (vkAllocateCommandBuffers(vk_device, &alloc_info, &command_buffer)
+      != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate texture command buffer!");
+  }
+
+  VkCommandBufferBeginInfo begin_info = {};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(command_buffer, &begin_info);
+
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = item.image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = num_levels;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  if (old_image != VK_NULL_HANDLE && copied_level < chain_end)
+  {
+    // earlier frames sample the old image, it goes back to being sampled
+    // in case later ones still do
+    VkImageMemoryBarrier old_barrier = barrier;
+    old_barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    old_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    old_barrier.image = old_image;
+    old_barrier.subresourceRange.baseMipLevel = copied_level - old_level;
+    old_barrier.subresourceRange.levelCount = chain_end - copied_level;
+    old_barrier.srcAccessMask = 0;
+    old_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &old_barrier);
+
+    std::vector<VkImageCopy> copies(chain_end - copied_level);
+    for (uint32_t i = copied_level; i < chain_end; i++)
+    {
+      auto &copy = copies[i - copied_level];
+      copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      copy.srcSubresource.mipLevel = i - old_level;
+      copy.srcSubresource.baseArrayLayer = 0;
+      copy.srcSubresource.layerCount = 1;
+      copy.srcOffset = { 0, 0, 0 };
+      copy.dstSubresource = copy.srcSubresource;
+      copy.dstSubresource.mipLevel = i - level;
+      copy.dstOffset = { 0, 0, 0 };
+      copy.extent = { item.levels[i].width, item.levels[i].height, 1 };
+    }
+
+    vkCmdCopyImage(command_buffer, old_image,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, item.image,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   static_cast<uint32_t>(copies.size()), copies.data());
+
+    old_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    old_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    old_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    old_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &old_barrier);
+  }
+
+  if (pending.staging_buffer != VK_NULL_HANDLE)
+  {
+    std::vector<VkBufferImageCopy> regions(copied_level - level);
+    for (uint32_t i = level; i < copied_level; i++)
+    {
+      const auto &source = item.levels[i];
+      auto &region = regions[i - level];
+      region.bufferOffset = source.offset - item.levels[level].offset;
+      region.bufferRowLength = 0;
+      region.bufferImageHeight = 0;
+      region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      region.imageSubresource.mipLevel = i - level;
+      region.imageSubresource.baseArrayLayer = 0;
+      region.imageSubresource.layerCount = 1;
+      region.imageOffset = { 0, 0, 0 };
+      region.imageExtent = { source.width, source.height, 1 };
+    }
+
+    vkCmdCopyBufferToImage(command_buffer, pending.staging_buffer,
+                           item.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()),
+                           regions.data());
+  }
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                       0, nullptr, 1, &barrier);
+
+  vkEndCommandBuffer(command_buffer);
+
+  uint64_t signal_value = timeline->next_value();
+  VkSemaphore signal_semaphore = timeline->get_semaphore();
+
+  VkTimelineSemaphoreSubmitInfo timeline_info = {};
+  timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_info.signalSemaphoreValueCount = 1;
+  timeline_info.pSignalSemaphoreValues = &signal_value;
+
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_info;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &signal_semaphore;
+
+  if (vkQueueSubmit(device->get_graphics_queue(), 1, &submit_info,
+                    VK_NULL_HANDLE) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to submit texture upload!");
+  }
+
+  // the copy reads the old image, so it goes with this submission
+  if (old_image != VK_NULL_HANDLE)
+  {
+    retire_image(old_image, old_image_memory, old_image_view, signal_value);
+  }
+
+  auto pool = command_pool;
+  auto staging_buffer = pending.staging_buffer;
+  auto staging_buffer_memory = pending.staging_buffer_memory;
+  deletion_queue->retire(signal_value, [=]()
+  {
+    vkFreeCommandBuffers(vk_device, pool, 1, &command_buffer);
+    vkDestroyBuffer(vk_device, staging_buffer, nullptr);
+    vkFreeMemory(vk_device, staging_buffer_memory, nullptr);
+  });
+}
+
+void vulkan_texture_residency::destroy_staging(const upload &pending) const
+{
+  // nothing was submitted, the reads are all that used it
+  auto vk_device = device->get_device();
+  vkUnmapMemory(vk_device, pending.staging_buffer_memory);
+  vkDestroyBuffer(vk_device, pending.staging_buffer, nullptr);
+  vkFreeMemory(vk_device, pending.staging_buffer_memory, nullptr);
+}
+
+void vulkan_texture_residency::retire_image(VkImage image,
+                                            VkDeviceMemory image_memory,
+                                            VkImageView image_view,
+                                            uint64_t value)
+{
+  auto vk_device = device->get_device();
+  auto view_cache = image_view_cache;
+  deletion_queue->retire(value, [=]()
+  {
+    view_cache->release(image_view);
+    vkDestroyImage(vk_device, image, nullptr);
+    vkFreeMemory(vk_device, image_memory, nullptr);
+  });
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
@@ -0,0 +1,268 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_TEXTURE_RESIDENCY_HPP_
+#define VULKAN_TEXTURE_RESIDENCY_HPP_
+
+#include "vulkan_device.hpp"
+#include "vulkan_deletion_queue.hpp"
+#include "vulkan_image_view_cache.hpp"
+#include "../util/async_reader.hpp"
+#include "../util/mip_chain.hpp"
+
+#include <atomic>
+#include <string>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// Textures whose finer mip levels are only on the GPU while they are
+/// sampled. The small levels at the end of each chain are always resident,
+/// the rest is streamed in and out. Nothing is kept on the CPU, the tail is
+/// uploaded when a texture is added and finer levels are read again from
+/// the asset pack mapping, or from a file through the async reader, straight
+/// into staging memory. Levels that stay resident are copied on the GPU.
+///
+/// Fragment shaders report what they sample through a feedback buffer with
+/// one region per slot (swap chain image). For every texture the region
+/// holds the finest resolution sampled, log2 of texels across the texture
+/// for one texel per pixel, plus one. 0 means the texture was not sampled.
+/// See shaders/texture_feedback.glsl.
+///
+/// A texture's resident levels are one image, which is re-created with more
+/// or fewer levels when the feedback changes, once the reads of the new
+/// levels have completed. The resident levels of all textures stay within
+/// the budget, the largest levels are dropped first when the textures want
+/// more. Replaced images are retired through the deletion queue, which has
+/// to be flushed before this is destroyed.
+///
+class vulkan_texture_residency
+{
+ public:
+  static const uint32_t INVALID_TEXTURE = 0xFFFFFFFF;
+
+  /// Levels at most this many texels wide and high are always resident
+  static const uint32_t RESIDENT_TAIL_SIZE = 128;
+
+  /// Updates a level stays resident after the feedback stopped asking for it
+  static const uint32_t EVICT_DELAY = 120;
+
+  /// Where the levels finer than the tail are read from
+  struct texture_source
+  {
+    /// if set, an asset pack mapping that outlives the residency
+    const uint8_t *mapping;
+    /// else a file read through the async reader, the texture never gets
+    /// finer than its tail if both are empty
+    std::string file_name;
+    /// start of every level finer than the tail, base level first
+    std::vector<uint64_t> offsets;
+  };
+
+  /// @param[in] reader reads the levels of file sources, may be null if
+  ///            there are none
+  /// @param[in] budget bytes of all resident levels, the always resident
+  ///            ones included
+  /// @param[in] max_textures textures registered at once, the size of one
+  ///            feedback region
+  /// @param[in] num_feedback_slots feedback regions, one per submission
+  ///            that may be in flight
+  /// @param[in] max_upload_size bytes streamed in per update, a larger
+  ///            texture goes alone
+  vulkan_texture_residency(
+      std::shared_ptr<vulkan_device> device,
+      std::shared_ptr<vulkan_physical_device> physical_device,
+      std::shared_ptr<vulkan_timeline> timeline,
+      std::shared_ptr<vulkan_deletion_queue> deletion_queue,
+      std::shared_ptr<vulkan_image_view_cache> image_view_cache,
+      std::shared_ptr<util::async_reader> reader, VkDeviceSize budget,
+      uint32_t max_textures, uint32_t num_feedback_slots,
+      VkDeviceSize max_upload_size);
+  ~vulkan_texture_residency();
+  vulkan_texture_residency(vulkan_texture_residency &&) = delete;
+  vulkan_texture_residency(const vulkan_texture_residency &) = delete;
+  vulkan_texture_residency &operator=(const vulkan_texture_residency &) = delete;
+  vulkan_texture_residency &operator=(vulkan_texture_residency &&) = delete;
+
+  /// Registers a texture and submits the upload of its always resident
+  /// levels, its image view can be sampled by every later submission.
+  ///
+  /// @param[in] levels the whole chain as if it was tightly packed, base
+  ///            level first
+  /// @param[in] tail_data the levels from util::mip_chain::get_tail_level
+  ///            with RESIDENT_TAIL_SIZE on, packed from the offset of the
+  ///            first one. It is not kept.
+  ///
+  /// return the id of the texture, its index in the feedback regions
+  uint32_t add(VkFormat format, std::vector<util::mip_level> levels,
+               const std::vector<uint8_t> &tail_data, texture_source source);
+
+  /// Retires the image of id and drops its pending upload, the id is handed
+  /// out again by add
+  void remove(uint32_t id);
+
+  /// Makes the feedback the fragment shaders wrote visible to the host.
+  /// Recorded at the end of every command buffer that writes feedback.
+  void record_feedback_barrier(VkCommandBuffer command_buffer) const;
+
+  /// Reads what the last submission using slot sampled and clears the
+  /// region for the next one. The caller has waited for that submission.
+  void read_feedback(uint32_t slot);
+
+  /// Submits the uploads whose reads have completed, then streams levels in
+  /// and out toward the feedback read so far. Levels of file sources are
+  /// submitted by a later update.
+  ///
+  /// return true if image views were replaced, descriptors using them have
+  /// to be written again
+  bool update();
+
+  VkImageView get_image_view(uint32_t id) const
+  {
+    return textures[id].image_view;
+  }
+  /// the finest level that is resident
+  uint32_t get_resident_level(uint32_t id) const
+  {
+    return textures[id].resident_level;
+  }
+  const VkBuffer get_feedback_buffer() const
+  {
+    return feedback_buffer;
+  }
+  /// bytes of one feedback region, max_textures counters
+  const VkDeviceSize get_feedback_range() const
+  {
+    return sizeof(uint32_t) * max_textures;
+  }
+  const VkDeviceSize get_feedback_offset(uint32_t slot) const
+  {
+    return feedback_stride * slot;
+  }
+  const VkDeviceSize get_budget() const
+  {
+    return budget;
+  }
+  /// bytes of the resident levels, images waiting to be retired excluded
+  const VkDeviceSize get_used_size() const
+  {
+    return used_size;
+  }
+
+ private:
+
+  struct texture
+  {
+    VkFormat format;
+    std::vector<util::mip_level> levels;
+    /// bytes of the whole chain
+    VkDeviceSize size;
+    texture_source source;
+    VkImage image;
+    VkDeviceMemory image_memory;
+    VkImageView image_view;
+    uint32_t resident_level;
+    /// the first always resident level
+    uint32_t tail_level;
+    /// the finest level that can be streamed in
+    uint32_t finest_level;
+    /// the finest level the feedback asked for and the update it did
+    uint32_t wanted_level;
+    uint64_t wanted_update;
+    /// the level of the upload waiting for its reads
+    uint32_t pending_level;
+    bool uploading;
+    bool used;
+  };
+
+  /// Written by the reader's threads
+  struct read_state
+  {
+    std::atomic<uint32_t> remaining;
+    std::atomic<bool> failed;
+  };
+
+  /// A new image for a texture whose levels are being read into staging
+  struct upload
+  {
+    uint32_t id;
+    uint32_t level;
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    std::shared_ptr<read_state> reads;
+    /// the texture was removed meanwhile
+    bool cancelled;
+  };
+
+  mutable VkBuffer feedback_buffer;
+  mutable VkDeviceMemory feedback_buffer_memory;
+  mutable uint8_t *feedback_data;
+  mutable VkDeviceSize feedback_stride;
+  mutable VkCommandPool command_pool;
+
+  std::vector<texture> textures;
+  std::vector<upload> uploads;
+  uint64_t update_count;
+  VkDeviceSize used_size;
+
+  VkDeviceSize budget;
+  uint32_t max_textures;
+  uint32_t num_feedback_slots;
+  VkDeviceSize max_upload_size;
+
+  std::shared_ptr<vulkan_device> device;
+  std::shared_ptr<vulkan_physical_device> physical_device;
+  std::shared_ptr<vulkan_timeline> timeline;
+  std::shared_ptr<vulkan_deletion_queue> deletion_queue;
+  std::shared_ptr<vulkan_image_view_cache> image_view_cache;
+  std::shared_ptr<util::async_reader> reader;
+
+  void initialize() const;
+  void create_feedback_buffer() const;
+  void create_command_pool() const;
+
+  /// bytes of level and every coarser one
+  VkDeviceSize get_chain_size(const texture &item, uint32_t level) const;
+
+  /// Stages the levels of id from level on that are not resident, from
+  /// tail_data, the mapping or the file. The image is replaced at once
+  /// unless the reader has to be waited for.
+  void make_resident(uint32_t id, uint32_t level, const uint8_t *tail_data);
+
+  /// Replaces the image of the texture by one holding the upload's level
+  /// and every coarser one, resident levels are copied from the old image
+  void finish_upload(const upload &pending);
+
+  void destroy_staging(const upload &pending) const;
+
+  /// Retires an image and its view at value
+  void retire_image(VkImage image, VkDeviceMemory image_memory,
+                    VkImageView image_view, uint64_t value);
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_TEXTURE_RESIDENCY_HPP_
@@ -0,0 +1,117 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#include "vulkan_timeline.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+vulkan_timeline::vulkan_timeline(std::shared_ptr<vulkan_device> device)
+    : semaphore(VK_NULL_HANDLE),
+      last_value(0),
+      completed_value(0),
+      device(device)
+{
+  initialize();
+}
+
+vulkan_timeline::~vulkan_timeline()
+{
+  vkDestroySemaphore(device->get_device(), semaphore, nullptr);
+}
+
+uint64_t vulkan_timeline::next_value()
+{
+  return ++last_value;
+}
+
+uint64_t vulkan_timeline::get_completed_value() const
+{
+  if (completed_value < last_value)
+  {
+    if (vkGetSemaphoreCounterValue(device->get_device(), semaphore,
+                                   &completed_value) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to query timeline semaphore!");
+    }
+  }
+
+  return completed_value;
+}
+
+bool vulkan_timeline::is_complete(uint64_t value) const
+{
+  return value <= completed_value || value <= get_completed_value();
+}
+
+void vulkan_timeline::wait(uint64_t value) const
+{
+  if (value <= completed_value)
+  {
+    return;
+  }
+
+  VkSemaphoreWaitInfo wait_info = {};
+  wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &semaphore;
+  wait_info.pValues = &value;
+
+  if (vkWaitSemaphores(device->get_device(), &wait_info,
+                       std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to wait for timeline semaphore!");
+  }
+
+  completed_value = std::max(completed_value, value);
+}
+
+void vulkan_timeline::wait_all() const
+{
+  wait(last_value);
+}
+
+void vulkan_timeline::initialize() const
+{
+  VkSemaphoreTypeCreateInfo type_info = {};
+  type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  type_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_info = {};
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_info.pNext = &type_info;
+
+  if (vkCreateSemaphore(device->get_device(), &semaphore_info, nullptr,
+                        &semaphore) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create timeline semaphore!");
+  }
+}
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
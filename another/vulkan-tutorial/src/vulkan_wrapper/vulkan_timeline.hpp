@@ -0,0 +1,86 @@
+/// Copyright (c) 2018 Tobias Andersson (shada).
+///
+/// SPDX-License-Identifier: MIT
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the "Software"), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in all
+/// copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+/// SOFTWARE.
+
+#ifndef VULKAN_TIMELINE_HPP_
+#define VULKAN_TIMELINE_HPP_
+
+#include "vulkan_device.hpp"
+
+namespace tobi_engine
+{
+namespace vulkan_wrapper
+{
+
+///
+/// A single timeline semaphore tracking all work submitted to the GPU.
+/// Every submission signals the next value on the timeline, and the CPU waits
+/// for exactly the value it needs instead of a fence per frame.
+class vulkan_timeline
+{
+ public:
+  vulkan_timeline(std::shared_ptr<vulkan_device> device);
+  ~vulkan_timeline();
+  vulkan_timeline(vulkan_timeline &&) = delete;
+  vulkan_timeline(const vulkan_timeline &) = delete;
+  vulkan_timeline &operator=(const vulkan_timeline &) = delete;
+  vulkan_timeline &operator=(vulkan_timeline &&) = delete;
+
+  /// Reserves the value the next submission will signal.
+  uint64_t next_value();
+
+  /// Returns the highest value the GPU has reached so far.
+  uint64_t get_completed_value() const;
+
+  bool is_complete(uint64_t value) const;
+
+  /// Blocks until the GPU has reached value. Returns immediately if it
+  /// already has, without calling into the driver.
+  void wait(uint64_t value) const;
+
+  /// Blocks until every value handed out so far has been reached.
+  void wait_all() const;
+
+  const VkSemaphore get_semaphore() const
+  {
+    return semaphore;
+  }
+
+  const uint64_t get_last_value() const
+  {
+    return last_value;
+  }
+
+ private:
+
+  mutable VkSemaphore semaphore;
+  uint64_t last_value;
+  mutable uint64_t completed_value;
+
+  std::shared_ptr<vulkan_device> device;
+
+  void initialize() const;
+};
+
+}  // namespace vulkan_wrapper
+}  // namespace tobi_engine
+
+#endif // VULKAN_TIMELINE_HPP_